@@ -0,0 +1,8 @@
+#ifndef EXAMPLES_C_APP_HELLOWORLD_H
+#define EXAMPLES_C_APP_HELLOWORLD_H
+
+/* This generated file contains includes for project dependencies */
+#include "examples-c-app_helloworld/bake_config.h"
+
+#endif
+
@@ -2,6 +2,7 @@
 #define BAKE3_BUILD_COMPONENTS_H
 
 #include "bake/model.h"
+#include "bake/os.h"
 
 typedef struct BakeBuildRequest {
     const char *mode;
@@ -12,6 +13,7 @@ typedef struct BakeBuildRequest {
 typedef struct BakeBuildResult {
     int32_t status;
     char *artefact;
+    bake_process_usage_t usage; /* of compiling the project, see bake_usage_update */
 } BakeBuildResult;
 
 extern ECS_COMPONENT_DECLARE(BakeBuildRequest);
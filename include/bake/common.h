@@ -29,7 +29,23 @@
 
 #define BAKE_UNUSED(x) (void)(x)
 
+struct bake_process_stdio_t;
+struct bake_process_result_t;
+struct bake_strlist_t;
+
 int bake_run_command(const char *cmd, bool log_command);
+int bake_run_argv(
+    const char *const *argv,
+    const struct bake_process_stdio_t *stdio_cfg,
+    bool log_command);
+/* Logs why a command failed to start or run. Returns 0 if it succeeded. */
+int bake_run_check_result(
+    const char *const *argv,
+    int rc,
+    const struct bake_process_result_t *result);
+char* bake_argv_str(const char *const *argv);
+/* Appends the arguments of a command line fragment, split like commands are. */
+int bake_strlist_append_args(struct bake_strlist_t *list, const char *line);
 char* bake_shell_quote_arg(const char *arg);
 char* bake_text_replace(const char *input, const char *needle, const char *replacement);
 
@@ -41,4 +57,8 @@ bool bake_char_is_space(char ch);
 char* bake_project_id_as_macro(const char *id);
 char* bake_project_id_base(const char *id);
 
+/* FNV-1a. Pass BAKE_HASH_INIT as seed, or a previous result to chain. */
+#define BAKE_HASH_INIT (14695981039346656037ULL)
+uint64_t bake_hash(uint64_t seed, const void *data, size_t len);
+
 #endif
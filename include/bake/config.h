@@ -12,6 +12,19 @@ typedef enum bake_project_kind_t {
     BAKE_PROJECT_TEMPLATE
 } bake_project_kind_t;
 
+typedef enum bake_archive_kind_t {
+    BAKE_ARCHIVE_STATIC = 0, /* Static library with copies of the objects */
+    BAKE_ARCHIVE_THIN,       /* Static library that references the objects */
+    BAKE_ARCHIVE_PRELINK     /* Relocatable object prelinked from the objects */
+} bake_archive_kind_t;
+
+/* Where debug builds put their debug info, flags can be combined. */
+typedef enum bake_debug_info_t {
+    BAKE_DEBUG_INFO_FULL = 0,            /* In objects and binaries */
+    BAKE_DEBUG_INFO_SPLIT = 1 << 0,      /* In .dwo files next to the objects */
+    BAKE_DEBUG_INFO_COMPRESSED = 1 << 1  /* Compressed in objects and binaries */
+} bake_debug_info_t;
+
 typedef enum bake_compiler_kind_t {
     BAKE_COMPILER_GCC = 0,
     BAKE_COMPILER_CLANG,
@@ -77,11 +90,14 @@ typedef struct bake_lang_cfg_t {
     bake_strlist_t links;
     bake_strlist_t include_paths;
     bake_strlist_t embed;
+    bake_strlist_t unity_exclude;
     char *c_standard;
     char *cpp_standard;
+    char *precompile_header_file; /* Header to precompile instead of the main header */
     bool static_lib;
     bool export_symbols;
     bool precompile_header;
+    int32_t unity; /* Number of unity batches, 0 compiles sources one by one */
 } bake_lang_cfg_t;
 
 struct bake_project_cfg_t {
@@ -95,6 +111,13 @@ struct bake_project_cfg_t {
 
     bool private_project;
     bool standalone;
+    int32_t standalone_units; /* Source units per standalone dependency, <= 1 is one file */
+    bool lean_config; /* bake_config.h leaves dependency headers to forwarding headers */
+    bool include_root; /* Search includes in one directory of symlinks */
+    bake_archive_kind_t archive; /* What a package links its objects into */
+    bool shared_library; /* Link a package as shared library */
+    char *linker; /* Linker for -fuse-ld, "fast" picks the fastest one found */
+    bake_debug_info_t debug_info; /* Debug info strategy of modes with -g */
     bake_amalgamate_list_t amalgamate;
 
     bake_strlist_t use;
@@ -122,7 +145,10 @@ struct bake_project_cfg_t {
 const char* bake_project_kind_str(bake_project_kind_t kind);
 bool bake_project_kind_has_artefact(bake_project_kind_t kind);
 bake_project_kind_t bake_project_kind_parse(const char *value);
+const char* bake_archive_kind_str(bake_archive_kind_t kind);
+int bake_debug_info_parse(const char *value, bake_debug_info_t *out);
 char* bake_project_cfg_artefact_name(const bake_project_cfg_t *cfg);
+bool bake_project_cfg_shared_library(const bake_project_cfg_t *cfg);
 
 void bake_rule_list_init(bake_rule_list_t *list);
 void bake_rule_list_fini(bake_rule_list_t *list);
@@ -11,14 +11,22 @@ typedef struct bake_options_t {
     const char *cwd;
     const char *cc;
     const char *cxx;
+    const char *linker; /* Overrides the linker of projects */
+    const char *debug_info; /* Overrides the debug info strategy of projects */
     const char *run_prefix;
     bool recursive;
     bool standalone;
     bool strict;
     bool trace;
+    bool include_report; /* Report which units include headers of which dependency */
+    bool include_root; /* Enables include roots for all projects */
+    bool usage_report; /* Report the CPU time and memory of the costliest units */
+    bool replay_warnings; /* Print stored diagnostics of up-to-date units */
+    bool keep_going; /* Continue building after a failure where possible */
     bool setup_local;
     bool local_env;
     int32_t jobs;
+    int32_t unity; /* Overrides lang unity when > 0, -1 disables unity builds */
     int run_argc;
     const char **run_argv;
 } bake_options_t;
@@ -30,6 +38,10 @@ typedef struct bake_context_t {
     bake_compiler_kind_t compiler_kind;
     bool prepare_bundles;
     int32_t thread_count;
+    bake_strlist_t linkers_found; /* probe keys of linkers that link */
+    bake_strlist_t linkers_missing;
+    bake_strlist_t linkers_warned; /* unavailable linkers that were reported */
+    bool linkers_loaded; /* probe results of earlier runs are loaded */
 } bake_context_t;
 
 const char* bake_effective_mode(const char *mode);
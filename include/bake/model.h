@@ -6,6 +6,7 @@
 typedef struct BakeProject {
     bake_project_cfg_t *cfg;
     bool external;
+    uint32_t revision; /* Bumped whenever the project cfg is (re)assigned */
 } BakeProject;
 
 typedef struct BakeResolvedDeps {
@@ -15,6 +16,7 @@ typedef struct BakeResolvedDeps {
     bake_strlist_t libs;
     bake_strlist_t ldflags;
     bake_strlist_t build_libpaths;
+    uint64_t key; /* Hash of the inputs the closure was computed from */
 } BakeResolvedDeps;
 
 typedef struct BakeDriver {
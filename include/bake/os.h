@@ -9,10 +9,24 @@ typedef struct bake_dir_entry_t {
     bool is_dir;
 } bake_dir_entry_t;
 
+/* Resources used by a process, as far as the platform reports them. Block I/O
+ * counts read and write operations on Windows, which has no context switch
+ * counts. */
+typedef struct bake_process_usage_t {
+    int64_t user_us;        /* user CPU time, microseconds */
+    int64_t sys_us;         /* system CPU time, microseconds */
+    int64_t max_rss_kb;     /* peak resident set size */
+    int64_t in_blocks;
+    int64_t out_blocks;
+    int64_t vol_switches;   /* voluntary context switches */
+    int64_t invol_switches;
+} bake_process_usage_t;
+
 typedef struct bake_process_result_t {
     int exit_code;
     int term_signal;
     bool interrupted;
+    bake_process_usage_t usage;
 } bake_process_result_t;
 
 typedef struct bake_process_stdio_t {
@@ -24,6 +38,14 @@ typedef struct bake_process_stdio_t {
     bool stderr_to_stdout;
 } bake_process_stdio_t;
 
+/* Read-only view of a file's contents. Large files are memory mapped, small
+ * files are read into a buffer. data is not NUL-terminated. */
+typedef struct bake_file_map_t {
+    const char *data;
+    size_t len;
+    bool mapped;
+} bake_file_map_t;
+
 typedef int (*bake_dir_walk_cb)(const bake_dir_entry_t *entry, void *ctx);
 
 int bake_dir_list(const char *path, bake_dir_entry_t **entries_out, int32_t *count_out);
@@ -57,6 +79,7 @@ int bake_os_unsetenv(const char *name);
 char* bake_os_home_path(void);
 char* bake_os_executable_path(void);
 int32_t bake_os_cpu_count(void);
+bool bake_os_stderr_is_tty(void);
 int32_t bake_host_threads(void);
 
 const char* bake_host_os(void);
@@ -82,10 +105,15 @@ int bake_os_rmdir(const char *path);
 
 char* bake_file_read(const char *path, size_t *len_out);
 char* bake_file_read_trimmed(const char *path);
+int bake_file_map(const char *path, bake_file_map_t *map_out);
+void bake_file_unmap(bake_file_map_t *map);
+bool bake_file_equals(const char *path, const char *content, size_t len);
 int bake_file_write(const char *path, const char *content);
 int bake_os_mkdirs(const char *path);
 int bake_os_rmtree(const char *path);
 int bake_os_file_copy(const char *src, const char *dst);
+int bake_os_file_link(const char *src, const char *dst); /* hard link, copy as fallback */
+int bake_os_symlink(const char *target, const char *path);
 int bake_file_sync_mode(const char *src, const char *dst);
 char* bake_path_dirname(const char *path);
 char* bake_path_basename(const char *path);
@@ -97,4 +125,33 @@ int bake_proc_run(
     bake_process_result_t *result);
 int bake_proc_run_argv(const char *const *argv, bake_process_result_t *result);
 
+/* Runs processes concurrently from a single thread. Jobs are started with
+ * bake_procs_spawn and returned by bake_procs_wait in the order they exit.
+ * With capture, stdout and stderr of a job are collected into one buffer
+ * instead of being written to the terminal. Buffers are reused for later jobs
+ * once they're released with bake_procs_release. */
+typedef struct bake_procs_t bake_procs_t;
+
+typedef struct bake_proc_done_t {
+    void *job;              /* as passed to bake_procs_spawn */
+    bake_process_result_t result;
+    bool cancelled;         /* terminated by bake_procs_cancel, output is partial */
+    char *output;           /* captured output, NULL when empty */
+    size_t output_len;
+    size_t output_cap;
+} bake_proc_done_t;
+
+bake_procs_t* bake_procs_new(void);
+void bake_procs_free(bake_procs_t *procs); /* kills jobs that still run */
+int bake_procs_spawn(
+    bake_procs_t *procs,
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    bool capture,
+    void *job);
+int32_t bake_procs_count(const bake_procs_t *procs);
+int bake_procs_wait(bake_procs_t *procs, bake_proc_done_t *done_out);
+void bake_procs_release(bake_procs_t *procs, bake_proc_done_t *done);
+void bake_procs_cancel(bake_procs_t *procs);
+
 #endif
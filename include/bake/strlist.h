@@ -2,6 +2,7 @@
 #define BAKE3_STRLIST_H
 
 #include "bake/common.h"
+#include <flecs.h>
 
 typedef struct bake_strlist_t {
     char **items;
@@ -19,4 +20,35 @@ int bake_strlist_merge_unique(bake_strlist_t *dst, const bake_strlist_t *src);
 int bake_strlist_copy(bake_strlist_t *dst, const bake_strlist_t *src);
 int bake_strlist_append_unique(bake_strlist_t *list, const char *value);
 
+/* Interned strings are unique per value and live until bake_intern_fini, so
+ * they can be compared and hashed by pointer. Not thread safe. */
+const char* bake_intern(const char *value);
+void bake_intern_fini(void);
+
+/* Private string table with the same guarantees as bake_intern, for code that
+ * runs on worker threads. Strings live until bake_strtable_fini. */
+typedef struct bake_strtable_t {
+    struct bake_strtable_slot_t *slots;
+    int32_t count;
+    int32_t capacity;
+} bake_strtable_t;
+
+const char* bake_strtable_intern(bake_strtable_t *table, const char *value);
+void bake_strtable_fini(bake_strtable_t *table);
+
+/* Insertion-ordered string list with a hashed index for O(1) membership.
+ * The list owns its items like a regular bake_strlist_t. bake_strset_take
+ * moves the list out and finalizes the set. */
+typedef struct bake_strset_t {
+    bake_strlist_t list;
+    ecs_map_t index;
+} bake_strset_t;
+
+void bake_strset_init(bake_strset_t *set);
+void bake_strset_fini(bake_strset_t *set);
+bool bake_strset_contains(const bake_strset_t *set, const char *value);
+int bake_strset_add(bake_strset_t *set, const char *value);
+int bake_strset_merge(bake_strset_t *set, const bake_strlist_t *src);
+void bake_strset_take(bake_strset_t *set, bake_strlist_t *dst);
+
 #endif
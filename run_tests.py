@@ -386,6 +386,1111 @@ class BakeTests(unittest.TestCase):
         self.assertNotIn("EXAMPLES_FEATURE_REMOVED", regenerated)
         self.assertEqual(regenerated, stripped)
 
+    def test_amalgamate_manifest_tracks_input_changes(self) -> None:
+        # Amalgamation is skipped when the manifest in the build root shows
+        # that no input changed; editing an included header must still
+        # regenerate the output.
+        target = "test/projects/c/pkg_amalgamate_disable"
+        project = self.repo_root / target
+        distr = project / "distr"
+        if distr.exists():
+            shutil.rmtree(distr)
+        self.bake(["build", target])
+
+        manifests = list((project / ".bake").glob("*/amalgamate/mini.*.manifest"))
+        self.assertEqual(len(manifests), 1)
+        manifest = manifests[0].read_text()
+        self.assertIn("disable EXAMPLES_FLAG_OFF", manifest)
+        self.assertIn("constants.h", manifest)
+
+        header = project / "include" / "detail" / "constants.h"
+        original = header.read_text()
+        try:
+            header.write_text(original + "\n#define EXAMPLES_MANIFEST_PROBE (1)\n")
+            self.bake(["build", target])
+            self.assertIn("EXAMPLES_MANIFEST_PROBE", (distr / "mini.h").read_text())
+        finally:
+            header.write_text(original)
+
+        self.bake(["build", target])
+        self.assertNotIn("EXAMPLES_MANIFEST_PROBE", (distr / "mini.h").read_text())
+
+    def test_amalgamate_preserves_lines_longer_than_read_buffer(self) -> None:
+        # Regression: inputs used to be read with a fixed 4096 byte line
+        # buffer, so the tail of a longer line was parsed as a line of its
+        # own and a disabled "#define" in it was stripped mid-line.
+        target = "test/projects/c/pkg_amalgamate_disable"
+        project = self.repo_root / target
+        distr = project / "distr"
+        # The old buffer split this line right before the "#define".
+        long_line = "// examples_long_line " + "x" * 4073 + "#define EXAMPLES_FLAG_OFF"
+
+        header = project / "include" / "detail" / "constants.h"
+        original = header.read_text()
+        try:
+            header.write_text(original + "\n" + long_line + "\n")
+            self.bake(["build", target])
+            self.assertIn(long_line, (distr / "mini.h").read_text())
+        finally:
+            header.write_text(original)
+
+        self.bake(["build", target])
+        self.assertNotIn("examples_long_line", (distr / "mini.h").read_text())
+
+    @unittest.skipIf(platform.system() == "Windows", "standalone deps are copied instead of linked on Windows")
+    def test_standalone_apps_share_cached_dependency_amalgamation(self) -> None:
+        # Standalone apps link their deps/ amalgamation from one copy in
+        # BAKE_HOME, generated once per dependency source snapshot.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"standalone_cache_{stamp}"
+        dep_name = "examples_c_pkg_helloworld.c"
+        try:
+            shutil.copytree(
+                self.repo_root / "test" / "projects" / "c" / "pkg_helloworld",
+                tmp_root / "pkg_helloworld",
+                ignore=shutil.ignore_patterns(".bake"),
+            )
+            for app in ("app_a", "app_b"):
+                (tmp_root / app / "src").mkdir(parents=True)
+                (tmp_root / app / "project.json").write_text(
+                    "{\n"
+                    f"    \"id\": \"examples.c.standalone_{app}\",\n"
+                    "    \"type\": \"application\",\n"
+                    "    \"value\": {\"use\": [\"examples.c.pkg_helloworld\"]}\n"
+                    "}\n"
+                )
+                (tmp_root / app / "src" / "main.c").write_text("int main(void) { return 0; }\n")
+
+            self.bake(["--standalone", "build", str(tmp_root)])
+
+            cache = self.bake_home / "cache" / "amalgamate" / "examples.c.pkg_helloworld"
+            snapshots = list(cache.iterdir())
+            self.assertEqual(len(snapshots), 1)
+            cached = snapshots[0] / dep_name
+            for app in ("app_a", "app_b"):
+                self.assertTrue(os.path.samefile(cached, tmp_root / app / "deps" / dep_name))
+
+            # A dependency change produces a new snapshot that replaces the old one.
+            with open(tmp_root / "pkg_helloworld" / "src" / "main.c", "a") as f:
+                f.write("\nint examples_standalone_probe;\n")
+            self.bake(["--standalone", "build", str(tmp_root)])
+
+            snapshots = list(cache.iterdir())
+            self.assertEqual(len(snapshots), 1)
+            self.assertIn(
+                "examples_standalone_probe",
+                (tmp_root / "app_a" / "deps" / dep_name).read_text(),
+            )
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_standalone_apps_share_dependency_objects(self) -> None:
+        # Standalone apps that vendor the same dependency snapshot with the
+        # same flags compile it once and reuse the cached object.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"standalone_objs_{stamp}"
+        obj_name = "examples_c_pkg_helloworld.c.o"
+        try:
+            shutil.copytree(
+                self.repo_root / "test" / "projects" / "c" / "pkg_helloworld",
+                tmp_root / "pkg_helloworld",
+                ignore=shutil.ignore_patterns(".bake"),
+            )
+            for app in ("app_a", "app_b"):
+                (tmp_root / app / "src").mkdir(parents=True)
+                (tmp_root / app / "project.json").write_text(
+                    "{\n"
+                    f"    \"id\": \"examples.c.objs_{app}\",\n"
+                    "    \"type\": \"application\",\n"
+                    "    \"value\": {\"use\": [\"examples.c.pkg_helloworld\"]}\n"
+                    "}\n"
+                )
+                (tmp_root / app / "src" / "main.c").write_text(
+                    "#include <examples_c_pkg_helloworld.h>\n"
+                    "int main(void) { return 0; }\n"
+                )
+
+            output = self.bake(["--standalone", "--trace", "build", str(tmp_root)])
+            self.assertEqual(output.count("reusing"), 1)
+
+            cache = self.bake_home / "cache" / "amalgamate" / "examples.c.pkg_helloworld"
+            objs = list(cache.glob("*/obj/*.o"))
+            self.assertEqual(len(objs), 1)
+            for app in ("app_a", "app_b"):
+                app_objs = list((tmp_root / app / ".bake").rglob(obj_name))
+                self.assertEqual(len(app_objs), 1)
+                self.assertEqual(app_objs[0].read_bytes(), objs[0].read_bytes())
+                self.bake(["--standalone", "run", str(tmp_root / app)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_standalone_units_split_dependency_sources(self) -> None:
+        # "standalone-units" splits a dependency's amalgamated sources into
+        # several files in deps/ that are compiled as separate units.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"standalone_units_{stamp}"
+        pkg = tmp_root / "pkg"
+        app = tmp_root / "app"
+        try:
+            (pkg / "src").mkdir(parents=True)
+            (pkg / "include").mkdir(parents=True)
+            (app / "src").mkdir(parents=True)
+            (pkg / "project.json").write_text(
+                "{\"id\": \"examples.c.split_pkg\", \"type\": \"package\"}\n"
+            )
+            (pkg / "include" / "examples_c_split_pkg.h").write_text(
+                "int split_a(void);\nint split_b(void);\nint split_c(void);\n"
+            )
+            for name in ("a", "b", "c"):
+                (pkg / "src" / f"{name}.c").write_text(
+                    "#include <examples_c_split_pkg.h>\n"
+                    f"int split_{name}(void) {{ return 1; }}\n"
+                )
+            (app / "project.json").write_text(
+                "{\n"
+                "    \"id\": \"examples.c.split_app\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"value\": {\"use\": [\"examples.c.split_pkg\"], \"standalone-units\": 2}\n"
+                "}\n"
+            )
+            (app / "src" / "main.c").write_text(
+                "#include <examples_c_split_pkg.h>\n"
+                "int main(void) { return split_a() + split_b() + split_c() - 3; }\n"
+            )
+
+            self.bake(["--standalone", "build", str(tmp_root)])
+
+            deps = sorted(p.name for p in (app / "deps").glob("*.c"))
+            self.assertEqual(deps, ["examples_c_split_pkg_1.c", "examples_c_split_pkg_2.c"])
+            self.bake(["--standalone", "run", str(app)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_unity_build_recompiles_only_changed_batches(self) -> None:
+        # "unity" groups sources into batches in generated/unity, and only the
+        # batch that includes a changed source is recompiled.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"unity_{stamp}"
+        src = tmp_root / "src"
+        try:
+            src.mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                "    \"id\": \"examples.c.unity_app\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"lang.c\": {\"unity\": 2, \"unity-exclude\": [\"src/private.c\"]}\n"
+                "}\n"
+            )
+            for i in range(1, 5):
+                (src / f"f{i}.c").write_text(f"int unity_f{i}(void) {{ return {i}; }}\n")
+            # Both files define the same static function, so one is excluded.
+            (src / "private.c").write_text(
+                "static int helper(void) { return 0; }\n"
+                "int unity_private(void) { return helper(); }\n"
+            )
+            (src / "main.c").write_text(
+                "int unity_f1(void); int unity_private(void);\n"
+                "static int helper(void) { return 1; }\n"
+                "int main(void) { return unity_f1() - helper() + unity_private(); }\n"
+            )
+
+            output = self.bake(["build", str(tmp_root)])
+            self.assertIn("unity_c_1.c", output)
+            self.assertIn("unity_c_2.c", output)
+            self.assertIn("private.c", output)
+            self.bake(["run", str(tmp_root)])
+
+            batches = list((tmp_root / ".bake").rglob("unity_c_*.c"))
+            self.assertEqual(len(batches), 2)
+            member = next(b for b in batches if "f2.c" in b.read_text())
+            time.sleep(1.1)
+            (src / "f2.c").write_text("int unity_f2(void) { return 22; }\n")
+            output = self.bake(["build", str(tmp_root)])
+            self.assertIn(member.name, output)
+            self.assertEqual(output.count("unity_c_"), 1)
+            self.assertNotIn("private.c", output)
+
+            output = self.bake(["--unity", "0", "build", str(tmp_root)])
+            self.assertIn("f2.c", output)
+            self.assertEqual(list((tmp_root / ".bake").rglob("unity_c_*.c")), [])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_precompiled_header_rebuilds_with_its_inputs(self) -> None:
+        # The main header is precompiled into generated/pch, and rebuilt with
+        # the sources that use it when a header it includes changes.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"pch_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "include" / "examples_c_pch_app").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\"id\": \"examples.c.pch_app\", \"type\": \"application\"}\n"
+            )
+            (tmp_root / "include" / "examples_c_pch_app.h").write_text(
+                "#ifndef EXAMPLES_C_PCH_APP_H\n"
+                "#define EXAMPLES_C_PCH_APP_H\n"
+                "#include \"examples_c_pch_app/value.h\"\n"
+                "int pch_value(void);\n"
+                "#endif\n"
+            )
+            value_h = tmp_root / "include" / "examples_c_pch_app" / "value.h"
+            value_h.write_text("#define PCH_VALUE 1\n")
+            (tmp_root / "src" / "value.c").write_text(
+                "#include \"examples_c_pch_app.h\"\n"
+                "int pch_value(void) { return PCH_VALUE; }\n"
+            )
+            (tmp_root / "src" / "main.c").write_text(
+                "#include \"examples_c_pch_app.h\"\n"
+                "int main(void) { return pch_value() != PCH_VALUE; }\n"
+            )
+
+            self.bake(["build", str(tmp_root)])
+            self.assertEqual(len(list((tmp_root / ".bake").rglob("examples_c_pch_app.h.gch"))), 1)
+            self.bake(["run", str(tmp_root)])
+
+            output = self.bake(["build", str(tmp_root)])
+            self.assertNotIn("main.c", output)
+
+            time.sleep(1.1)
+            value_h.write_text("#define PCH_VALUE 2\n")
+            output = self.bake(["build", str(tmp_root)])
+            self.assertIn("examples_c_pch_app.h", output)
+            self.assertIn("value.c", output)
+            self.assertIn("main.c", output)
+            self.bake(["run", str(tmp_root)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "wraps the compiler in a shell script")
+    def test_clang_precompiled_header_skips_sources_with_leading_macros(self) -> None:
+        # Clang force-includes a precompiled header, so only sources that start
+        # with an include of the header get it. Others define macros the header
+        # depends on first. Without clang, gcc stands in for it, and gets the
+        # precompiled header as a forced include of the header.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"clang_pch_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "include").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\"id\": \"examples.c.clang_pch_app\", \"type\": \"application\"}\n"
+            )
+            (tmp_root / "include" / "examples_c_clang_pch_app.h").write_text(
+                "#ifndef EXAMPLES_C_CLANG_PCH_APP_H\n"
+                "#define EXAMPLES_C_CLANG_PCH_APP_H\n"
+                "#ifdef CLANG_PCH_FEATURE\n"
+                "#define CLANG_PCH_VALUE 0\n"
+                "#else\n"
+                "#define CLANG_PCH_VALUE 1\n"
+                "#endif\n"
+                "int clang_pch_value(void);\n"
+                "#endif\n"
+            )
+            (tmp_root / "src" / "value.c").write_text(
+                "/* includes the header first */\n"
+                "#include \"examples_c_clang_pch_app.h\"\n"
+                "int clang_pch_value(void) { return 0; }\n"
+            )
+            (tmp_root / "src" / "main.c").write_text(
+                "#define CLANG_PCH_FEATURE\n"
+                "#include \"examples_c_clang_pch_app.h\"\n"
+                "int main(void) { return CLANG_PCH_VALUE + clang_pch_value(); }\n"
+            )
+
+            compiler = shutil.which("clang")
+            if not compiler:
+                compiler = str(tmp_root / "bin" / "clang")
+                (tmp_root / "bin").mkdir()
+                Path(compiler).write_text(
+                    "#!/bin/sh\n"
+                    "for arg; do\n"
+                    "  shift\n"
+                    "  if [ \"$pch\" = 1 ]; then set -- \"$@\" \"${arg%.pch}\"; pch=; continue; fi\n"
+                    "  if [ \"$arg\" = -include-pch ]; then set -- \"$@\" -include; pch=1; continue; fi\n"
+                    "  set -- \"$@\" \"$arg\"\n"
+                    "done\n"
+                    "exec gcc \"$@\"\n"
+                )
+                Path(compiler).chmod(0o755)
+
+            output = self.strip_ansi(
+                self.bake(["--cc", compiler, "--trace", "build", str(tmp_root)])
+            )
+            compiles = [l for l in output.splitlines() if " -c " in l]
+            value_c = next(l for l in compiles if "value.c" in l)
+            main_c = next(l for l in compiles if "main.c" in l)
+            self.assertIn("-include-pch", value_c)
+            self.assertNotIn("-include-pch", main_c)
+            self.bake(["--cc", compiler, "run", str(tmp_root)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_dependents_use_published_precompiled_header(self) -> None:
+        # A package publishes its main header precompiled to BAKE_HOME, and
+        # dependents search it before the package includes, rebuilding when
+        # the header changes. Sources that don't include it are unaffected.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"shared_pch_{stamp}"
+        pkg_id = f"examples.c.shared_pch_{stamp}"
+        pkg_macro = pkg_id.replace(".", "_")
+        app_id = f"examples.c.shared_pch_app_{stamp}"
+        try:
+            (tmp_root / "pkg" / "src").mkdir(parents=True)
+            (tmp_root / "pkg" / "include").mkdir(parents=True)
+            (tmp_root / "pkg" / "project.json").write_text(
+                f"{{\"id\": \"{pkg_id}\", \"type\": \"package\"}}\n"
+            )
+            pkg_h = tmp_root / "pkg" / "include" / f"{pkg_macro}.h"
+            pkg_h.write_text(
+                "#ifndef SHARED_PCH_H\n"
+                "#define SHARED_PCH_H\n"
+                "#define SHARED_PCH_VALUE 1\n"
+                "int shared_pch_value(void);\n"
+                "#endif\n"
+            )
+            (tmp_root / "pkg" / "src" / "value.c").write_text(
+                f"#include <{pkg_macro}.h>\n"
+                "int shared_pch_value(void) { return SHARED_PCH_VALUE; }\n"
+            )
+            (tmp_root / "app" / "src").mkdir(parents=True)
+            (tmp_root / "app" / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"{app_id}\",\n"
+                "    \"type\": \"application\",\n"
+                f"    \"value\": {{\"use\": [\"{pkg_id}\"]}}\n"
+                "}\n"
+            )
+            (tmp_root / "app" / "src" / "main.c").write_text(
+                f"#include <{pkg_macro}.h>\n"
+                "int helper(void);\n"
+                "int main(void) { return shared_pch_value() + helper() != SHARED_PCH_VALUE; }\n"
+            )
+            (tmp_root / "app" / "src" / "helper.c").write_text(
+                "static int shared_pch_value(void) { return 0; }\n"
+                "int helper(void) { return shared_pch_value(); }\n"
+            )
+
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            stub = self.bake_home / "pch" / pkg_id / "c" / f"{pkg_macro}.h"
+            self.assertEqual(len(list(stub.with_name(stub.name + ".gch").iterdir())), 1)
+            self.assertIn(f"-I{stub.parent} ", output)
+            self.assertNotIn("-include ", output)
+            # Headers read from a precompiled header are left out of depfiles.
+            main_dep = next((tmp_root / "app" / ".bake").rglob("main.c.o.d")).read_text()
+            self.assertNotIn(f"{pkg_macro}.h", main_dep)
+            self.bake(["run", str(tmp_root / "app")])
+
+            output = self.bake(["build", str(tmp_root)])
+            self.assertNotIn("main.c", output)
+
+            time.sleep(1.1)
+            pkg_h.write_text(pkg_h.read_text().replace("VALUE 1", "VALUE 2"))
+            output = self.bake(["build", str(tmp_root)])
+            self.assertIn("main.c", output)
+            self.assertEqual(len(list(stub.with_name(stub.name + ".gch").iterdir())), 1)
+            self.bake(["run", str(tmp_root / "app")])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+            shutil.rmtree(self.bake_home / "pch" / pkg_id, ignore_errors=True)
+
+    def test_lean_config_header_and_include_report(self) -> None:
+        # In lean mode bake_config.h leaves dependency headers to forwarding
+        # headers, and the include report shows which units use which one.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"lean_config_{stamp}"
+        try:
+            for dep in ("dep_a", "dep_b"):
+                dep_id = f"examples.c.lean_{dep}_{stamp}"
+                dep_macro = dep_id.replace(".", "_")
+                (tmp_root / dep / "src").mkdir(parents=True)
+                (tmp_root / dep / "include").mkdir(parents=True)
+                (tmp_root / dep / "project.json").write_text(
+                    f"{{\"id\": \"{dep_id}\", \"type\": \"package\"}}\n"
+                )
+                (tmp_root / dep / "include" / f"{dep_macro}.h").write_text(
+                    f"int {dep}_value(void);\n"
+                )
+                (tmp_root / dep / "src" / "value.c").write_text(
+                    f"int {dep}_value(void) {{ return 0; }}\n"
+                )
+
+            app_id = f"examples.c.lean_app_{stamp}"
+            app_dash = app_id.replace(".", "-")
+            dep_a_macro = f"examples_c_lean_dep_a_{stamp}"
+            app = tmp_root / "app"
+            (app / "src").mkdir(parents=True)
+            (app / "include").mkdir(parents=True)
+            (app / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"{app_id}\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"value\": {\n"
+                "        \"lean-config\": true,\n"
+                f"        \"use\": [\"examples.c.lean_dep_a_{stamp}\", "
+                f"\"examples.c.lean_dep_b_{stamp}\"]\n"
+                "    }\n"
+                "}\n"
+            )
+            (app / "include" / f"{app_id.replace('.', '_')}.h").write_text(
+                f"#include \"{app_dash}/bake_config.h\"\n"
+            )
+            (app / "src" / "a.c").write_text(
+                f"#include <{app_id.replace('.', '_')}.h>\n"
+                f"#include \"{app_dash}/deps/{dep_a_macro}.h\"\n"
+                "int a(void) { return dep_a_value(); }\n"
+            )
+            (app / "src" / "main.c").write_text(
+                f"#include <{app_id.replace('.', '_')}.h>\n"
+                "int a(void);\n"
+                "int main(void) { return a(); }\n"
+            )
+
+            output = self.bake(["--include-report", "build", str(tmp_root)])
+            config_h = (app / "include" / app_dash / "bake_config.h").read_text()
+            self.assertNotIn("#include <examples_c_lean_dep", config_h)
+            forwarding = sorted(p.name for p in (app / "include" / app_dash / "deps").iterdir())
+            self.assertEqual(forwarding, [f"{dep_a_macro}.h", f"examples_c_lean_dep_b_{stamp}.h"])
+
+            report = output[output.index(f"include usage of {app_id}"):]
+            self.assertIn(f"examples.c.lean_dep_a_{stamp}: 1 units\n    src/a.c", report)
+            self.assertIn(f"examples.c.lean_dep_b_{stamp}: not included", report)
+            self.bake(["run", str(app)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "include roots are symlink farms")
+    def test_include_root_replaces_include_directories(self) -> None:
+        # With --include-root every compile searches a single directory of
+        # symlinks to the entries of the project and dependency includes.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"include_root_{stamp}"
+        try:
+            shutil.copytree(
+                self.repo_root / "test" / "projects" / "c" / "pkg_helloworld",
+                tmp_root / "pkg_helloworld",
+                ignore=shutil.ignore_patterns(".bake"),
+            )
+            app = tmp_root / "app"
+            (app / "src").mkdir(parents=True)
+            (app / "include" / "include_root_app").mkdir(parents=True)
+            (app / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.include_root_{stamp}\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"value\": {\"use\": [\"examples.c.pkg_helloworld\"]}\n"
+                "}\n"
+            )
+            (app / "include" / "include_root_app" / "value.h").write_text(
+                "#define INCLUDE_ROOT_VALUE 0\n"
+            )
+            (app / "src" / "main.c").write_text(
+                "#include <examples_c_pkg_helloworld.h>\n"
+                "#include \"include_root_app/value.h\"\n"
+                "int main(void) { return INCLUDE_ROOT_VALUE; }\n"
+            )
+
+            output = self.strip_ansi(
+                self.bake(["--include-root", "--trace", "build", str(tmp_root)])
+            )
+            line = next(l for l in output.splitlines() if "-c" in l and str(app / "src" / "main.c") in l)
+            self.assertEqual(line.count(" -I"), 1)
+            self.assertIn("include_root", line)
+
+            roots = list((app / ".bake").rglob("include_root"))
+            self.assertEqual(len(roots), 1)
+            self.assertTrue((roots[0] / "c" / "examples_c_pkg_helloworld.h").is_symlink())
+            # The precompiled header published by the dependency is linked next
+            # to its header, and used instead of parsing it.
+            self.assertTrue((roots[0] / "c" / "examples_c_pkg_helloworld.h.gch").is_symlink())
+            dep = next((app / ".bake").rglob("main.c.o.d")).read_text()
+            self.assertNotIn("examples_c_pkg_helloworld.h", dep)
+            self.bake(["--include-root", "run", str(app)])
+
+            output = self.bake(["--include-root", "build", str(tmp_root)])
+            self.assertNotIn("main.c", output)
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "checks ar commands; bake defaults to MSVC on Windows")
+    def test_static_library_is_updated_in_place(self) -> None:
+        # Rebuilding a package only replaces the archive members of objects
+        # that changed, and deletes the members of removed sources.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"archive_update_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.archive_update_{stamp}\",\n"
+                "    \"type\": \"package\"\n"
+                "}\n"
+            )
+            for name in ("first", "second", "third"):
+                (tmp_root / "src" / f"{name}.c").write_text(f"int {name}(void) {{ return 0; }}\n")
+
+            self.bake(["--standalone", "build", str(tmp_root)])
+
+            (tmp_root / "src" / "second.c").write_text("int second(void) { return 2; }\n")
+            output = self.strip_ansi(self.bake(["--standalone", "--trace", "build", str(tmp_root)]))
+            replace = [l for l in output.splitlines() if "ar rS" in l]
+            self.assertEqual(len(replace), 1)
+            self.assertIn("second.c.o", replace[0])
+            self.assertNotIn("first.c.o", replace[0])
+            self.assertNotIn("ar rcs", output)
+
+            (tmp_root / "src" / "third.c").unlink()
+            output = self.strip_ansi(self.bake(["--standalone", "--trace", "build", str(tmp_root)]))
+            self.assertIn("ar dS", output)
+
+            archive = next((tmp_root / ".bake").rglob("*.a"))
+            members = subprocess.run(
+                ["ar", "t", str(archive)], capture_output=True, text=True, check=True
+            ).stdout.split()
+            self.assertEqual(sorted(members), ["first.c.o", "second.c.o"])
+
+            # Members are deleted by name, so removing one of two sources with
+            # the same name rebuilds the archive instead.
+            for name in ("a", "b"):
+                (tmp_root / "src" / name).mkdir()
+                (tmp_root / "src" / name / "foo.c").write_text(
+                    f"int {name}_foo(void) {{ return 0; }}\n"
+                )
+            self.bake(["--standalone", "build", str(tmp_root)])
+            (tmp_root / "src" / "a" / "foo.c").unlink()
+            output = self.strip_ansi(self.bake(["--standalone", "--trace", "build", str(tmp_root)]))
+            self.assertNotIn("ar dS", output)
+            symbols = subprocess.run(
+                ["nm", str(archive)], capture_output=True, text=True, check=True
+            ).stdout
+            self.assertIn("b_foo", symbols)
+            self.assertNotIn("a_foo", symbols)
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() != "Linux", "thin archives need GNU ar")
+    def test_package_archive_kinds(self) -> None:
+        # Packages can link into a thin archive or a prelinked object instead
+        # of a regular static library, selected per build mode.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"archive_kinds_{stamp}"
+        try:
+            pkg = tmp_root / "pkg"
+            app = tmp_root / "app"
+            (pkg / "src").mkdir(parents=True)
+            (app / "src").mkdir(parents=True)
+            (pkg / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.archive_kinds_pkg_{stamp}\",\n"
+                "    \"type\": \"package\",\n"
+                "    \"value\": {\"archive\": \"thin\"},\n"
+                "    \"${cfg release}\": {\"archive\": \"prelink\"}\n"
+                "}\n"
+            )
+            (pkg / "src" / "value.c").write_text("int archive_kinds_value(void) { return 7; }\n")
+            (app / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.archive_kinds_app_{stamp}\",\n"
+                "    \"type\": \"application\",\n"
+                f"    \"value\": {{\"use\": [\"examples.c.archive_kinds_pkg_{stamp}\"]}}\n"
+                "}\n"
+            )
+            (app / "src" / "main.c").write_text(
+                "int archive_kinds_value(void);\n"
+                "int main(void) { return archive_kinds_value() == 7 ? 0 : 1; }\n"
+            )
+
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertIn(" rcsT ", output)
+            archive = next((pkg / ".bake").rglob(f"libarchive_kinds_pkg_{stamp}.a"))
+            self.assertTrue(archive.read_bytes().startswith(b"!<thin>"))
+            published = next(self.bake_home.rglob(f"libarchive_kinds_pkg_{stamp}.a"))
+            self.assertTrue(published.read_bytes().startswith(b"!<thin>"))
+            self.bake(["run", str(app)])
+
+            output = self.strip_ansi(self.bake(["--trace", "--cfg", "release", "build", str(tmp_root)]))
+            self.assertIn(" -r -nostdlib", output)
+            self.assertTrue(list((pkg / ".bake").rglob(f"libarchive_kinds_pkg_{stamp}.o")))
+            self.bake(["--cfg", "release", "run", str(app)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() != "Linux", "needs a GNU toolchain with gold")
+    def test_linker_option_selects_and_falls_back(self) -> None:
+        # The linker option is passed as -fuse-ld when the linker works, and
+        # falls back to the default linker with a warning when it doesn't.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"linker_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            project_json = (
+                "{\n"
+                f"    \"id\": \"examples.c.linker_{stamp}\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"value\": {\"linker\": \"%s\"}\n"
+                "}\n"
+            )
+            (tmp_root / "project.json").write_text(project_json % "gold")
+            (tmp_root / "src" / "main.c").write_text("int main(void) { return 0; }\n")
+
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertIn("-fuse-ld=gold", output)
+            self.bake(["run", str(tmp_root)])
+
+            # Changing the linker relinks without recompiling.
+            output = self.strip_ansi(
+                self.bake(["--trace", "--linker", "no-such-linker", "build", str(tmp_root)])
+            )
+            self.assertIn("linker 'no-such-linker' is not available", output)
+            self.assertNotIn("-fuse-ld", output)
+            self.assertNotIn(" -c ", output)
+            link = [l for l in output.splitlines() if "main.c.o" in l and " -o " in l]
+            self.assertEqual(len(link), 1)
+
+            # Probe results are kept, so builds with nothing to link don't probe.
+            cache = (self.bake_home / "cache" / "linkers").read_text()
+            self.assertIn("0 no-such-linker ", cache)
+            self.assertIn("1 gold ", cache)
+            output = self.strip_ansi(
+                self.bake(["--trace", "--linker", "no-such-linker", "build", str(tmp_root)])
+            )
+            self.assertIn("linker 'no-such-linker' is not available", output)
+            self.assertNotIn("linker no-such-linker is", output)
+            self.assertNotIn(" -o ", output)
+            self.bake(["--linker", "no-such-linker", "run", str(tmp_root)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() != "Linux", "needs GNU nm")
+    def test_shared_package_relinks_dependents_on_interface_change(self) -> None:
+        # Shared packages are compiled with -fPIC, and applications using them
+        # only relink when the symbols the library exports change.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"shared_{stamp}"
+        try:
+            pkg = tmp_root / "pkg"
+            app = tmp_root / "app"
+            (pkg / "src").mkdir(parents=True)
+            (app / "src").mkdir(parents=True)
+            (pkg / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.shared_pkg_{stamp}\",\n"
+                "    \"type\": \"package\",\n"
+                "    \"value\": {\"shared\": true}\n"
+                "}\n"
+            )
+            value_c = pkg / "src" / "value.c"
+            value_c.write_text("int shared_value(void) { return 7; }\n")
+            (app / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.shared_app_{stamp}\",\n"
+                "    \"type\": \"application\",\n"
+                f"    \"value\": {{\"use\": [\"examples.c.shared_pkg_{stamp}\"]}}\n"
+                "}\n"
+            )
+            (app / "src" / "main.c").write_text(
+                "int shared_value(void);\n"
+                "int main(void) { return shared_value() == 7 ? 0 : 1; }\n"
+            )
+
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertIn("-fPIC", output)
+            self.assertIn("-Wl,-soname,", output)
+            library = next((pkg / ".bake").rglob(f"libshared_pkg_{stamp}.so"))
+            symbols = Path(f"{library}.symbols")
+            self.assertIn("T shared_value", symbols.read_text())
+            self.assertTrue(list(self.bake_home.rglob(f"libshared_pkg_{stamp}.so.symbols")))
+            self.bake(["run", str(app)])
+
+            def app_links(output: str) -> list:
+                return [l for l in output.splitlines() if "main.c.o" in l and " -o " in l]
+
+            # Changing the code of the library relinks it, but not the app.
+            time.sleep(0.01)
+            value_c.write_text("int shared_value(void) { return 3 + 4; }\n")
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertIn("-Wl,-soname,", output)
+            self.assertEqual(app_links(output), [])
+            self.bake(["run", str(app)])
+
+            # Exporting another function relinks the app.
+            time.sleep(0.01)
+            value_c.write_text(
+                "int shared_value(void) { return 7; }\n"
+                "int shared_other(void) { return 1; }\n"
+            )
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertEqual(len(app_links(output)), 1)
+            self.assertIn("T shared_other", symbols.read_text())
+            self.bake(["run", str(app)])
+
+            # Growing an exported array changes its size, which relinks the app.
+            time.sleep(0.01)
+            value_c.write_text(
+                "int shared_value(void) { return 7; }\n"
+                "int shared_other(void) { return 1; }\n"
+                "int shared_table[2] = {1, 2};\n"
+            )
+            self.bake(["build", str(tmp_root)])
+            self.assertRegex(symbols.read_text(), r"D 0*8 shared_table")
+            time.sleep(0.01)
+            value_c.write_text(
+                "int shared_value(void) { return 7; }\n"
+                "int shared_other(void) { return 1; }\n"
+                "int shared_table[4] = {1, 2, 3, 4};\n"
+            )
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertEqual(len(app_links(output)), 1)
+            self.assertRegex(symbols.read_text(), r"D 0*10 shared_table")
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() != "Linux", "needs a GNU toolchain with gold")
+    def test_debug_info_split_tracks_dwo_files(self) -> None:
+        # Split debug info writes a .dwo file per object, which is rebuilt when
+        # missing and removed when debug info is no longer split.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"debug_info_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.debug_info_{stamp}\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"value\": {\"debug-info\": \"split-compressed\", \"linker\": \"gold\"}\n"
+                "}\n"
+            )
+            (tmp_root / "src" / "main.c").write_text("int main(void) { return 0; }\n")
+
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertIn("-gsplit-dwarf -gz", output)
+            self.assertIn("-Wl,--gdb-index", output)
+            dwo = next((tmp_root / ".bake").rglob("main.c.dwo"))
+            self.bake(["run", str(tmp_root)])
+
+            dwo.unlink()
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertIn(" -c ", output)
+            self.assertTrue(dwo.exists())
+
+            output = self.strip_ansi(
+                self.bake(["--trace", "--debug-info", "full", "build", str(tmp_root)])
+            )
+            self.assertNotIn("-gsplit-dwarf", output)
+            self.assertFalse(dwo.exists())
+
+            output = self.strip_ansi(
+                self.bake(["--trace", "--cfg", "release", "build", str(tmp_root)])
+            )
+            self.assertNotIn("-gsplit-dwarf", output)
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "quotes aren't valid in Windows paths")
+    def test_build_and_run_with_quotes_in_paths(self) -> None:
+        # Commands are spawned as argument vectors, so paths and arguments are
+        # passed as is instead of being quoted and split again.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"quoted 'path' \"{stamp}\""
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.quoted_{stamp}\",\n"
+                "    \"type\": \"application\"\n"
+                "}\n"
+            )
+            (tmp_root / "src" / "main.c").write_text(
+                "#include <string.h>\n"
+                "int main(int argc, char *argv[]) {\n"
+                "    return argc == 3 && !strcmp(argv[1], \"a b\") &&\n"
+                "        !strcmp(argv[2], \"c\\\"d\") ? 0 : 1;\n"
+                "}\n"
+            )
+            self.bake(["build", str(tmp_root)])
+            self.bake(["run", str(tmp_root), "--", "a b", "c\"d"])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_compile_runs_more_jobs_than_threads(self) -> None:
+        # Compilers run as jobs of a single event loop, so -j can exceed the
+        # number of threads. A failing unit fails the build once the jobs that
+        # already run are done.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"jobs_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.jobs_{stamp}\",\n"
+                "    \"type\": \"application\"\n"
+                "}\n"
+            )
+            for i in range(48):
+                (tmp_root / "src" / f"unit_{i}.c").write_text(
+                    f"int unit_{i}(void) {{ return {i}; }}\n"
+                )
+            (tmp_root / "src" / "main.c").write_text(
+                "int unit_47(void);\n"
+                "int main(void) { return unit_47() == 47 ? 0 : 1; }\n"
+            )
+
+            self.bake(["-j", "64", "build", str(tmp_root)])
+            self.assertEqual(len(list((tmp_root / ".bake").rglob("unit_*.c.o"))), 48)
+            self.bake(["run", str(tmp_root)])
+
+            time.sleep(0.01)
+            (tmp_root / "src" / "unit_3.c").write_text("int unit_3(void) { return }\n")
+            output = self.bake_expect_failure(["-j", "64", "build", str(tmp_root)])
+            self.assertIn("command failed with exit code", output)
+            self.assertIn("unit_3.c", output)
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "checks gcc-style flags; bake defaults to MSVC on Windows")
+    def test_long_commands_use_response_files(self) -> None:
+        # Links always pass their arguments in a response file. Compiles only
+        # do when the flags of the project are long, and share one file.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"rsp_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            project_json = (
+                "{\n"
+                f"    \"id\": \"examples.c.rsp_{stamp}\",\n"
+                "    \"type\": \"application\",\n"
+                "    \"value\": {\"defines\": [%s]}\n"
+                "}\n"
+            )
+            defines = ", ".join(
+                f"\"RSP_DEFINE_{i:03d}_WITH_A_RATHER_LONG_NAME={i}\"" for i in range(120)
+            )
+            (tmp_root / "project.json").write_text(project_json % defines)
+            (tmp_root / "src" / "value.c").write_text(
+                "int value(void) { return RSP_DEFINE_119_WITH_A_RATHER_LONG_NAME; }\n"
+            )
+            (tmp_root / "src" / "main.c").write_text(
+                "int value(void);\n"
+                "int main(void) { return value() == 119 ? 0 : 1; }\n"
+            )
+
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            compiles = [l for l in output.splitlines() if "compile-c.rsp " in l]
+            self.assertEqual(len(compiles), 2)
+            for line in compiles:
+                self.assertIn(".c.o", line)
+                self.assertNotIn("RSP_DEFINE_000", line)
+            self.assertEqual(output.count("RSP_DEFINE_000"), 1)
+            rsp = next((tmp_root / ".bake").rglob("compile-c.rsp"))
+            self.assertIn("-DRSP_DEFINE_119_WITH_A_RATHER_LONG_NAME=119", rsp.read_text())
+            link_rsp = next((tmp_root / ".bake").rglob("link.rsp"))
+            self.assertIn("main.c.o", link_rsp.read_text())
+            self.bake(["run", str(tmp_root)])
+
+            # Short flags are passed on the command line again.
+            (tmp_root / "project.json").write_text(
+                project_json % "\"RSP_DEFINE_119_WITH_A_RATHER_LONG_NAME=119\""
+            )
+            output = self.strip_ansi(self.bake(["--trace", "build", str(tmp_root)]))
+            self.assertNotIn("compile-c.rsp", output)
+            self.assertFalse(rsp.exists())
+            self.bake(["run", str(tmp_root)])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "uses a gcc-style #warning directive")
+    def test_replay_warnings_of_up_to_date_sources(self) -> None:
+        # Compiler output is stored next to the object, so warnings of sources
+        # that aren't recompiled can still be printed.
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"diag_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.diag_{stamp}\",\n"
+                "    \"type\": \"application\"\n"
+                "}\n"
+            )
+            (tmp_root / "src" / "value.c").write_text(
+                "#warning \"replay this warning\"\n"
+                "int value(void) { return 0; }\n"
+            )
+            (tmp_root / "src" / "main.c").write_text(
+                "int value(void);\n"
+                "int main(void) { return value(); }\n"
+            )
+
+            output = self.strip_ansi(self.bake(["build", str(tmp_root)]))
+            printed = output.count("replay this warning")
+            self.assertGreater(printed, 0)
+            diag = next((tmp_root / ".bake").rglob("value.c.diag"))
+            self.assertIn("replay this warning", diag.read_text())
+            self.assertEqual(list((tmp_root / ".bake").rglob("main.c.diag")), [])
+
+            output = self.strip_ansi(self.bake(["build", str(tmp_root)]))
+            self.assertNotIn("replay this warning", output)
+
+            output = self.strip_ansi(
+                self.bake(["--trace", "--replay-warnings", "build", str(tmp_root)])
+            )
+            self.assertEqual(output.count("replay this warning"), printed)
+            self.assertNotIn(" -c ", output)
+
+            # On a terminal diagnostics are colored, but stored without colors.
+            if platform.system() != "Windows":
+                import pty
+
+                time.sleep(0.01)
+                (tmp_root / "src" / "value.c").touch()
+                master, slave = pty.openpty()
+                proc = subprocess.Popen(
+                    [str(self.bake_bin), "build", str(tmp_root)],
+                    cwd=str(self.repo_root),
+                    env=self.env,
+                    stdout=subprocess.DEVNULL,
+                    stderr=slave,
+                )
+                os.close(slave)
+                chunks = []
+                while True:
+                    try:
+                        chunk = os.read(master, 4096)
+                    except OSError:
+                        break
+                    if not chunk:
+                        break
+                    chunks.append(chunk)
+                os.close(master)
+                self.assertEqual(proc.wait(), 0)
+                lines = b"".join(chunks).splitlines()
+                self.assertTrue(any(
+                    b"replay this warning" in line and b"\x1b[" in line
+                    for line in lines
+                ))
+                self.assertIn("replay this warning", diag.read_text())
+                self.assertNotIn("\x1b", diag.read_text())
+
+            (tmp_root / "src" / "value.c").write_text("int value(void) { return 0; }\n")
+            output = self.strip_ansi(self.bake(["build", str(tmp_root)]))
+            self.assertNotIn("replay this warning", output)
+            self.assertFalse(diag.exists())
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    @unittest.skipIf(platform.system() == "Windows", "wraps the compiler in a shell script")
+    def test_first_failure_cancels_running_compiles(self) -> None:
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"failfast_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.failfast_{stamp}\",\n"
+                "    \"type\": \"application\"\n"
+                "}\n"
+            )
+            wrapper = tmp_root / "slow-gcc"
+            wrapper.write_text(
+                "#!/bin/sh\n"
+                "case \"$*\" in *slow.c*) sleep 20;; esac\n"
+                "exec cc \"$@\"\n"
+            )
+            wrapper.chmod(0o755)
+            (tmp_root / "src" / "slow.c").write_text("int slow(void) { return 0; }\n")
+            (tmp_root / "src" / "broken.c").write_text("int broken(void) { return missing; }\n")
+            (tmp_root / "src" / "main.c").write_text("int main(void) { return 0; }\n")
+
+            start = time.monotonic()
+            output = self.strip_ansi(self.bake_expect_failure(
+                ["--cc", str(wrapper), "-j", "4", "build", str(tmp_root)]
+            ))
+            self.assertLess(time.monotonic() - start, 10)
+            self.assertIn("broken.c", output)
+            self.assertEqual(list((tmp_root / ".bake").rglob("slow.c.o")), [])
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_keep_going_builds_independent_projects(self) -> None:
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"keepgoing_{stamp}"
+        projects = {
+            "broken": ("package", []),
+            "dependent": ("application", ["broken"]),
+            "independent": ("application", []),
+        }
+        try:
+            for name, (kind, use) in projects.items():
+                (tmp_root / name / "src").mkdir(parents=True)
+                uses = ", ".join(f"\"examples.c.kg_{stamp}_{dep}\"" for dep in use)
+                (tmp_root / name / "project.json").write_text(
+                    "{\n"
+                    f"    \"id\": \"examples.c.kg_{stamp}_{name}\",\n"
+                    f"    \"type\": \"{kind}\",\n"
+                    f"    \"value\": {{\"use\": [{uses}]}}\n"
+                    "}\n"
+                )
+            (tmp_root / "broken" / "include").mkdir()
+            (tmp_root / "broken" / "src" / "broken.c").write_text(
+                "int broken(void) { return missing; }\n"
+            )
+            (tmp_root / "broken" / "src" / "fine.c").write_text("int fine(void) { return 0; }\n")
+            for name in ("dependent", "independent"):
+                (tmp_root / name / "src" / "main.c").write_text("int main(void) { return 0; }\n")
+
+            output = self.strip_ansi(self.bake_expect_failure(["build", str(tmp_root)]))
+            self.assertNotIn("skipping", output)
+
+            output = self.strip_ansi(self.bake_expect_failure(["-k", "build", str(tmp_root)]))
+            self.assertIn(f"skipping examples.c.kg_{stamp}_dependent", output)
+            self.assertIn("1 project failed to build", output)
+            self.assertTrue(list((tmp_root / "broken" / ".bake").rglob("fine.c.o")))
+            self.assertEqual(list((tmp_root / "dependent").rglob("main.c.o")), [])
+            self.assertTrue(list((tmp_root / "independent" / ".bake").rglob("main.c.o")))
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
+    def test_usage_report_lists_units_from_history(self) -> None:
+        stamp = int(time.time() * 1_000_000)
+        tmp_root = self.repo_root / "test" / "tmp" / f"usage_{stamp}"
+        try:
+            (tmp_root / "src").mkdir(parents=True)
+            (tmp_root / "project.json").write_text(
+                "{\n"
+                f"    \"id\": \"examples.c.usage_{stamp}\",\n"
+                "    \"type\": \"application\"\n"
+                "}\n"
+            )
+            (tmp_root / "src" / "value.c").write_text("int value(void) { return 0; }\n")
+            (tmp_root / "src" / "main.c").write_text(
+                "int value(void);\n"
+                "int main(void) { return value(); }\n"
+            )
+
+            output = self.strip_ansi(self.bake(["--usage-report", "build", str(tmp_root)]))
+            self.assertIn(f"resource usage of examples.c.usage_{stamp} (2 units)", output)
+            history = next((tmp_root / ".bake").rglob(".bake_usage")).read_text().splitlines()
+            self.assertEqual(len(history), 2)
+            for line in history:
+                fields = line.split(" ", 7)
+                self.assertTrue(all(field.isdigit() for field in fields[:7]))
+                self.assertTrue(fields[7].endswith(("main.c", "value.c")))
+
+            # Units that are up to date are reported from the history.
+            time.sleep(1.1)
+            (tmp_root / "src" / "value.c").write_text("int value(void) { return 1 - 1; }\n")
+            output = self.strip_ansi(self.bake(["--usage-report", "build", str(tmp_root)]))
+            self.assertIn("(2 units)", output)
+            lines = [l for l in output.splitlines() if " MB rss " in l]
+            self.assertEqual(len(lines), 2)
+            self.assertTrue(any(l.endswith("main.c (up to date)") for l in lines))
+            self.assertTrue(any(l.endswith("value.c") for l in lines))
+
+            output = self.strip_ansi(self.bake(["build", str(tmp_root)]))
+            self.assertNotIn("resource usage", output)
+        finally:
+            shutil.rmtree(tmp_root, ignore_errors=True)
+
     def test_build_distinguishes_sources_with_colliding_flat_names(self) -> None:
         self.bake(["build", "test/projects/c/app_obj_collision"])
         state = self.list_state()
@@ -2,11 +2,11 @@
 #include "bake/os.h"
 
 #include <ctype.h>
-
-#define BAKE_AMALG_MAX_LINE (4096)
+#include <stdarg.h>
 
 typedef struct bake_concat_ctx_t {
-    ecs_strbuf_t *out;
+    ecs_strbuf_t *out;          /* Append matching files here, or */
+    bake_strlist_t *files;      /* collect their paths */
     const char *ext;
 } bake_concat_ctx_t;
 
@@ -15,12 +15,31 @@ typedef struct bake_amalgamate_ctx_t {
     const char *include_name;
     const char *include_path;
     const bake_strlist_t *disable;
+    bake_strlist_t *inputs;     /* Files read, recorded in the manifest */
+    bake_strlist_t *absent;     /* Include candidates that did not exist */
+    bake_strtable_t paths;      /* Candidate and resolved paths */
+    ecs_map_t realpaths;        /* Candidate path -> resolved path, 0 if missing */
+    ecs_map_t parsed;           /* Resolved paths of files already emitted */
+    char *line;                 /* Copy of the directive line being parsed */
+    size_t line_cap;
 } bake_amalgamate_ctx_t;
 
 typedef struct bake_collect_sources_ctx_t {
     bake_strlist_t *sources;
 } bake_collect_sources_ctx_t;
 
+static void bake_concat_append_file(
+    ecs_strbuf_t *out,
+    const char *path,
+    const bake_file_map_t *content)
+{
+    char *rel = bake_path_basename(path);
+    ecs_strbuf_append(out, "\n/* --- %s --- */\n", rel ? rel : path);
+    ecs_strbuf_appendstrn(out, content->data, (int32_t)content->len);
+    ecs_strbuf_appendstr(out, "\n");
+    ecs_os_free(rel);
+}
+
 static int bake_concat_visit(const bake_dir_entry_t *entry, void *ctx_ptr) {
     bake_concat_ctx_t *ctx = ctx_ptr;
     if (entry->is_dir) {
@@ -34,32 +53,88 @@ static int bake_concat_visit(const bake_dir_entry_t *entry, void *ctx_ptr) {
         return 0;
     }
 
-    char *content = bake_file_read(entry->path, NULL);
-    if (!content) {
+    if (ctx->files) {
+        return bake_strlist_append(ctx->files, entry->path);
+    }
+
+    bake_file_map_t content;
+    if (bake_file_map(entry->path, &content) != 0) {
         return -1;
     }
 
-    char *rel = bake_path_basename(entry->path);
-    ecs_strbuf_append(ctx->out, "\n/* --- %s --- */\n", rel ? rel : entry->path);
-    ecs_strbuf_appendstr(ctx->out, content);
-    ecs_strbuf_appendstr(ctx->out, "\n");
+    bake_concat_append_file(ctx->out, entry->path, &content);
+    bake_file_unmap(&content);
+    return 0;
+}
+
+/* Writes one source unit with files [first, last) of the list. */
+static int bake_amalgamate_write_unit(
+    const bake_project_cfg_t *cfg,
+    const char *dst_dir,
+    const char *base,
+    const bake_strlist_t *sources,
+    int32_t first,
+    int32_t last,
+    int32_t unit,
+    int32_t unit_count,
+    bake_strlist_t *outputs)
+{
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    char *name = unit_count > 1 ?
+        flecs_asprintf("%s_%d.c", base, unit + 1) :
+        flecs_asprintf("%s.c", base);
+
+    if (unit_count > 1) {
+        ecs_strbuf_append(&buf, "/* Amalgamated sources for %s (unit %d of %d) */\n",
+            cfg->id, unit + 1, unit_count);
+    } else {
+        ecs_strbuf_append(&buf, "/* Amalgamated sources for %s */\n", cfg->id);
+    }
+    ecs_strbuf_append(&buf, "#include \"%s.h\"\n", base);
+
+    for (int32_t i = first; i < last; i++) {
+        bake_file_map_t content;
+        if (bake_file_map(sources->items[i], &content) != 0) {
+            ecs_strbuf_reset(&buf);
+            ecs_os_free(name);
+            return -1;
+        }
+        bake_concat_append_file(&buf, sources->items[i], &content);
+        bake_file_unmap(&content);
+    }
+
+    char *path = bake_path_join(dst_dir, name);
+    char *content = ecs_strbuf_get(&buf);
+    int rc = bake_file_write(path, content);
+    if (rc == 0 && outputs) {
+        bake_strlist_append(outputs, name);
+    }
 
-    ecs_os_free(rel);
     ecs_os_free(content);
-    return 0;
+    ecs_os_free(path);
+    ecs_os_free(name);
+    return rc;
 }
 
-int bake_amalgamate_project(const bake_project_cfg_t *cfg, const char *dst_dir) {
+/* Amalgamates a project into <base>.h and <base>.c, or with units > 1 into
+ * that many <base>_<n>.c files of about equal size. Each unit concatenates
+ * whole source files in their original order, so units compile wherever the
+ * single file does. Names of written files are appended to outputs. */
+int bake_amalgamate_project(
+    const bake_project_cfg_t *cfg,
+    const char *dst_dir,
+    int32_t units,
+    bake_strlist_t *outputs)
+{
     int rc = -1;
     char *base = NULL;
     char *h_name = NULL;
-    char *c_name = NULL;
     char *h_path = NULL;
-    char *c_path = NULL;
     char *h_content = NULL;
-    char *c_content = NULL;
+    int64_t *sizes = NULL;
     ecs_strbuf_t h_buf = ECS_STRBUF_INIT;
-    ecs_strbuf_t c_buf = ECS_STRBUF_INIT;
+    bake_strlist_t sources = {0};
+    bake_strlist_init(&sources);
 
     if (bake_os_mkdirs(dst_dir) != 0) {
         goto cleanup;
@@ -67,9 +142,7 @@ int bake_amalgamate_project(const bake_project_cfg_t *cfg, const char *dst_dir)
 
     base = bake_project_id_as_macro(cfg->id);
     h_name = flecs_asprintf("%s.h", base);
-    c_name = flecs_asprintf("%s.c", base);
     h_path = bake_path_join(dst_dir, h_name);
-    c_path = bake_path_join(dst_dir, c_name);
 
     ecs_strbuf_append(&h_buf, "/* Amalgamated headers for %s */\n", cfg->id);
     ecs_strbuf_append(&h_buf, "#ifndef %s_H\n", base);
@@ -86,12 +159,17 @@ int bake_amalgamate_project(const bake_project_cfg_t *cfg, const char *dst_dir)
     ecs_os_free(include_dir);
 
     ecs_strbuf_appendstr(&h_buf, "\n#endif\n");
-    ecs_strbuf_append(&c_buf, "/* Amalgamated sources for %s */\n", cfg->id);
-    ecs_strbuf_append(&c_buf, "#include \"%s\"\n", h_name);
+    h_content = ecs_strbuf_get(&h_buf);
+    if (bake_file_write(h_path, h_content) != 0) {
+        goto cleanup;
+    }
+    if (outputs) {
+        bake_strlist_append(outputs, h_name);
+    }
 
     char *src_dir = bake_path_join(cfg->path, "src");
     if (bake_path_exists(src_dir)) {
-        bake_concat_ctx_t ctx = {.out = &c_buf, .ext = ".c"};
+        bake_concat_ctx_t ctx = {.files = &sources, .ext = ".c"};
         if (bake_dir_walk_recursive(src_dir, bake_concat_visit, &ctx) != 0) {
             ecs_os_free(src_dir);
             goto cleanup;
@@ -99,18 +177,257 @@ int bake_amalgamate_project(const bake_project_cfg_t *cfg, const char *dst_dir)
     }
     ecs_os_free(src_dir);
 
-    h_content = ecs_strbuf_get(&h_buf);
-    c_content = ecs_strbuf_get(&c_buf);
-    if (bake_file_write(h_path, h_content) != 0 || bake_file_write(c_path, c_content) != 0) {
+    int32_t unit_count = units < sources.count ? units : sources.count;
+    if (unit_count <= 1) {
+        rc = bake_amalgamate_write_unit(cfg, dst_dir, base, &sources,
+            0, sources.count, 0, 1, outputs);
         goto cleanup;
     }
 
+    int64_t total = 0;
+    sizes = ecs_os_malloc_n(int64_t, sources.count);
+    for (int32_t i = 0; i < sources.count; i++) {
+        sizes[i] = bake_os_file_size(sources.items[i]);
+        total += sizes[i] > 0 ? sizes[i] : 0;
+    }
+
+    /* Close a unit once it reaches its share of the total, leaving at least
+     * one file for every unit that comes after it. */
+    int32_t first = 0;
+    int64_t done = 0;
+    for (int32_t unit = 0; unit < unit_count; unit++) {
+        int64_t target = total * (unit + 1) / unit_count;
+        int32_t last = first + 1;
+        done += sizes[first] > 0 ? sizes[first] : 0;
+        while (last < sources.count - (unit_count - unit - 1) &&
+            (done < target || unit == unit_count - 1))
+        {
+            done += sizes[last] > 0 ? sizes[last] : 0;
+            last++;
+        }
+
+        if (bake_amalgamate_write_unit(cfg, dst_dir, base, &sources,
+            first, last, unit, unit_count, outputs) != 0)
+        {
+            goto cleanup;
+        }
+        first = last;
+    }
+
     rc = 0;
 
 cleanup:
-#define F(p) ecs_os_free(p)
-    F(base); F(h_name); F(c_name); F(h_path); F(c_path); F(h_content); F(c_content);
-#undef F
+    ecs_strbuf_reset(&h_buf);
+    bake_strlist_fini(&sources);
+    ecs_os_free(sizes);
+    ecs_os_free(base);
+    ecs_os_free(h_name);
+    ecs_os_free(h_path);
+    ecs_os_free(h_content);
+    return rc;
+}
+
+/* Standalone dependency cache. A dependency's amalgamation only depends on
+ * the headers and sources it concatenates, so it is generated once per source
+ * snapshot into $BAKE_HOME/cache/amalgamate/<id>/<snapshot> and linked into
+ * the deps/ folder of every standalone project that uses it. */
+
+#define BAKE_AMALG_CACHE_VERSION (1)
+
+typedef struct bake_snapshot_ctx_t {
+    uint64_t hash;
+    const char *ext;
+} bake_snapshot_ctx_t;
+
+static int bake_snapshot_visit(const bake_dir_entry_t *entry, void *ctx_ptr) {
+    bake_snapshot_ctx_t *ctx = ctx_ptr;
+    if (entry->is_dir) {
+        if (bake_is_dot_dir(entry->name) || entry->name[0] == '.') {
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!bake_has_suffix(entry->path, ctx->ext)) {
+        return 0;
+    }
+
+    int64_t stat[2] = {
+        bake_os_file_size(entry->path),
+        bake_os_file_mtime(entry->path)
+    };
+    ctx->hash = bake_hash(ctx->hash, entry->path, strlen(entry->path) + 1);
+    ctx->hash = bake_hash(ctx->hash, stat, sizeof(stat));
+    return 0;
+}
+
+/* Hashes path, size and mtime of every file bake_amalgamate_project reads,
+ * in the order it reads them. */
+static int bake_amalgamate_snapshot(
+    const bake_project_cfg_t *cfg,
+    uint64_t *hash_out)
+{
+    int32_t version = BAKE_AMALG_CACHE_VERSION;
+    bake_snapshot_ctx_t ctx = { .hash = BAKE_HASH_INIT };
+    ctx.hash = bake_hash(ctx.hash, &version, sizeof(version));
+    ctx.hash = bake_hash(ctx.hash, cfg->id, strlen(cfg->id) + 1);
+
+    const char *dirs[] = { "include", "src" };
+    const char *exts[] = { ".h", ".c" };
+    for (int32_t i = 0; i < 2; i++) {
+        char *dir = bake_path_join(cfg->path, dirs[i]);
+        int rc = 0;
+        if (bake_path_exists(dir)) {
+            ctx.ext = exts[i];
+            rc = bake_dir_walk_recursive(dir, bake_snapshot_visit, &ctx);
+        }
+        ecs_os_free(dir);
+        if (rc != 0) {
+            return -1;
+        }
+    }
+
+    *hash_out = ctx.hash;
+    return 0;
+}
+
+/* Removes snapshots other than the current one, keeping every unit split of
+ * it. Projects that still link to removed files keep them alive, since only
+ * the cache's link goes away. */
+static int bake_amalgamate_cache_prune(const char *id_dir, const char *snapshot) {
+    bake_dir_entry_t *entries = NULL;
+    int32_t count = 0;
+    if (bake_dir_list(id_dir, &entries, &count) != 0) {
+        return -1;
+    }
+
+    size_t len = strlen(snapshot);
+    int rc = 0;
+    for (int32_t i = 0; i < count && rc == 0; i++) {
+        const char *name = entries[i].name;
+        if (bake_is_dot_dir(name)) {
+            continue;
+        }
+        if (!strncmp(name, snapshot, len) && (!name[len] || name[len] == '.')) {
+            continue;
+        }
+        rc = bake_os_rmtree(entries[i].path);
+    }
+
+    bake_dir_entries_free(entries, count);
+    return rc;
+}
+
+static int bake_amalgamate_cache_fill(
+    const bake_project_cfg_t *cfg,
+    const char *id_dir,
+    const char *snapshot,
+    const char *snapshot_dir,
+    int32_t units)
+{
+    char *tmp_dir = flecs_asprintf("%s.tmp", snapshot_dir);
+    int rc = -1;
+
+    if (bake_path_exists(tmp_dir) && bake_os_rmtree(tmp_dir) != 0) {
+        goto cleanup;
+    }
+    if (bake_amalgamate_project(cfg, tmp_dir, units, NULL) != 0) {
+        goto cleanup;
+    }
+
+    /* Publish the complete snapshot at once so that an interrupted build
+     * never leaves a partial one behind. */
+    if (rename(tmp_dir, snapshot_dir) != 0) {
+        if (!bake_path_is_dir(snapshot_dir)) {
+            bake_log_errno_last("rename directory", tmp_dir);
+            goto cleanup;
+        }
+        /* Published concurrently by another build */
+        bake_os_rmtree(tmp_dir);
+    }
+
+    rc = bake_amalgamate_cache_prune(id_dir, snapshot);
+
+cleanup:
+    if (rc != 0 && bake_path_exists(tmp_dir)) {
+        bake_os_rmtree(tmp_dir);
+    }
+    ecs_os_free(tmp_dir);
+    return rc;
+}
+
+static bool bake_is_supported_source(const char *path) {
+    return bake_has_suffix(path, ".c") ||
+        bake_has_suffix(path, ".cpp") ||
+        bake_has_suffix(path, ".cc") ||
+        bake_has_suffix(path, ".cxx") ||
+        bake_has_suffix(path, ".C");
+}
+
+int bake_amalgamate_project_cached(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const char *dst_dir,
+    int32_t units,
+    bake_strlist_t *outputs,
+    bake_strlist_t *sources)
+{
+    if (!ctx->bake_home || !ctx->bake_home[0]) {
+        return bake_amalgamate_project(cfg, dst_dir, units, outputs);
+    }
+
+    uint64_t hash = 0;
+    if (bake_amalgamate_snapshot(cfg, &hash) != 0) {
+        return -1;
+    }
+
+    int rc = -1;
+    bake_dir_entry_t *entries = NULL;
+    int32_t count = 0;
+    char *cache_dir = bake_path_join3(ctx->bake_home, "cache", "amalgamate");
+    char *id_dir = bake_path_join(cache_dir, cfg->id);
+    char *snapshot = flecs_asprintf("%016llx", (unsigned long long)hash);
+    char *snapshot_dir = units > 1 ?
+        flecs_asprintf("%s/%s.%d", id_dir, snapshot, units) :
+        bake_path_join(id_dir, snapshot);
+
+    if (!bake_path_is_dir(snapshot_dir) && bake_amalgamate_cache_fill(
+        cfg, id_dir, snapshot, snapshot_dir, units) != 0)
+    {
+        goto cleanup;
+    }
+
+    if (bake_os_mkdirs(dst_dir) != 0 ||
+        bake_dir_list(snapshot_dir, &entries, &count) != 0)
+    {
+        goto cleanup;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        if (entries[i].is_dir) {
+            continue;
+        }
+        char *dst = bake_path_join(dst_dir, entries[i].name);
+        int link_rc = bake_os_file_link(entries[i].path, dst);
+        ecs_os_free(dst);
+        if (link_rc != 0) {
+            goto cleanup;
+        }
+        if (outputs) {
+            bake_strlist_append(outputs, entries[i].name);
+        }
+        if (sources && bake_is_supported_source(entries[i].name)) {
+            bake_strlist_append(sources, entries[i].path);
+        }
+    }
+
+    rc = 0;
+cleanup:
+    bake_dir_entries_free(entries, count);
+    ecs_os_free(cache_dir);
+    ecs_os_free(id_dir);
+    ecs_os_free(snapshot);
+    ecs_os_free(snapshot_dir);
     return rc;
 }
 
@@ -164,21 +481,6 @@ static char* bake_parse_include_file(const char *line, bool *relative_out) {
     return out;
 }
 
-static bool bake_path_mark_parsed(bake_strlist_t *parsed, const char *path) {
-    char *normalized = bake_path_resolve(path);
-    if (!normalized) {
-        return false;
-    }
-
-    if (bake_strlist_contains(parsed, normalized)) {
-        ecs_os_free(normalized);
-        return false;
-    }
-
-    bake_strlist_append_owned(parsed, normalized);
-    return true;
-}
-
 static int bake_source_depth(const char *path) {
     int depth = 0;
     for (const char *p = path; p && *p; p++) {
@@ -283,12 +585,11 @@ static bool bake_arg_is_disabled_macro(const char *arg, const bake_strlist_t *di
     return bake_disable_contains(disable, name, (size_t)(p - name));
 }
 
-static bool bake_line_continues(const char *line) {
-    size_t len = strlen(line);
-    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
-        len--;
+static bool bake_line_continues(const char *line, const char *end) {
+    while (end > line && (end[-1] == '\n' || end[-1] == '\r')) {
+        end--;
     }
-    return len > 0 && line[len - 1] == '\\';
+    return end > line && end[-1] == '\\';
 }
 
 static bool bake_is_disabled_define(const char *line, const bake_strlist_t *disable) {
@@ -426,34 +727,326 @@ static bool bake_cond_eval_managed(
     return false;
 }
 
+static bool bake_comment_has_file_directive(const char *start, const char *end) {
+    for (const char *q = start; q + 5 <= end; q++) {
+        if ((q[0] == '@' || q[0] == '\\') &&
+            q[1] == 'f' && q[2] == 'i' && q[3] == 'l' && q[4] == 'e' &&
+            (q + 5 == end || !bake_is_ident_char(q[5])))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Amalgamation output. Everything written passes through a streaming cleaner
+ * that drops comments with a @file directive and collapses runs of empty
+ * lines, so the result can be written out without a second pass. Block
+ * comments are emitted as they come in and truncated again if they turn out
+ * to be a file header. */
+
+typedef enum bake_amalg_clean_state_t {
+    BAKE_CLEAN_CODE,
+    BAKE_CLEAN_SLASH,
+    BAKE_CLEAN_STRING,
+    BAKE_CLEAN_LINE_COMMENT,
+    BAKE_CLEAN_BLOCK_COMMENT
+} bake_amalg_clean_state_t;
+
+typedef struct bake_amalg_out_t {
+    char *buf;
+    size_t len;
+    size_t cap;
+    bake_amalg_clean_state_t state;
+    char quote;
+    bool escape;                /* String: previous character was a '\' */
+    bool star;                  /* Block comment: previous character was a '*' */
+    int32_t newline_run;
+    int32_t comment_newline_run; /* newline_run before a '/' that may start a comment */
+    size_t comment_start;
+} bake_amalg_out_t;
+
+static void bake_amalg_out_init(bake_amalg_out_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->newline_run = 2; /* Drop leading empty lines */
+}
+
+static void bake_amalg_out_fini(bake_amalg_out_t *out) {
+    ecs_os_free(out->buf);
+    memset(out, 0, sizeof(*out));
+}
+
+static void bake_amalg_out_reserve(bake_amalg_out_t *out, size_t size) {
+    if (size <= out->cap) {
+        return;
+    }
+    size_t next = out->cap ? out->cap : 64 * 1024;
+    while (next < size) {
+        next *= 2;
+    }
+    out->buf = ecs_os_realloc_n(out->buf, char, (int32_t)next);
+    out->cap = next;
+}
+
+static void bake_amalg_out_end_comment(bake_amalg_out_t *out) {
+    if (bake_comment_has_file_directive(
+        out->buf + out->comment_start, out->buf + out->len))
+    {
+        out->len = out->comment_start;
+        out->newline_run = out->comment_newline_run;
+    } else {
+        out->newline_run = 0;
+    }
+    out->state = BAKE_CLEAN_CODE;
+}
+
+static void bake_amalg_out_write(
+    bake_amalg_out_t *out,
+    const char *data,
+    size_t len)
+{
+    /* Cleaning never makes the output longer than the input. */
+    bake_amalg_out_reserve(out, out->len + len + 1);
+    char *buf = out->buf;
+    size_t w = out->len;
+
+    for (const char *p = data, *end = data + len; p < end; p++) {
+        char c = *p;
+        switch (out->state) {
+        case BAKE_CLEAN_SLASH:
+            if (c == '/') {
+                buf[w++] = c;
+                out->state = BAKE_CLEAN_LINE_COMMENT;
+                break;
+            }
+            if (c == '*') {
+                out->comment_start = w - 1;
+                buf[w++] = c;
+                out->star = false;
+                out->state = BAKE_CLEAN_BLOCK_COMMENT;
+                break;
+            }
+            out->state = BAKE_CLEAN_CODE;
+            /* fall through */
+        case BAKE_CLEAN_CODE:
+            if (c == '"' || c == '\'') {
+                buf[w++] = c;
+                out->quote = c;
+                out->escape = false;
+                out->newline_run = 0;
+                out->state = BAKE_CLEAN_STRING;
+            } else if (c == '/') {
+                buf[w++] = c;
+                out->comment_newline_run = out->newline_run;
+                out->newline_run = 0;
+                out->state = BAKE_CLEAN_SLASH;
+            } else if (c == '\n') {
+                if (out->newline_run < 2) {
+                    buf[w++] = c;
+                    out->newline_run++;
+                }
+            } else {
+                buf[w++] = c;
+                out->newline_run = 0;
+            }
+            break;
+        case BAKE_CLEAN_STRING:
+            buf[w++] = c;
+            if (out->escape) {
+                out->escape = false;
+            } else if (c == '\\') {
+                out->escape = true;
+            } else if (c == out->quote) {
+                out->state = BAKE_CLEAN_CODE;
+            }
+            break;
+        case BAKE_CLEAN_LINE_COMMENT:
+            buf[w++] = c;
+            if (c == '\n') {
+                out->newline_run = 1;
+                out->state = BAKE_CLEAN_CODE;
+            }
+            break;
+        case BAKE_CLEAN_BLOCK_COMMENT:
+            buf[w++] = c;
+            if (out->star && c == '/') {
+                out->len = w;
+                bake_amalg_out_end_comment(out);
+                w = out->len;
+            } else {
+                out->star = c == '*';
+            }
+            break;
+        }
+    }
+
+    out->len = w;
+}
+
+static void bake_amalg_out_str(bake_amalg_out_t *out, const char *str) {
+    bake_amalg_out_write(out, str, strlen(str));
+}
+
+static void bake_amalg_out_fmt(bake_amalg_out_t *out, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char *str = flecs_vasprintf(fmt, args);
+    va_end(args);
+    bake_amalg_out_str(out, str);
+    ecs_os_free(str);
+}
+
+static int bake_amalg_out_flush(bake_amalg_out_t *out, const char *path) {
+    if (out->state == BAKE_CLEAN_BLOCK_COMMENT) {
+        bake_amalg_out_end_comment(out);
+    }
+    bake_amalg_out_reserve(out, out->len + 1);
+    out->buf[out->len] = '\0';
+    return bake_file_write(path, out->buf);
+}
+
+/* Resolves a path with realpath, once per distinct candidate. Returns NULL
+ * when the path does not exist; misses are recorded, since a file appearing
+ * there later changes what an include resolves to. */
+static const char* bake_amalgamate_resolve(
+    bake_amalgamate_ctx_t *ctx,
+    const char *path)
+{
+    const char *key = bake_strtable_intern(&ctx->paths, path);
+    ecs_map_val_t *cached = ecs_map_get(&ctx->realpaths, (ecs_map_key_t)(uintptr_t)key);
+    if (cached) {
+        return (const char*)(uintptr_t)*cached;
+    }
+
+    const char *resolved = NULL;
+    if (bake_path_exists(path)) {
+        char *normalized = bake_path_resolve(path);
+        resolved = bake_strtable_intern(&ctx->paths, normalized);
+        ecs_os_free(normalized);
+    } else {
+        bake_strlist_append(ctx->absent, path);
+    }
+
+    ecs_map_insert(&ctx->realpaths, (ecs_map_key_t)(uintptr_t)key,
+        (ecs_map_val_t)(uintptr_t)resolved);
+    return resolved;
+}
+
+static bool bake_amalgamate_mark_parsed(
+    bake_amalgamate_ctx_t *ctx,
+    const char *resolved)
+{
+    ecs_map_key_t key = (ecs_map_key_t)(uintptr_t)resolved;
+    if (ecs_map_get(&ctx->parsed, key)) {
+        return false;
+    }
+    ecs_map_insert(&ctx->parsed, key, 0);
+    return true;
+}
+
+/* Returns a NUL-terminated copy of a line for the directive parsers. The
+ * buffer is shared by all files, so it must not be used after recursing. */
+static char* bake_amalgamate_line(
+    bake_amalgamate_ctx_t *ctx,
+    const char *start,
+    size_t len)
+{
+    if (len + 1 > ctx->line_cap) {
+        size_t cap = ctx->line_cap ? ctx->line_cap : 256;
+        while (cap < len + 1) {
+            cap *= 2;
+        }
+        ctx->line = ecs_os_realloc_n(ctx->line, char, (int32_t)cap);
+        ctx->line_cap = cap;
+    }
+    memcpy(ctx->line, start, len);
+    ctx->line[len] = '\0';
+    return ctx->line;
+}
+
+/* Tracks block comments across a line, skipping string literals and line
+ * comments. Returns whether the line ends inside a block comment. */
+static bool bake_scan_block_comments(
+    const char *scan,
+    const char *end,
+    bool in_block_comment)
+{
+    while (scan < end) {
+        char next = (scan + 1) < end ? scan[1] : '\0';
+        if (in_block_comment) {
+            if (scan[0] == '*' && next == '/') {
+                in_block_comment = false;
+                scan += 2;
+                continue;
+            }
+            scan++;
+            continue;
+        }
+        if (scan[0] == '/' && next == '/') {
+            break;
+        }
+        if (scan[0] == '/' && next == '*') {
+            in_block_comment = true;
+            scan += 2;
+            continue;
+        }
+        if (scan[0] == '"' || scan[0] == '\'') {
+            char quote = *scan++;
+            while (scan < end && *scan != quote) {
+                if (scan[0] == '\\' && (scan + 1) < end) {
+                    scan++;
+                }
+                scan++;
+            }
+            if (scan < end) {
+                scan++;
+            }
+            continue;
+        }
+        scan++;
+    }
+    return in_block_comment;
+}
+
+static bool bake_line_is_directive(const char *line, const char *end) {
+    while (line < end && isspace((unsigned char)*line)) {
+        line++;
+    }
+    return line < end && *line == '#';
+}
+
 static int bake_amalgamate_file(
-    const bake_amalgamate_ctx_t *ctx,
-    FILE *out,
+    bake_amalgamate_ctx_t *ctx,
+    bake_amalg_out_t *out,
     bool is_include,
     const char *file,
     const char *src_file,
     int32_t src_line,
-    bake_strlist_t *parsed,
     bool *main_included)
 {
-    if (!bake_path_mark_parsed(parsed, file)) {
+    const char *resolved = bake_amalgamate_resolve(ctx, file);
+    if (resolved && !bake_amalgamate_mark_parsed(ctx, resolved)) {
         return 0;
     }
 
-    FILE *in = fopen(file, "rb");
-    if (!in) {
+    bake_file_map_t map;
+    if (!resolved || bake_file_map(file, &map) != 0) {
         ecs_err(
             "cannot read file '%s' while amalgamating '%s' (from '%s:%d')",
             file, ctx->cfg->id, src_file, src_line);
         return -1;
     }
 
+    bake_strlist_append(ctx->inputs, file);
+
+    int rc = -1;
     char *cur_path = bake_path_dirname(file);
     char *base_name = bake_path_basename(file);
     bool bake_config_h = base_name && !strcmp(base_name, "bake_config.h");
     ecs_os_free(base_name);
 
-    char line[BAKE_AMALG_MAX_LINE];
+    const char *cur = map.data;
+    const char *end = map.data + map.len;
     int32_t line_count = 0;
     bool in_block_comment = false;
     bool skip_continuation = false;
@@ -461,51 +1054,36 @@ static int bake_amalgamate_file(
     bake_cond_frame_t cond_stack[BAKE_AMALG_MAX_COND];
     int32_t cond_depth = 0;
     int32_t suppressed = 0;
-    while (fgets(line, BAKE_AMALG_MAX_LINE, in)) {
+    while (cur < end) {
+        const char *nl = memchr(cur, '\n', (size_t)(end - cur));
+        const char *line_start = cur;
+        const char *line_end = nl ? nl + 1 : end;
+        size_t line_len = (size_t)(line_end - line_start);
+        cur = line_end;
         line_count++;
 
         if (skip_continuation) {
-            skip_continuation = bake_line_continues(line);
+            skip_continuation = bake_line_continues(line_start, line_end);
             continue;
         }
 
         bool line_in_block_comment_at_start = in_block_comment;
-        const char *scan = line;
-        while (*scan) {
-            if (in_block_comment) {
-                if (scan[0] == '*' && scan[1] == '/') {
-                    in_block_comment = false;
-                    scan += 2;
-                    continue;
-                }
-                scan++;
-                continue;
-            }
-            if (scan[0] == '/' && scan[1] == '/') {
-                break;
-            }
-            if (scan[0] == '/' && scan[1] == '*') {
-                in_block_comment = true;
-                scan += 2;
-                continue;
-            }
-            if (scan[0] == '"' || scan[0] == '\'') {
-                char quote = *scan++;
-                while (*scan && *scan != quote) {
-                    if (scan[0] == '\\' && scan[1]) {
-                        scan++;
-                    }
-                    scan++;
-                }
-                if (*scan) {
-                    scan++;
-                }
-                continue;
+        in_block_comment = bake_scan_block_comments(
+            line_start, line_end, in_block_comment);
+
+        /* Only directives need parsing; everything else is copied as is. */
+        if (line_in_block_comment_at_start ||
+            !bake_line_is_directive(line_start, line_end))
+        {
+            if (suppressed == 0) {
+                bake_amalg_out_write(out, line_start, line_len);
             }
-            scan++;
+            continue;
         }
 
-        if (has_disable && !line_in_block_comment_at_start) {
+        char *line = bake_amalgamate_line(ctx, line_start, line_len);
+
+        if (has_disable) {
             const char *arg = NULL;
             bake_cpp_directive_kind_t directive =
                 bake_parse_cpp_directive(line, &arg);
@@ -518,9 +1096,7 @@ static int bake_amalgamate_file(
                     ecs_err(
                         "preprocessor nesting too deep while amalgamating '%s'",
                         file);
-                    ecs_os_free(cur_path);
-                    fclose(in);
-                    return -1;
+                    goto cleanup;
                 }
 
                 bool body_emit = true;
@@ -539,7 +1115,7 @@ static int bake_amalgamate_file(
                     frame->emit = true;
                     frame->taken = false;
                     if (suppressed == 0) {
-                        fprintf(out, "%s", line);
+                        bake_amalg_out_write(out, line_start, line_len);
                     }
                 }
                 continue;
@@ -561,7 +1137,7 @@ static int bake_amalgamate_file(
                         frame->taken = true;
                     }
                 } else if (suppressed == 0) {
-                    fprintf(out, "%s", line);
+                    bake_amalg_out_write(out, line_start, line_len);
                 }
                 continue;
             }
@@ -598,12 +1174,13 @@ static int bake_amalgamate_file(
                             frame->emit = true;
                             frame->managed = false;
                             if (suppressed == 0) {
-                                fprintf(out, "#if%s", arg);
+                                bake_amalg_out_str(out, "#if");
+                                bake_amalg_out_str(out, arg);
                             }
                         }
                     }
                 } else if (suppressed == 0) {
-                    fprintf(out, "%s", line);
+                    bake_amalg_out_write(out, line_start, line_len);
                 }
                 continue;
             }
@@ -615,7 +1192,7 @@ static int bake_amalgamate_file(
                         suppressed--;
                     }
                 } else if (suppressed == 0) {
-                    fprintf(out, "%s", line);
+                    bake_amalg_out_write(out, line_start, line_len);
                 }
                 continue;
             }
@@ -625,25 +1202,20 @@ static int bake_amalgamate_file(
             continue;
         }
 
-        if (has_disable && !line_in_block_comment_at_start &&
-            bake_is_disabled_define(line, ctx->disable))
-        {
-            skip_continuation = bake_line_continues(line);
+        if (has_disable && bake_is_disabled_define(line, ctx->disable)) {
+            skip_continuation = bake_line_continues(line_start, line_end);
             continue;
         }
 
         bool include_relative = false;
-        char *include = NULL;
-        if (!line_in_block_comment_at_start) {
-            include = bake_parse_include_file(line, &include_relative);
-        }
+        char *include = bake_parse_include_file(line, &include_relative);
         if (!include) {
-            fprintf(out, "%s", line);
+            bake_amalg_out_write(out, line_start, line_len);
             continue;
         }
 
         if (!is_include && main_included && !main_included[0]) {
-            fprintf(out, "#include \"%s.h\"\n", ctx->include_name);
+            bake_amalg_out_fmt(out, "#include \"%s.h\"\n", ctx->include_name);
             main_included[0] = true;
         }
 
@@ -652,21 +1224,21 @@ static int bake_amalgamate_file(
 
         if (!include_relative) {
             if (bake_config_h) {
-                fprintf(out, "#include \"%s\"\n", include);
+                bake_amalg_out_fmt(out, "#include \"%s\"\n", include);
                 ecs_os_free(include);
                 continue;
             }
 
             include_path = bake_path_join(ctx->include_path, include);
-            if (include_path && bake_path_exists(include_path)) {
+            if (include_path && bake_amalgamate_resolve(ctx, include_path)) {
                 recurse = true;
             }
         } else {
             include_path = cur_path ? bake_path_join(cur_path, include) : NULL;
-            if (!include_path || !bake_path_exists(include_path)) {
+            if (!include_path || !bake_amalgamate_resolve(ctx, include_path)) {
                 ecs_os_free(include_path);
                 include_path = bake_path_join(ctx->include_path, include);
-                if (include_path && bake_path_exists(include_path)) {
+                if (include_path && bake_amalgamate_resolve(ctx, include_path)) {
                     recurse = true;
                 } else {
                     ecs_os_free(include_path);
@@ -677,48 +1249,34 @@ static int bake_amalgamate_file(
             }
         }
 
+        int file_rc = 0;
         if (recurse) {
-            if (bake_amalgamate_file(
+            file_rc = bake_amalgamate_file(
                 ctx,
                 out,
                 is_include,
                 include_path,
                 file,
                 line_count,
-                parsed,
-                main_included) != 0)
-            {
-                ecs_os_free(include_path);
-                ecs_os_free(include);
-                ecs_os_free(cur_path);
-                fclose(in);
-                return -1;
-            }
+                main_included);
         } else {
-            fprintf(out, "%s", line);
+            bake_amalg_out_write(out, line_start, line_len);
         }
 
         ecs_os_free(include_path);
         ecs_os_free(include);
+        if (file_rc != 0) {
+            goto cleanup;
+        }
     }
 
-    fprintf(out, "\n");
-    ecs_os_free(cur_path);
-
-    if (ferror(in)) {
-        ecs_err("read error while amalgamating '%s'", file);
-        fclose(in);
-        return -1;
-    }
-
-    if (ferror(out)) {
-        ecs_err("write error while amalgamating '%s'", file);
-        fclose(in);
-        return -1;
-    }
+    bake_amalg_out_write(out, "\n", 1);
+    rc = 0;
 
-    fclose(in);
-    return 0;
+cleanup:
+    ecs_os_free(cur_path);
+    bake_file_unmap(&map);
+    return rc;
 }
 
 static void bake_try_source_name(
@@ -765,14 +1323,6 @@ static char* bake_find_main_src_file(
     return found;
 }
 
-static bool bake_is_supported_source(const char *path) {
-    return bake_has_suffix(path, ".c") ||
-        bake_has_suffix(path, ".cpp") ||
-        bake_has_suffix(path, ".cc") ||
-        bake_has_suffix(path, ".cxx") ||
-        bake_has_suffix(path, ".C");
-}
-
 static int bake_collect_source_files_visit(const bake_dir_entry_t *entry, void *ctx_ptr) {
     bake_collect_sources_ctx_t *ctx = ctx_ptr;
     if (entry->is_dir) {
@@ -816,109 +1366,213 @@ static int bake_collect_source_files(
     return 0;
 }
 
-static bool bake_comment_has_file_directive(const char *start, const char *end) {
-    for (const char *q = start; q + 5 <= end; q++) {
-        if ((q[0] == '@' || q[0] == '\\') &&
-            q[1] == 'f' && q[2] == 'i' && q[3] == 'l' && q[4] == 'e' &&
-            (q + 5 == end || !bake_is_ident_char(q[5])))
-        {
-            return true;
-        }
+/* Amalgamation manifest. Records everything an amalgamation was generated
+ * from, so that a build with unchanged inputs can skip regenerating it:
+ *
+ *   version <n>
+ *   key <hash of project id, output name, main files and source list>
+ *   disable <flag>
+ *   out <size> <mtime> <path>
+ *   in <size> <mtime> <hash> <path>
+ *   absent <path>
+ *
+ * Inputs whose size and mtime match are assumed unchanged; otherwise their
+ * content hash decides. Outputs must match exactly, so hand-edited or stale
+ * outputs are always regenerated. */
+
+#define BAKE_AMALG_MANIFEST_VERSION (2)
+
+static char* bake_amalgamation_manifest_path(
+    const char *build_root,
+    const char *output_base,
+    const char *include_out)
+{
+    uint64_t hash = bake_hash(BAKE_HASH_INIT, include_out, strlen(include_out));
+    return flecs_asprintf("%s/amalgamate/%s.%016llx.manifest",
+        build_root, output_base, (unsigned long long)hash);
+}
+
+static int bake_amalgamation_file_hash(const char *path, uint64_t *hash_out) {
+    bake_file_map_t map;
+    if (bake_file_map(path, &map) != 0) {
+        return -1;
     }
-    return false;
+    *hash_out = bake_hash(BAKE_HASH_INIT, map.data, map.len);
+    bake_file_unmap(&map);
+    return 0;
 }
 
-static char* bake_clean_amalgamation(const char *in, size_t in_len) {
-    char *out = ecs_os_malloc(in_len + 1);
-    size_t w = 0;
-    int newline_run = 2;
-    const char *p = in;
-    const char *in_end = in + in_len;
+static int bake_amalgamation_write_manifest(
+    const char *manifest_path,
+    uint64_t key,
+    const bake_strlist_t *disable,
+    const char *include_out,
+    const char *src_out,
+    const bake_strlist_t *inputs,
+    const bake_strlist_t *absent)
+{
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    ecs_strbuf_append(&buf, "version %d\n", BAKE_AMALG_MANIFEST_VERSION);
+    ecs_strbuf_append(&buf, "key %016llx\n", (unsigned long long)key);
 
-    while (*p) {
-        char c = *p;
+    for (int32_t i = 0; i < disable->count; i++) {
+        ecs_strbuf_append(&buf, "disable %s\n", disable->items[i]);
+    }
 
-        if (c == '"' || c == '\'') {
-            char quote = c;
-            out[w++] = *p++;
-            while (*p) {
-                if (*p == '\\' && p[1]) {
-                    out[w++] = *p++;
-                    out[w++] = *p++;
-                    continue;
-                }
-                char s = *p;
-                out[w++] = *p++;
-                if (s == quote) {
-                    break;
-                }
-            }
-            newline_run = 0;
-            continue;
-        }
+    const char *outputs[] = { include_out, src_out };
+    for (int32_t i = 0; i < 2; i++) {
+        ecs_strbuf_append(&buf, "out %lld %lld %s\n",
+            (long long)bake_os_file_size(outputs[i]),
+            (long long)bake_os_file_mtime(outputs[i]),
+            outputs[i]);
+    }
 
-        if (c == '/' && p[1] == '/') {
-            while (*p && *p != '\n') {
-                out[w++] = *p++;
-            }
-            newline_run = 0;
-            continue;
+    for (int32_t i = 0; i < inputs->count; i++) {
+        uint64_t hash = 0;
+        if (bake_amalgamation_file_hash(inputs->items[i], &hash) != 0) {
+            ecs_strbuf_reset(&buf);
+            return -1;
         }
+        ecs_strbuf_append(&buf, "in %lld %lld %016llx %s\n",
+            (long long)bake_os_file_size(inputs->items[i]),
+            (long long)bake_os_file_mtime(inputs->items[i]),
+            (unsigned long long)hash,
+            inputs->items[i]);
+    }
 
-        if (c == '/' && p[1] == '*') {
-            const char *end = strstr(p + 2, "*/");
-            const char *comment_end = end ? end + 2 : in_end;
-            if (bake_comment_has_file_directive(p, comment_end)) {
-                p = comment_end;
-                continue;
-            }
-            while (p < comment_end) {
-                out[w++] = *p++;
-            }
-            newline_run = 0;
-            continue;
-        }
+    for (int32_t i = 0; i < absent->count; i++) {
+        ecs_strbuf_append(&buf, "absent %s\n", absent->items[i]);
+    }
 
-        if (c == '\n') {
-            if (newline_run >= 2) {
-                p++;
-                continue;
+    char *content = ecs_strbuf_get(&buf);
+    int rc = bake_file_write(manifest_path, content);
+    ecs_os_free(content);
+    return rc;
+}
+
+/* Splits the next line off a manifest. Returns false at the end. */
+static bool bake_amalgamation_manifest_line(
+    const char **cur,
+    const char *end,
+    char *line,
+    size_t line_size)
+{
+    if (*cur >= end) {
+        return false;
+    }
+    const char *nl = memchr(*cur, '\n', (size_t)(end - *cur));
+    const char *line_end = nl ? nl : end;
+    size_t len = (size_t)(line_end - *cur);
+    if (len >= line_size) {
+        len = line_size - 1;
+    }
+    memcpy(line, *cur, len);
+    line[len] = '\0';
+    *cur = nl ? nl + 1 : end;
+    return true;
+}
+
+/* Returns true when the outputs recorded in the manifest are still what the
+ * current inputs would produce. Inputs that were touched without changing
+ * content are collected so the manifest can be refreshed. */
+static bool bake_amalgamation_up_to_date(
+    const char *manifest_path,
+    uint64_t key,
+    const bake_strlist_t *disable,
+    const char *include_out,
+    const char *src_out,
+    bake_strlist_t *inputs,
+    bake_strlist_t *absent,
+    bool *touched_out)
+{
+    bake_file_map_t map;
+    if (bake_file_map(manifest_path, &map) != 0) {
+        return false;
+    }
+
+    const char *cur = map.data;
+    const char *end = map.data + map.len;
+    char line[PATH_MAX + 128];
+    bool ok = true;
+    int32_t version = 0;
+    uint64_t manifest_key = 0;
+    int32_t disable_count = 0;
+    int32_t out_count = 0;
+    *touched_out = false;
+
+    while (ok && bake_amalgamation_manifest_line(&cur, end, line, sizeof(line))) {
+        long long size = 0, mtime = 0;
+        unsigned long long hash = 0;
+        int path_offset = 0;
+
+        if (!strncmp(line, "version ", 8)) {
+            version = atoi(line + 8);
+        } else if (!strncmp(line, "key ", 4)) {
+            manifest_key = strtoull(line + 4, NULL, 16);
+        } else if (!strncmp(line, "disable ", 8)) {
+            ok = disable_count < disable->count &&
+                !strcmp(line + 8, disable->items[disable_count]);
+            disable_count++;
+        } else if (!strncmp(line, "out ", 4)) {
+            ok = sscanf(line + 4, "%lld %lld %n", &size, &mtime, &path_offset) == 2;
+            const char *path = line + 4 + path_offset;
+            const char *expect = out_count == 0 ? include_out : src_out;
+            ok = ok && out_count < 2 && !strcmp(path, expect) &&
+                bake_os_file_size(path) == size &&
+                bake_os_file_mtime(path) == mtime;
+            out_count++;
+        } else if (!strncmp(line, "in ", 3)) {
+            ok = sscanf(line + 3, "%lld %lld %llx %n",
+                &size, &mtime, &hash, &path_offset) == 3;
+            const char *path = line + 3 + path_offset;
+            if (ok && (bake_os_file_size(path) != size ||
+                bake_os_file_mtime(path) != mtime))
+            {
+                uint64_t cur_hash = 0;
+                ok = bake_amalgamation_file_hash(path, &cur_hash) == 0 &&
+                    cur_hash == hash;
+                *touched_out = true;
             }
-            out[w++] = '\n';
-            newline_run++;
-            p++;
-            continue;
+            bake_strlist_append(inputs, path);
+        } else if (!strncmp(line, "absent ", 7)) {
+            ok = !bake_path_exists(line + 7);
+            bake_strlist_append(absent, line + 7);
+        } else if (line[0]) {
+            ok = false;
         }
-
-        out[w++] = c;
-        newline_run = 0;
-        p++;
     }
 
-    out[w] = '\0';
-    return out;
+    bake_file_unmap(&map);
+
+    return ok &&
+        version == BAKE_AMALG_MANIFEST_VERSION &&
+        manifest_key == key &&
+        disable_count == disable->count &&
+        out_count == 2;
 }
 
-static int bake_finalize_amalgamation(
-    const char *tmp_file,
-    const char *out_file)
+static uint64_t bake_amalgamation_key(
+    const char *project_id,
+    const char *output_base,
+    const char *main_header,
+    const char *main_src,
+    const bake_strlist_t *sources)
 {
-    size_t len = 0;
-    char *raw = bake_file_read(tmp_file, &len);
-    remove(tmp_file);
-    if (!raw) {
-        return -1;
+    const char *parts[] = { project_id, output_base, main_header, main_src };
+    uint64_t key = BAKE_HASH_INIT;
+    for (int32_t i = 0; i < 4; i++) {
+        const char *part = parts[i] ? parts[i] : "";
+        key = bake_hash(key, part, strlen(part) + 1);
     }
-
-    char *cleaned = bake_clean_amalgamation(raw, len);
-    ecs_os_free(raw);
-    int rc = bake_file_write(out_file, cleaned);
-    ecs_os_free(cleaned);
-    return rc;
+    for (int32_t i = 0; i < sources->count; i++) {
+        key = bake_hash(key, sources->items[i], strlen(sources->items[i]) + 1);
+    }
+    return key;
 }
 
 static int bake_generate_one_amalgamation(
     const bake_project_cfg_t *cfg,
+    const char *build_root,
     const char *project_id,
     const char *include_path,
     const char *src_path,
@@ -928,18 +1582,31 @@ static int bake_generate_one_amalgamation(
     int rc = -1;
     char *output_path = NULL;
     char *include_out = NULL;
-    char *include_tmp = NULL;
     char *src_out = NULL;
-    char *src_tmp = NULL;
     char *main_src = NULL;
-    FILE *include_fp = NULL;
-    FILE *src_fp = NULL;
+    char *manifest_path = NULL;
     bool main_included = false;
-    bake_strlist_t parsed = {0};
     bake_strlist_t sources = {0};
+    bake_strlist_t inputs = {0};
+    bake_strlist_t absent = {0};
+    bake_amalg_out_t h_out;
+    bake_amalg_out_t c_out;
+
+    bake_amalgamate_ctx_t ctx = {
+        .cfg = cfg,
+        .include_path = include_path,
+        .disable = &amalg->disable_flags,
+        .inputs = &inputs,
+        .absent = &absent
+    };
+    ecs_map_init(&ctx.realpaths, NULL);
+    ecs_map_init(&ctx.parsed, NULL);
+    bake_amalg_out_init(&h_out);
+    bake_amalg_out_init(&c_out);
 
     const char *output_base =
         (amalg->prefix && amalg->prefix[0]) ? amalg->prefix : project_id;
+    ctx.include_name = output_base;
 
     output_path = (amalg->path && amalg->path[0]) ?
         bake_path_join(cfg->path, amalg->path) : ecs_os_strdup(cfg->path);
@@ -949,50 +1616,50 @@ static int bake_generate_one_amalgamation(
 
     const char *src_ext = bake_language_is_cpp(cfg) ? "cpp" : "c";
     include_out = flecs_asprintf("%s/%s.h", output_path, output_base);
-    include_tmp = flecs_asprintf("%s/%s.h.tmp", output_path, output_base);
     src_out = flecs_asprintf("%s/%s.%s", output_path, output_base, src_ext);
-    src_tmp = flecs_asprintf("%s/%s.%s.tmp", output_path, output_base, src_ext);
-
-    bake_amalgamate_ctx_t ctx = {
-        .cfg = cfg,
-        .include_name = output_base,
-        .include_path = include_path,
-        .disable = &amalg->disable_flags
-    };
 
-    bake_strlist_init(&parsed);
+    bake_strlist_init(&sources);
+    bake_strlist_init(&inputs);
+    bake_strlist_init(&absent);
 
-    include_fp = fopen(include_tmp, "wb");
-    if (!include_fp) {
+    main_src = bake_find_main_src_file(cfg, src_path, project_id);
+    if (bake_collect_source_files(src_path, &sources) != 0) {
         goto cleanup;
     }
 
-    fprintf(include_fp, "// Comment out this line when using as DLL\n");
-    fprintf(include_fp, "#define %s_STATIC\n", project_id);
-    if (bake_amalgamate_file(
-        &ctx, include_fp, true, main_header, "(main header)", 0,
-        &parsed, NULL) != 0)
+    uint64_t key = bake_amalgamation_key(
+        project_id, output_base, main_header, main_src, &sources);
+    manifest_path = bake_amalgamation_manifest_path(
+        build_root, output_base, include_out);
+
+    bool touched = false;
+    if (bake_amalgamation_up_to_date(manifest_path, key, &amalg->disable_flags,
+        include_out, src_out, &inputs, &absent, &touched))
     {
+        /* Refresh recorded mtimes so touched inputs aren't hashed again. */
+        if (touched && bake_amalgamation_write_manifest(manifest_path, key,
+            &amalg->disable_flags, include_out, src_out, &inputs, &absent) != 0)
+        {
+            goto cleanup;
+        }
+        rc = 0;
         goto cleanup;
     }
-    fclose(include_fp);
-    include_fp = NULL;
 
-    src_fp = fopen(src_tmp, "wb");
-    if (!src_fp) {
-        goto cleanup;
-    }
+    bake_strlist_fini(&inputs);
+    bake_strlist_fini(&absent);
 
-    main_src = bake_find_main_src_file(cfg, src_path, project_id);
-    if (main_src && bake_amalgamate_file(
-        &ctx, src_fp, false, main_src, "(main source)", 0,
-        &parsed, &main_included) != 0)
+    bake_amalg_out_str(&h_out, "// Comment out this line when using as DLL\n");
+    bake_amalg_out_fmt(&h_out, "#define %s_STATIC\n", project_id);
+    if (bake_amalgamate_file(
+        &ctx, &h_out, true, main_header, "(main header)", 0, NULL) != 0)
     {
         goto cleanup;
     }
 
-    bake_strlist_init(&sources);
-    if (bake_collect_source_files(src_path, &sources) != 0) {
+    if (main_src && bake_amalgamate_file(
+        &ctx, &c_out, false, main_src, "(main source)", 0, &main_included) != 0)
+    {
         goto cleanup;
     }
 
@@ -1001,53 +1668,115 @@ static int bake_generate_one_amalgamation(
             continue;
         }
         if (bake_amalgamate_file(
-            &ctx, src_fp, false, sources.items[i], "(source)", 0,
-            &parsed, &main_included) != 0)
+            &ctx, &c_out, false, sources.items[i], "(source)", 0,
+            &main_included) != 0)
         {
             goto cleanup;
         }
     }
 
     if (!main_included) {
-        fprintf(src_fp, "#include \"%s.h\"\n", output_base);
+        bake_amalg_out_fmt(&c_out, "#include \"%s.h\"\n", output_base);
     }
-    fclose(src_fp);
-    src_fp = NULL;
 
-    if (bake_finalize_amalgamation(include_tmp, include_out) != 0 ||
-        bake_finalize_amalgamation(src_tmp, src_out) != 0)
+    if (bake_amalg_out_flush(&h_out, include_out) != 0 ||
+        bake_amalg_out_flush(&c_out, src_out) != 0)
+    {
+        goto cleanup;
+    }
+
+    if (bake_amalgamation_write_manifest(manifest_path, key,
+        &amalg->disable_flags, include_out, src_out, &inputs, &absent) != 0)
     {
         goto cleanup;
     }
 
     rc = 0;
 cleanup:
-    if (include_fp) {
-        fclose(include_fp);
-    }
-    if (src_fp) {
-        fclose(src_fp);
-    }
-    if (rc != 0) {
-        if (include_tmp) {
-            remove(include_tmp);
-        }
-        if (src_tmp) {
-            remove(src_tmp);
-        }
-    }
+    bake_amalg_out_fini(&h_out);
+    bake_amalg_out_fini(&c_out);
+    ecs_map_fini(&ctx.realpaths);
+    ecs_map_fini(&ctx.parsed);
+    bake_strtable_fini(&ctx.paths);
+    ecs_os_free(ctx.line);
     bake_strlist_fini(&sources);
-    bake_strlist_fini(&parsed);
+    bake_strlist_fini(&inputs);
+    bake_strlist_fini(&absent);
+    ecs_os_free(manifest_path);
     ecs_os_free(output_path);
     ecs_os_free(include_out);
-    ecs_os_free(include_tmp);
     ecs_os_free(src_out);
-    ecs_os_free(src_tmp);
     ecs_os_free(main_src);
     return rc;
 }
 
-int bake_generate_project_amalgamation(const bake_project_cfg_t *cfg) {
+/* Amalgamate entries share nothing but the project configuration, so they are
+ * generated by a small worker pool, like compile units. */
+typedef struct bake_amalgamate_jobs_t {
+    const bake_project_cfg_t *cfg;
+    const char *build_root;
+    const char *project_id;
+    const char *include_path;
+    const char *src_path;
+    const char *main_header;
+    int32_t count;
+    int32_t cursor;
+    int32_t failed;
+} bake_amalgamate_jobs_t;
+
+static void* bake_amalgamate_worker(void *arg) {
+    bake_amalgamate_jobs_t *jobs = arg;
+
+    for (;;) {
+        if (jobs->failed) {
+            break;
+        }
+
+        int32_t index = ecs_os_ainc(&jobs->cursor) - 1;
+        if (index >= jobs->count) {
+            break;
+        }
+
+        const bake_amalgamate_cfg_t *amalg =
+            bake_amalgamate_list_get(&jobs->cfg->amalgamate, index);
+        if (bake_generate_one_amalgamation(
+            jobs->cfg, jobs->build_root, jobs->project_id, jobs->include_path,
+            jobs->src_path, jobs->main_header, amalg) != 0)
+        {
+            ecs_os_ainc(&jobs->failed);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static bool bake_amalgamate_str_eq(const char *a, const char *b) {
+    return !strcmp(a ? a : "", b ? b : "");
+}
+
+/* Entries writing the same files can't run concurrently. */
+static bool bake_amalgamate_outputs_overlap(const bake_project_cfg_t *cfg) {
+    int32_t count = bake_amalgamate_list_count(&cfg->amalgamate);
+    for (int32_t i = 0; i < count; i++) {
+        const bake_amalgamate_cfg_t *a = bake_amalgamate_list_get(&cfg->amalgamate, i);
+        for (int32_t j = i + 1; j < count; j++) {
+            const bake_amalgamate_cfg_t *b = bake_amalgamate_list_get(&cfg->amalgamate, j);
+            if (bake_amalgamate_str_eq(a->path, b->path) &&
+                bake_amalgamate_str_eq(a->prefix, b->prefix))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int bake_generate_project_amalgamation(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const char *build_root)
+{
     if (!cfg) {
         return 0;
     }
@@ -1058,6 +1787,7 @@ int bake_generate_project_amalgamation(const bake_project_cfg_t *cfg) {
     }
 
     int rc = -1;
+    ecs_os_thread_t *threads = NULL;
     char *project_id = bake_project_id_as_macro(cfg->id);
     char *include_path = bake_path_join(cfg->path, "include");
     char *src_path = bake_path_join(cfg->path, "src");
@@ -1085,18 +1815,45 @@ int bake_generate_project_amalgamation(const bake_project_cfg_t *cfg) {
         goto cleanup;
     }
 
-    rc = 0;
-    for (int32_t i = 0; i < count; i++) {
-        const bake_amalgamate_cfg_t *amalg = bake_amalgamate_list_get(&cfg->amalgamate, i);
-        if (bake_generate_one_amalgamation(
-            cfg, project_id, include_path, src_path, main_header, amalg) != 0)
-        {
-            rc = -1;
-            goto cleanup;
+    bake_amalgamate_jobs_t jobs = {
+        .cfg = cfg,
+        .build_root = build_root,
+        .project_id = project_id,
+        .include_path = include_path,
+        .src_path = src_path,
+        .main_header = main_header,
+        .count = count
+    };
+
+    int32_t workers = ctx ? ctx->thread_count : 1;
+    if (workers > count) {
+        workers = count;
+    }
+    if (workers < 2 || bake_amalgamate_outputs_overlap(cfg)) {
+        bake_amalgamate_worker(&jobs);
+        rc = jobs.failed ? -1 : 0;
+        goto cleanup;
+    }
+
+    threads = ecs_os_malloc_n(ecs_os_thread_t, workers);
+    int32_t started = 0;
+    for (int32_t i = 0; i < workers; i++) {
+        threads[i] = ecs_os_thread_new(bake_amalgamate_worker, &jobs);
+        if (!threads[i]) {
+            ecs_os_ainc(&jobs.failed);
+            break;
         }
+        started++;
     }
 
+    for (int32_t i = 0; i < started; i++) {
+        ecs_os_thread_join(threads[i]);
+    }
+
+    rc = (started && !jobs.failed) ? 0 : -1;
+
 cleanup:
+    ecs_os_free(threads);
     ecs_os_free(project_id);
     ecs_os_free(include_path);
     ecs_os_free(src_path);
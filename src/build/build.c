@@ -119,7 +119,15 @@ static int bake_write_standalone_dep_header(
     char *header_path = bake_path_join(deps_dir, header_name);
     char *header_content = flecs_asprintf("#pragma once\n#include <%s>\n", header_name);
 
-    int rc = bake_file_write(header_path, header_content);
+    /* The header may still be linked to a cached amalgamation; replace the
+     * link instead of writing through it. */
+    int rc = 0;
+    if (!bake_file_equals(header_path, header_content, strlen(header_content))) {
+        rc = bake_remove_file_if_exists(header_path);
+    }
+    if (rc == 0) {
+        rc = bake_file_write(header_path, header_content);
+    }
 
     ecs_os_free(header_base);
     ecs_os_free(header_name);
@@ -128,23 +136,15 @@ static int bake_write_standalone_dep_header(
     return rc;
 }
 
-static void bake_track_standalone_dep_outputs(
+static void bake_track_standalone_dep_header(
     const bake_project_cfg_t *cfg,
-    bool emit_sources,
     bake_strlist_t *expected_outputs)
 {
     char *base = bake_project_id_as_macro(cfg->id);
     char *header_name = flecs_asprintf("%s.h", base);
-    char *source_name = emit_sources ? flecs_asprintf("%s.c", base) : NULL;
-
     bake_strlist_append_unique(expected_outputs, header_name);
-    if (emit_sources) {
-        bake_strlist_append_unique(expected_outputs, source_name);
-    }
-
     ecs_os_free(base);
     ecs_os_free(header_name);
-    ecs_os_free(source_name);
 }
 
 static int bake_cleanup_standalone_outputs(
@@ -179,7 +179,8 @@ static int bake_prepare_standalone_sources(
     bake_context_t *ctx,
     ecs_entity_t project_entity,
     const bake_project_cfg_t *cfg,
-    bool emit_sources)
+    bool emit_sources,
+    bake_strlist_t *shared_sources)
 {
     int rc = -1;
     char *deps_dir = bake_path_join(cfg->path, "deps");
@@ -206,16 +207,17 @@ static int bake_prepare_standalone_sources(
             continue;
         }
 
-        bake_track_standalone_dep_outputs(dep_project->cfg, emit_sources, &expected_outputs);
-
         if (!emit_sources) {
+            bake_track_standalone_dep_header(dep_project->cfg, &expected_outputs);
             if (bake_write_standalone_dep_header(dep_project->cfg, deps_dir) != 0) {
                 goto cleanup;
             }
             continue;
         }
 
-        if (bake_amalgamate_project(dep_project->cfg, deps_dir) != 0) {
+        if (bake_amalgamate_project_cached(ctx, dep_project->cfg, deps_dir,
+            cfg->standalone_units, &expected_outputs, shared_sources) != 0)
+        {
             goto cleanup;
         }
     }
@@ -240,6 +242,43 @@ cleanup:
     return rc;
 }
 
+/* Dependency sources in deps/ are links to a cached amalgamation. Point their
+ * compile units at the cached file, so that the resulting object can be
+ * shared by every standalone application that vendors the same snapshot. */
+static void bake_share_standalone_units(
+    const bake_project_cfg_t *cfg,
+    bake_compile_list_t *units,
+    const bake_strlist_t *shared_sources)
+{
+    if (!shared_sources->count) {
+        return;
+    }
+
+    char *deps_dir = bake_path_join(cfg->path, "deps");
+    for (int32_t i = 0; i < units->count; i++) {
+        bake_compile_unit_t *unit = &units->items[i];
+        char *dir = bake_path_dirname(unit->src);
+        bool in_deps = dir && !strcmp(dir, deps_dir);
+        ecs_os_free(dir);
+        if (!in_deps) {
+            continue;
+        }
+
+        char *name = bake_path_basename(unit->src);
+        for (int32_t j = 0; j < shared_sources->count; j++) {
+            char *shared_name = bake_path_basename(shared_sources->items[j]);
+            bool match = !strcmp(name, shared_name);
+            ecs_os_free(shared_name);
+            if (match) {
+                unit->shared_src = ecs_os_strdup(shared_sources->items[j]);
+                break;
+            }
+        }
+        ecs_os_free(name);
+    }
+    ecs_os_free(deps_dir);
+}
+
 static void bake_fingerprint_append_list(
     ecs_strbuf_t *buf,
     const char *key,
@@ -264,10 +303,14 @@ static void bake_fingerprint_append_lang(
         lang->static_lib ? 1 : 0,
         lang->export_symbols ? 1 : 0,
         lang->precompile_header ? 1 : 0);
+    ecs_strbuf_append(buf, "%s.unity=%d\n", prefix, lang->unity);
+    ecs_strbuf_append(buf, "%s.pch=%s\n", prefix,
+        lang->precompile_header_file ? lang->precompile_header_file : "");
 
 #define L(f) bake_fingerprint_append_list(buf, prefix, &lang->f)
     L(cflags); L(cxxflags); L(defines); L(ldflags); L(libs);
     L(static_libs); L(libpaths); L(links); L(include_paths); L(embed);
+    L(unity_exclude);
 #undef L
 }
 
@@ -280,6 +323,7 @@ static void bake_fingerprint_append_lang(
  * timestamps. */
 static char* bake_compose_build_fingerprint(
     const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
     const BakeBuildRequest *request,
     const bake_lang_cfg_t *c_lang,
     const bake_lang_cfg_t *cpp_lang,
@@ -294,15 +338,22 @@ static char* bake_compose_build_fingerprint(
         exe ? (long long)bake_os_file_mtime(exe) : 0);
     ecs_os_free(exe);
 
-    ecs_strbuf_append(&buf, "cc=%s\ncxx=%s\nkind=%d\nmode=%s\nstrict=%d\ntarget=%s-%s\n",
+    ecs_strbuf_append(&buf, "cc=%s\ncxx=%s\nkind=%d\nmode=%s\nstrict=%d\nunity=%d\ninclude_report=%d\ninclude_root=%d\ntarget=%s-%s\n",
         ctx->opts.cc ? ctx->opts.cc : "",
         ctx->opts.cxx ? ctx->opts.cxx : "",
         (int)ctx->compiler_kind,
         bake_effective_mode(request->mode),
         ctx->opts.strict ? 1 : 0,
+        ctx->opts.unity,
+        ctx->opts.include_report ? 1 : 0,
+        ctx->opts.include_root ? 1 : 0,
         bake_target_arch(),
         bake_target_os());
 
+    /* Shared libraries compile objects with -fPIC. */
+    ecs_strbuf_append(&buf, "shared=%d\n",
+        bake_project_cfg_shared_library(cfg) ? 1 : 0);
+
     bake_fingerprint_append_lang(&buf, "c", c_lang);
     bake_fingerprint_append_lang(&buf, "cpp", cpp_lang);
     bake_fingerprint_append_list(&buf, "mode_cflags", mode_cflags);
@@ -351,6 +402,9 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
     bake_strlist_t mode_cxxflags = {0};
     bake_strlist_t mode_ldflags = {0};
     bake_compile_list_t units = {0};
+    bake_strlist_t shared_sources = {0};
+    bake_pch_t pch[2] = {{0}};
+    char *include_root[2] = {NULL, NULL};
 
     if (bake_build_paths_init(cfg, request->mode, &paths) != 0) {
         ecs_err("failed to initialize build paths for %s (path=%s)", cfg->id, cfg->path ? cfg->path : "<null>");
@@ -387,7 +441,7 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
     }
 
     if (bake_amalgamate_list_count(&cfg->amalgamate) > 0) {
-        if (bake_generate_project_amalgamation(cfg) != 0) {
+        if (bake_generate_project_amalgamation(ctx, cfg, paths.build_root) != 0) {
             ecs_err("amalgamation failed for %s", cfg->id);
             goto cleanup;
         }
@@ -398,9 +452,11 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
         goto cleanup;
     }
 
-    if ((request->standalone || cfg->standalone) && (cfg->kind == BAKE_PROJECT_APPLICATION || cfg->kind == BAKE_PROJECT_TEST)) {
+    /* Standalone builds compile their own copy of dependency headers. */
+    bool standalone = request->standalone || cfg->standalone;
+    if (standalone && (cfg->kind == BAKE_PROJECT_APPLICATION || cfg->kind == BAKE_PROJECT_TEST)) {
         if (bake_prepare_standalone_sources(
-            ctx, project_entity, cfg, request->standalone) != 0)
+            ctx, project_entity, cfg, request->standalone, &shared_sources) != 0)
         {
             ecs_err("standalone amalgamation failed for %s", cfg->id);
             goto cleanup;
@@ -430,6 +486,7 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
     bake_strlist_init(&mode_cxxflags);
     bake_strlist_init(&mode_ldflags);
     bake_add_mode_flags(request->mode, ctx->compiler_kind, &mode_cflags, &mode_cxxflags, &mode_ldflags);
+    bake_add_debug_info_flags(bake_project_debug_info(ctx, cfg), ctx->compiler_kind, &mode_cflags, &mode_cxxflags, &mode_ldflags);
     bake_add_strict_flags(ctx->opts.strict, ctx->compiler_kind, &mode_cflags, &mode_cxxflags, &mode_ldflags);
 
     if (cfg->kind == BAKE_PROJECT_TEST &&
@@ -459,6 +516,13 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
         goto cleanup;
     }
 
+    bake_share_standalone_units(cfg, &units, &shared_sources);
+
+    if (bake_unity_group_units(ctx, cfg, &paths, &c_lang, &cpp_lang, &units) != 0) {
+        ecs_err("failed to generate unity batches for %s", cfg->id);
+        goto cleanup;
+    }
+
     if (builtin_test_src) {
 #if defined(_WIN32)
         const char *obj_ext = ".obj";
@@ -479,23 +543,61 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
     }
 
     fingerprint = bake_compose_build_fingerprint(
-        ctx, request, &c_lang, &cpp_lang,
+        ctx, cfg, request, &c_lang, &cpp_lang,
         &mode_cflags, &mode_cxxflags, &mode_ldflags);
     fingerprint_path = bake_path_join(paths.build_root, ".bake_cmd");
-    char *prev_fingerprint = bake_file_read(fingerprint_path, NULL);
-    bool flags_changed = !prev_fingerprint ||
-        strcmp(prev_fingerprint, fingerprint) != 0;
-    ecs_os_free(prev_fingerprint);
+    bool flags_changed = !bake_file_equals(
+        fingerprint_path, fingerprint, strlen(fingerprint));
+
+    if (bake_precompile_headers(
+        ctx, project_entity, cfg, &paths, &units, &c_lang, &cpp_lang,
+        &mode_cflags, &mode_cxxflags, !standalone, flags_changed, pch) != 0)
+    {
+        ecs_err("failed to precompile headers for %s", cfg->id);
+        goto cleanup;
+    }
+
+    if ((ctx->opts.include_root || cfg->include_root) &&
+        ctx->compiler_kind != BAKE_COMPILER_MSVC)
+    {
+        bool has_lang[2] = {false, false};
+        for (int32_t i = 0; i < units.count; i++) {
+            has_lang[units.items[i].cpp ? 1 : 0] = true;
+        }
+        const bake_lang_cfg_t *langs[2] = { &c_lang, &cpp_lang };
+        for (int i = 0; i < 2; i++) {
+            if (has_lang[i] && bake_include_root_prepare(
+                ctx, project_entity, cfg, &paths, langs[i], i == 1, &pch[i],
+                &include_root[i]) != 0)
+            {
+                ecs_err("failed to create include root for %s", cfg->id);
+                goto cleanup;
+            }
+        }
+    }
 
     int32_t compiled_count = 0;
     if (bake_compile_units_parallel(
-        ctx, project_entity, cfg, &units, &c_lang, &cpp_lang,
-        &mode_cflags, &mode_cxxflags, flags_changed, &compiled_count) != 0)
+        ctx, project_entity, cfg, &paths, &units, &c_lang, &cpp_lang,
+        &mode_cflags, &mode_cxxflags, pch, include_root, flags_changed,
+        &compiled_count) != 0)
     {
         ecs_err("compilation failed for %s", cfg->id);
         goto cleanup;
     }
 
+    bake_process_usage_t usage = {0};
+    if (bake_usage_update(&paths, &units, &usage) != 0) {
+        ecs_warn("failed to write usage history for %s", cfg->id);
+    }
+
+    if (ctx->opts.include_report) {
+        bake_report_include_usage(ctx, project_entity, cfg, &units);
+    }
+    if (ctx->opts.usage_report) {
+        bake_report_usage(cfg, &units, &usage);
+    }
+
     char *artefact = NULL;
     bool linked = false;
     if (bake_link_project_binary(
@@ -518,7 +620,8 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
 
     BakeBuildResult result = {
         .status = 0,
-        .artefact = artefact
+        .artefact = artefact,
+        .usage = usage
     };
     ecs_set_ptr(ctx->world, project_entity, BakeBuildResult, &result);
 
@@ -527,12 +630,23 @@ static int bake_build_one(bake_context_t *ctx, ecs_entity_t project_entity, cons
         goto cleanup;
     }
 
+    if (bake_publish_shared_pch(ctx, project_entity, cfg, &c_lang, &cpp_lang,
+        &mode_cflags, &mode_cxxflags) != 0)
+    {
+        ecs_err("failed to publish precompiled header for %s", cfg->id);
+        goto cleanup;
+    }
+
     rc = 0;
 
 cleanup:
     ecs_os_free(fingerprint);
     ecs_os_free(fingerprint_path);
     bake_compile_list_fini(&units);
+    bake_strlist_fini(&shared_sources);
+    bake_pch_fini(pch);
+    ecs_os_free(include_root[0]);
+    ecs_os_free(include_root[1]);
     bake_strlist_fini(&mode_cflags);
     bake_strlist_fini(&mode_cxxflags);
     bake_strlist_fini(&mode_ldflags);
@@ -571,10 +685,23 @@ static int bake_validate_build_graph_dependencies(const ecs_world_t *world, ecs_
     return 0;
 }
 
+static ecs_entity_t bake_build_failed_dependency(const ecs_world_t *world, ecs_map_t *failed, ecs_entity_t entity) {
+    for (int32_t i = 0;; i++) {
+        ecs_entity_t dep = ecs_get_target(world, entity, BakeDependsOn, i);
+        if (!dep) {
+            return 0;
+        }
+        if (ecs_map_get(failed, (ecs_map_key_t)dep)) {
+            return dep;
+        }
+    }
+}
+
 static int bake_execute_build_graph(bake_context_t *ctx, const char *target, bool recursive, bool standalone) {
     bake_model_mark_build_targets(ctx->world, target, ctx->opts.mode, recursive, standalone);
 
     int rc = -1;
+    ecs_map_t failed = {0};
     ecs_entity_t *order = NULL;
     int32_t count = 0;
     if (bake_model_build_order(ctx->world, &order, &count) != 0) goto cleanup;
@@ -586,22 +713,47 @@ static int bake_execute_build_graph(bake_context_t *ctx, const char *target, boo
 
     if (bake_validate_build_graph_dependencies(ctx->world, order, count) != 0) goto cleanup;
 
+    /* With --keep-going a failed project only stops the projects that depend
+     * on it. Because projects build in dependency order, a project is skipped
+     * when one of its direct dependencies failed or was skipped. */
+    int32_t failed_count = 0;
+    ecs_map_init(&failed, NULL);
     for (int32_t i = 0; i < count; i++) {
         const BakeBuildRequest *req = ecs_get(ctx->world, order[i], BakeBuildRequest);
         if (!req) continue;
 
         const BakeProject *project = ecs_get(ctx->world, order[i], BakeProject);
+        ecs_entity_t failed_dep = bake_build_failed_dependency(ctx->world, &failed, order[i]);
+        if (failed_dep) {
+            const BakeProject *dep = ecs_get(ctx->world, failed_dep, BakeProject);
+            ecs_err("skipping %s: dependency %s failed",
+                project && project->cfg ? project->cfg->id : ecs_get_name(ctx->world, order[i]),
+                dep && dep->cfg ? dep->cfg->id : ecs_get_name(ctx->world, failed_dep));
+            ecs_map_insert(&failed, (ecs_map_key_t)order[i], 0);
+            continue;
+        }
+
         if (project && project->cfg && !project->external) {
             bake_log_build_header(ctx, project->cfg);
         }
 
         if (bake_build_one(ctx, order[i], req) != 0) {
-            goto cleanup;
+            if (!ctx->opts.keep_going) {
+                goto cleanup;
+            }
+            ecs_map_insert(&failed, (ecs_map_key_t)order[i], 0);
+            failed_count++;
         }
     }
+
+    if (failed_count) {
+        ecs_err("%d project%s failed to build", failed_count, failed_count == 1 ? "" : "s");
+        goto cleanup;
+    }
     rc = 0;
 
 cleanup:
+    ecs_map_fini(&failed);
     ecs_os_free(order);
     return rc;
 }
@@ -835,19 +987,20 @@ int bake_build_run(bake_context_t *ctx) {
     }
 
     if (!strcmp(ctx->opts.command, "run")) {
-        ecs_strbuf_t cmd = ECS_STRBUF_INIT;
+        /* Arguments are passed as is, the prefix is split like a command. */
+        bake_strlist_t argv;
+        bake_strlist_init(&argv);
         if (ctx->opts.run_prefix) {
-            ecs_strbuf_append(&cmd, "%s ", ctx->opts.run_prefix);
+            bake_strlist_append_args(&argv, ctx->opts.run_prefix);
         }
-
-        ecs_strbuf_append(&cmd, "\"%s\"", result->artefact);
+        bake_strlist_append(&argv, result->artefact);
         for (int i = 0; i < ctx->opts.run_argc; i++) {
-            ecs_strbuf_append(&cmd, " \"%s\"", ctx->opts.run_argv[i]);
+            bake_strlist_append(&argv, ctx->opts.run_argv[i]);
         }
+        bake_strlist_append_owned(&argv, NULL);
 
-        char *cmd_str = ecs_strbuf_get(&cmd);
-        rc = bake_run_command(cmd_str, true);
-        ecs_os_free(cmd_str);
+        rc = bake_run_argv((const char *const*)argv.items, NULL, true);
+        bake_strlist_fini(&argv);
         goto cleanup;
     }
 
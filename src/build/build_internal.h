@@ -7,7 +7,10 @@ typedef struct bake_compile_unit_t {
     char *src;
     char *obj;
     char *dep;
+    char *shared_src; /* cached copy of src, compiled into a shared object */
     bool cpp;
+    bool compiled;    /* compiled by this build, usage is measured */
+    bake_process_usage_t usage; /* of the last compile, see bake_usage_update */
 } bake_compile_unit_t;
 
 typedef struct bake_compile_list_t {
@@ -16,6 +19,18 @@ typedef struct bake_compile_list_t {
     int32_t capacity;
 } bake_compile_list_t;
 
+/* Precompiled header of one language. With GCC the directory is searched
+ * first, so that includes of the header find its .gch; Clang gets the file
+ * through -include-pch, only for units that include the header first.
+ * Directories of headers published by dependencies are
+ * searched the same way, after the directory of the project. */
+typedef struct bake_pch_t {
+    char *dir;
+    char *file;
+    bake_strlist_t shared_dirs;
+    int64_t shared_mtime; /* newest published header, 0 without any */
+} bake_pch_t;
+
 typedef struct bake_build_paths_t {
     char *build_root;
     char *obj_dir;
@@ -44,6 +59,13 @@ int bake_collect_compile_units(
     bool include_deps,
     bake_compiler_kind_t compiler_kind,
     bake_compile_list_t *units);
+int bake_unity_group_units(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_lang_cfg_t *c_lang,
+    const bake_lang_cfg_t *cpp_lang,
+    bake_compile_list_t *units);
 int bake_execute_rules(
     ecs_world_t *world,
     ecs_entity_t project_entity,
@@ -58,22 +80,109 @@ int bake_apply_dependee_cfg(
 
 bake_compiler_kind_t bake_detect_compiler_kind(const char *cc, const char *cxx);
 void bake_add_mode_flags(const char *mode, bake_compiler_kind_t kind, bake_strlist_t *cflags, bake_strlist_t *cxxflags, bake_strlist_t *ldflags);
+bake_debug_info_t bake_project_debug_info(const bake_context_t *ctx, const bake_project_cfg_t *cfg);
+void bake_add_debug_info_flags(bake_debug_info_t debug_info, bake_compiler_kind_t kind, bake_strlist_t *cflags, bake_strlist_t *cxxflags, bake_strlist_t *ldflags);
 void bake_add_strict_flags(bool strict, bake_compiler_kind_t kind, bake_strlist_t *cflags, bake_strlist_t *cxxflags, bake_strlist_t *ldflags);
-void bake_list_append_fmt(ecs_strbuf_t *buf, const bake_strlist_t *list, const char *prefix);
+void bake_argv_append_list(bake_strlist_t *argv, const bake_strlist_t *list, const char *prefix);
 char* bake_display_path(const char *full_path, const char *strip_prefix);
 
 int bake_compile_units_parallel(
     bake_context_t *ctx,
     ecs_entity_t project_entity,
     const bake_project_cfg_t *cfg,
-    const bake_compile_list_t *units,
+    const bake_build_paths_t *paths,
+    bake_compile_list_t *units,
     const bake_lang_cfg_t *lang,
     const bake_lang_cfg_t *cpp_lang,
     const bake_strlist_t *mode_cflags,
     const bake_strlist_t *mode_cxxflags,
+    const bake_pch_t *pch,
+    char *const *include_root,
     bool force_rebuild,
     int32_t *compiled_count_out);
 
+/* Creates or updates the include root of a language, see include_root.c.
+ * root_out is left NULL when include roots aren't supported. */
+int bake_include_root_prepare(
+    const bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_lang_cfg_t *lang,
+    bool cpp,
+    const bake_pch_t *pch,
+    char **root_out);
+
+/* Builds the precompiled headers of a project into pch, indexed by whether
+ * the language is C++. A header that fails to build is skipped. */
+int bake_precompile_headers(
+    bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_compile_list_t *units,
+    const bake_lang_cfg_t *lang,
+    const bake_lang_cfg_t *cpp_lang,
+    const bake_strlist_t *mode_cflags,
+    const bake_strlist_t *mode_cxxflags,
+    bool use_shared,
+    bool force_rebuild,
+    bake_pch_t pch[2]);
+void bake_pch_fini(bake_pch_t pch[2]);
+bool bake_compile_unit_uses_pch(const bake_compile_unit_t *unit);
+bool bake_pch_unit_includes_first(const bake_pch_t *pch, const bake_compile_unit_t *unit);
+
+/* Publishes a precompiled form of the main header of a package to BAKE_HOME,
+ * for dependents that are built with the same compiler, mode and standard. */
+int bake_publish_shared_pch(
+    bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_lang_cfg_t *lang,
+    const bake_lang_cfg_t *cpp_lang,
+    const bake_strlist_t *mode_cflags,
+    const bake_strlist_t *mode_cxxflags);
+
+/* Compiles a unit without the flags that identify the project, so that the
+ * output can be shared with other projects. */
+int bake_compile_unit_shared(
+    bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_compile_unit_t *unit,
+    const bake_lang_cfg_t *lang,
+    const bake_strlist_t *mode_flags);
+
+/* Prints which units include headers of each dependency, from their
+ * depfiles. */
+void bake_report_include_usage(
+    const bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_compile_list_t *units);
+
+/* Records the usage of compiled units in the usage history of the project,
+ * and restores the last recorded usage of units that are up to date. The
+ * project total is summed over all units with a record. */
+int bake_usage_update(
+    const bake_build_paths_t *paths,
+    bake_compile_list_t *units,
+    bake_process_usage_t *total_out);
+
+/* Prints the units with the highest CPU time and peak memory. */
+void bake_report_usage(
+    const bake_project_cfg_t *cfg,
+    const bake_compile_list_t *units,
+    const bake_process_usage_t *total);
+
+/* Returns the -fuse-ld value for a link with driver, or NULL to use its
+ * default linker. */
+const char* bake_select_linker(
+    bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const char *driver,
+    const char *probe_dir);
+
 int bake_link_project_binary(
     bake_context_t *ctx,
     ecs_entity_t project_entity,
@@ -86,7 +195,21 @@ int bake_link_project_binary(
     char **artefact_out,
     bool *linked_out);
 
-int bake_amalgamate_project(const bake_project_cfg_t *cfg, const char *dst_dir);
-int bake_generate_project_amalgamation(const bake_project_cfg_t *cfg);
+int bake_amalgamate_project(
+    const bake_project_cfg_t *cfg,
+    const char *dst_dir,
+    int32_t units,
+    bake_strlist_t *outputs);
+int bake_amalgamate_project_cached(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const char *dst_dir,
+    int32_t units,
+    bake_strlist_t *outputs,
+    bake_strlist_t *sources);
+int bake_generate_project_amalgamation(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const char *build_root);
 
 #endif
@@ -5,9 +5,17 @@
 
 #include <ctype.h>
 
-void bake_list_append_fmt(ecs_strbuf_t *buf, const bake_strlist_t *list, const char *prefix) {
+/* Flags come from project configuration, where a single entry may hold more
+ * than one argument. */
+void bake_argv_append_list(bake_strlist_t *argv, const bake_strlist_t *list, const char *prefix) {
     for (int32_t i = 0; i < list->count; i++) {
-        ecs_strbuf_append(buf, " %s%s", prefix, list->items[i]);
+        if (prefix[0]) {
+            char *arg = flecs_asprintf("%s%s", prefix, list->items[i]);
+            bake_strlist_append_args(argv, arg);
+            ecs_os_free(arg);
+        } else {
+            bake_strlist_append_args(argv, list->items[i]);
+        }
     }
 }
 
@@ -113,6 +121,49 @@ void bake_add_mode_flags(const char *mode, bake_compiler_kind_t kind, bake_strli
     }
 }
 
+bake_debug_info_t bake_project_debug_info(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg)
+{
+    bake_debug_info_t debug_info = cfg->debug_info;
+    if (ctx->opts.debug_info) {
+        bake_debug_info_parse(ctx->opts.debug_info, &debug_info);
+    }
+    return debug_info;
+}
+
+/* Split and compressed debug info are ELF features. They only apply to modes
+ * that generate debug info. */
+void bake_add_debug_info_flags(
+    bake_debug_info_t debug_info,
+    bake_compiler_kind_t kind,
+    bake_strlist_t *cflags,
+    bake_strlist_t *cxxflags,
+    bake_strlist_t *ldflags)
+{
+#if defined(__APPLE__) || defined(_WIN32)
+    (void)debug_info; (void)kind; (void)cflags; (void)cxxflags; (void)ldflags;
+#else
+    if (kind == BAKE_COMPILER_MSVC || bake_target_is_emscripten() ||
+        !bake_strlist_contains(cflags, "-g"))
+    {
+        return;
+    }
+
+    /* The link sees the split flag, so it can add a gdb index. */
+    if (debug_info & BAKE_DEBUG_INFO_SPLIT) {
+        bake_strlist_append(cflags, "-gsplit-dwarf");
+        bake_strlist_append(cxxflags, "-gsplit-dwarf");
+        bake_strlist_append(ldflags, "-gsplit-dwarf");
+    }
+    if (debug_info & BAKE_DEBUG_INFO_COMPRESSED) {
+        bake_strlist_append(cflags, "-gz");
+        bake_strlist_append(cxxflags, "-gz");
+        bake_strlist_append(ldflags, "-gz");
+    }
+#endif
+}
+
 void bake_add_strict_flags(
     bool strict,
     bake_compiler_kind_t kind,
@@ -196,6 +247,22 @@ static void bake_collect_dependency_link_inputs(
         bake_strlist_append(artefacts, result->artefact);
         char *libdir = bake_path_dirname(result->artefact);
         bake_strlist_append_unique(libpaths, libdir);
+
+        /* Binaries find shared libraries in the directory they were linked
+         * from, and next to them once copied to the lib directory of
+         * BAKE_HOME (bin/<binary> or bin/<id>/<binary>). */
+        if (bake_artefact_is_shared_library(result->artefact)) {
+            char *rpath = flecs_asprintf("-Wl,-rpath,%s", libdir);
+            bake_strlist_append_unique(ldflags, rpath);
+            ecs_os_free(rpath);
+#if defined(__APPLE__)
+            bake_strlist_append_unique(ldflags, "-Wl,-rpath,@loader_path/../lib");
+            bake_strlist_append_unique(ldflags, "-Wl,-rpath,@loader_path/../../lib");
+#else
+            bake_strlist_append_unique(ldflags, "-Wl,-rpath,$ORIGIN/../lib");
+            bake_strlist_append_unique(ldflags, "-Wl,-rpath,$ORIGIN/../../lib");
+#endif
+        }
         ecs_os_free(libdir);
     }
 
@@ -214,36 +281,179 @@ static void bake_collect_dependency_link_inputs(
 typedef struct bake_compile_ctx_t {
     bake_context_t *ctx;
     const bake_project_cfg_t *cfg;
-    const bake_compile_list_t *units;
+    bake_compile_list_t *units;
     const bake_lang_cfg_t *c_lang;
     const bake_lang_cfg_t *cpp_lang;
     const bake_strlist_t *mode_cflags;
     const bake_strlist_t *mode_cxxflags;
+    const bake_pch_t *pch;
+    char *const *include_root;
     bake_strlist_t dep_includes;
     bool *compile_mask;
     int32_t compile_total;
     int32_t compile_done;
-    ecs_os_mutex_t print_lock;
-    int32_t cursor;
     int32_t failed;
+    bool color;             /* compilers color diagnostics for the terminal */
+    bake_strlist_t prefix[2][2]; /* compile prefix per language, with(out) pch */
+    bake_procs_t *procs;
 } bake_compile_ctx_t;
 
+/* A compiler process that runs while the next units are started. */
+typedef struct bake_compile_job_t {
+    const bake_compile_unit_t *unit;
+    const char **argv;      /* borrows the prefix and args */
+    bake_strlist_t args;
+    char *publish_obj;      /* where a shared object is published once built */
+    char *publish_dep;
+} bake_compile_job_t;
+
+void bake_argv_append_fmt(bake_strlist_t *argv, const char *fmt, const char *value) {
+    bake_strlist_append_owned(argv, flecs_asprintf(fmt, value));
+}
+
+/* NULL-terminated argv that borrows the arguments of a prefix and a suffix. */
+static const char** bake_argv_view(
+    const bake_strlist_t *prefix,
+    const bake_strlist_t *args)
+{
+    int32_t prefix_count = prefix ? prefix->count : 0;
+    const char **argv = ecs_os_malloc_n(const char*, prefix_count + args->count + 1);
+    for (int32_t i = 0; i < prefix_count; i++) {
+        argv[i] = prefix->items[i];
+    }
+    for (int32_t i = 0; i < args->count; i++) {
+        argv[prefix_count + i] = args->items[i];
+    }
+    argv[prefix_count + args->count] = NULL;
+    return argv;
+}
+
+static void bake_trace_compiler_command(
+    const bake_context_t *ctx,
+    const char *const *argv)
+{
+    if (!ctx->opts.trace) {
+        return;
+    }
+
+    char *command = bake_argv_str(argv);
+    ecs_trace("%s", command);
+    ecs_os_free(command);
+}
+
 static int bake_run_compiler_command(
     const bake_context_t *ctx,
-    ecs_os_mutex_t print_lock,
-    const char *command)
+    const bake_strlist_t *prefix,
+    const bake_strlist_t *args)
 {
-    if (ctx->opts.trace) {
-        if (print_lock) {
-            ecs_os_mutex_lock(print_lock);
+    const char **argv = bake_argv_view(prefix, args);
+    bake_trace_compiler_command(ctx, argv);
+    int rc = bake_run_argv(argv, NULL, false);
+    ecs_os_free(argv);
+    return rc;
+}
+
+/* Commands longer than this pass their arguments in a response file. Link
+ * commands always do, as they grow with the number of objects. */
+#define BAKE_RSP_MIN_LENGTH (4096)
+
+/* MSVC splits response files like command lines, where backslashes are only
+ * special in front of a quote. */
+static void bake_rsp_append_arg_msvc(ecs_strbuf_t *buf, const char *arg) {
+    if (arg[0] && !strpbrk(arg, " \t\n\"")) {
+        ecs_strbuf_appendstr(buf, arg);
+        return;
+    }
+
+    ecs_strbuf_appendch(buf, '"');
+    int32_t backslashes = 0;
+    for (const char *p = arg; *p; p++) {
+        if (*p == '\\') {
+            backslashes++;
+            continue;
+        }
+        int32_t repeat = *p == '"' ? backslashes * 2 + 1 : backslashes;
+        for (int32_t i = 0; i < repeat; i++) {
+            ecs_strbuf_appendch(buf, '\\');
+        }
+        ecs_strbuf_appendch(buf, *p);
+        backslashes = 0;
+    }
+    for (int32_t i = 0; i < backslashes * 2; i++) {
+        ecs_strbuf_appendch(buf, '\\');
+    }
+    ecs_strbuf_appendch(buf, '"');
+}
+
+static bool bake_tool_reads_rsp(const char *tool) {
+#if defined(__APPLE__)
+    /* The archiver that comes with Xcode doesn't read response files. */
+    char *name = bake_path_basename(tool);
+    bool ar = !strcmp(name, "ar");
+    ecs_os_free(name);
+    return !ar;
+#else
+    (void)tool;
+    return true;
+#endif
+}
+
+static int32_t bake_argv_length(const bake_strlist_t *argv) {
+    int32_t length = 0;
+    for (int32_t i = 0; i < argv->count; i++) {
+        length += (int32_t)strlen(argv->items[i]) + 1;
+    }
+    return length;
+}
+
+/* Moves the arguments of a command into a response file, leaving the program
+ * and "@file". Files are only rewritten when their content changes. */
+static int bake_argv_to_rsp(
+    const bake_context_t *ctx,
+    bake_strlist_t *argv,
+    const char *path)
+{
+    if (argv->count < 2 || !bake_tool_reads_rsp(argv->items[0])) {
+        return 0;
+    }
+
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    for (int32_t i = 1; i < argv->count; i++) {
+        if (ctx->compiler_kind == BAKE_COMPILER_MSVC) {
+            bake_rsp_append_arg_msvc(&buf, argv->items[i]);
+        } else {
+            /* The quoting of bake_argv_str is also how gcc reads @files. */
+            const char *arg[] = { argv->items[i], NULL };
+            char *quoted = bake_argv_str(arg);
+            ecs_strbuf_appendstr(&buf, quoted);
+            ecs_os_free(quoted);
         }
-        ecs_trace("%s", command);
-        if (print_lock) {
-            ecs_os_mutex_unlock(print_lock);
+        ecs_strbuf_appendch(&buf, '\n');
+    }
+    char *content = ecs_strbuf_get(&buf);
+
+    int rc = bake_file_write(path, content);
+    if (rc != 0) {
+        ecs_err("failed to write response file %s", path);
+    } else {
+        if (ctx->opts.trace) {
+            const char **args = bake_argv_view(NULL, argv);
+            char *command = bake_argv_str(args + 1);
+            ecs_trace("%s: %s", path, command);
+            ecs_os_free(command);
+            ecs_os_free(args);
         }
+
+        bake_strlist_t rsp;
+        bake_strlist_init(&rsp);
+        bake_strlist_append(&rsp, argv->items[0]);
+        bake_argv_append_fmt(&rsp, "@%s", path);
+        bake_strlist_fini(argv);
+        *argv = rsp;
     }
 
-    return bake_run_command(command, false);
+    ecs_os_free(content);
+    return rc;
 }
 
 static char* bake_compile_display_path(const bake_project_cfg_t *cfg, const char *src) {
@@ -268,79 +478,402 @@ static char* bake_compile_display_path(const bake_project_cfg_t *cfg, const char
     return path;
 }
 
-static int bake_compile_single(bake_compile_ctx_t *ctx, const bake_compile_unit_t *unit) {
-    if (ctx->print_lock) {
-        ecs_os_mutex_lock(ctx->print_lock);
+static void bake_compose_compile_prefix(
+    const bake_compile_cmd_ctx_t *cmd_ctx,
+    bake_strlist_t *argv)
+{
+    if (cmd_ctx->ctx->compiler_kind == BAKE_COMPILER_MSVC) {
+        bake_compose_compile_prefix_msvc(cmd_ctx, argv);
+    } else {
+        bake_compose_compile_prefix_posix(cmd_ctx, argv);
+    }
+}
+
+static void bake_compose_compile_unit(
+    const bake_compile_cmd_ctx_t *cmd_ctx,
+    bake_strlist_t *argv)
+{
+    if (cmd_ctx->ctx->compiler_kind == BAKE_COMPILER_MSVC) {
+        bake_compose_compile_unit_msvc(cmd_ctx, argv);
+    } else {
+        bake_compose_compile_unit_posix(cmd_ctx, argv);
+    }
+}
+
+static void bake_compose_compile_command(
+    const bake_compile_cmd_ctx_t *cmd_ctx,
+    bake_strlist_t *argv)
+{
+    bake_compose_compile_prefix(cmd_ctx, argv);
+    bake_compose_compile_unit(cmd_ctx, argv);
+}
+
+/* Copy a file into the shared object cache. The copy is renamed into place so
+ * that concurrent builds never observe a partially written object. */
+static int bake_compile_publish(const char *src, const char *dst) {
+    char *tmp = flecs_asprintf("%s.%016llx.tmp", dst,
+        (unsigned long long)bake_hash(BAKE_HASH_INIT, src, strlen(src)));
+    int rc = bake_os_file_copy(src, tmp);
+    if (rc == 0 && rename(tmp, dst) != 0) {
+        if (!bake_path_exists(dst)) {
+            bake_log_errno_last("rename file", tmp);
+            rc = -1;
+        }
+        bake_remove_file_if_exists(tmp);
+    }
+    ecs_os_free(tmp);
+    return rc;
+}
+
+/* Path of a file stored next to an object, named after the object without its
+ * extension. */
+static char* bake_compile_obj_sibling(const char *obj, const char *ext) {
+    size_t len = strlen(obj);
+    if (len > 2 && !strcmp(obj + len - 2, ".o")) {
+        len -= 2;
+    } else if (len > 4 && !strcmp(obj + len - 4, ".obj")) {
+        len -= 4;
     }
-    int32_t done = ecs_os_ainc(&ctx->compile_done);
+    return flecs_asprintf("%.*s%s", (int)len, obj, ext);
+}
+
+/* cl echoes the name of the source file it compiles, which isn't a
+ * diagnostic. */
+static const char* bake_compile_skip_banner(
+    const bake_context_t *ctx,
+    const bake_compile_unit_t *unit,
+    const char *output)
+{
+    if (!output || ctx->compiler_kind != BAKE_COMPILER_MSVC) {
+        return output;
+    }
+
+    char *name = bake_path_basename(unit->src);
+    size_t len = strlen(name);
+    if (!strncmp(output, name, len) &&
+        (output[len] == '\r' || output[len] == '\n'))
+    {
+        output += len;
+        output += strspn(output, "\r\n");
+    }
+    ecs_os_free(name);
+    return output[0] ? output : NULL;
+}
+
+static void bake_print_diagnostics(const char *output) {
+    fputs(output, stderr);
+    fflush(stderr);
+}
+
+/* Removes the escape sequences of colored diagnostics: CSI sequences for the
+ * colors, and OSC sequences for links. */
+static char* bake_compile_strip_colors(const char *output) {
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    const char *ptr = output;
+    while (*ptr) {
+        const char *esc = strchr(ptr, '\x1b');
+        if (!esc) {
+            ecs_strbuf_appendstr(&buf, ptr);
+            break;
+        }
+        ecs_strbuf_appendstrn(&buf, ptr, (int32_t)(esc - ptr));
+        ptr = esc + 1;
+        if (*ptr == '[') {
+            ptr++;
+            while (*ptr >= 0x20 && *ptr <= 0x3f) {
+                ptr++;
+            }
+            if (*ptr >= 0x40 && *ptr <= 0x7e) {
+                ptr++;
+            }
+        } else if (*ptr == ']') {
+            while (*ptr && *ptr != '\a' && !(ptr[0] == '\x1b' && ptr[1] == '\\')) {
+                ptr++;
+            }
+            ptr += *ptr == '\a' ? 1 : (*ptr ? 2 : 0);
+        }
+    }
+    return ecs_strbuf_get(&buf);
+}
+
+/* Diagnostics are kept next to the object, so they can be replayed while the
+ * unit is up to date. Units without diagnostics have no file. Colors are not
+ * stored, since a replay may not print to a terminal. */
+static int bake_compile_store_diagnostics(const char *obj, const char *output) {
+    char *path = bake_compile_obj_sibling(obj, ".diag");
+    char *plain = output ? bake_compile_strip_colors(output) : NULL;
+    int rc = plain
+        ? bake_file_write(path, plain)
+        : bake_remove_file_if_exists(path);
+    ecs_os_free(plain);
+    ecs_os_free(path);
+    return rc;
+}
+
+static void bake_compile_replay_diagnostics(const bake_compile_unit_t *unit) {
+    char *path = bake_compile_obj_sibling(unit->obj, ".diag");
+    if (bake_path_exists(path)) {
+        char *output = bake_file_read(path, NULL);
+        if (output) {
+            bake_print_diagnostics(output);
+        }
+        ecs_os_free(output);
+    }
+    ecs_os_free(path);
+}
+
+static void bake_compile_job_free(bake_compile_job_t *job) {
+    ecs_os_free(job->argv);
+    bake_strlist_fini(&job->args);
+    ecs_os_free(job->publish_obj);
+    ecs_os_free(job->publish_dep);
+    ecs_os_free(job);
+}
+
+/* Starts the compiler for a unit. The job takes the arguments, and returns
+ * through bake_compile_finish when the compiler exits. */
+static int bake_compile_submit(
+    bake_compile_ctx_t *ctx,
+    const bake_compile_unit_t *unit,
+    const bake_strlist_t *prefix,
+    bake_strlist_t *args,
+    const char *publish_obj,
+    const char *publish_dep)
+{
+    bake_compile_job_t *job = ecs_os_calloc_t(bake_compile_job_t);
+    job->unit = unit;
+    job->args = *args;
+    bake_strlist_init(args);
+    if (ctx->color) {
+        bake_strlist_append(&job->args, "-fdiagnostics-color=always");
+    }
+    job->argv = bake_argv_view(prefix, &job->args);
+    job->publish_obj = publish_obj ? ecs_os_strdup(publish_obj) : NULL;
+    job->publish_dep = publish_dep ? ecs_os_strdup(publish_dep) : NULL;
+
+    bake_trace_compiler_command(ctx->ctx, job->argv);
+    if (bake_procs_spawn(ctx->procs, job->argv, NULL, true, job) != 0) {
+        bake_process_result_t result = {0};
+        bake_run_check_result(job->argv, -1, &result);
+        bake_compile_job_free(job);
+        return -1;
+    }
+    return 0;
+}
+
+/* Output of a compiler is printed at once when it exits, so that diagnostics
+ * of units that compile in parallel don't interleave. */
+static int bake_compile_finish(bake_compile_ctx_t *ctx, bake_proc_done_t *done) {
+    bake_compile_job_t *job = done->job;
+    const bake_compile_unit_t *unit = job->unit;
+
+    /* A compiler terminated after another unit failed may have left a partial
+     * object behind, which must not look up to date in the next build. */
+    if (done->cancelled) {
+        bake_remove_file_if_exists(unit->obj);
+        bake_remove_file_if_exists(unit->dep);
+        bake_procs_release(ctx->procs, done);
+        bake_compile_job_free(job);
+        return 0;
+    }
+
+    const char *output = bake_compile_skip_banner(ctx->ctx, unit, done->output);
+    if (output) {
+        bake_print_diagnostics(output);
+    }
+
+    int rc = bake_run_check_result(job->argv, 0, &done->result);
+    if (bake_compile_store_diagnostics(unit->obj, output) != 0) {
+        rc = -1;
+    }
+
+    if (rc == 0) {
+        bake_compile_unit_t *measured = &ctx->units->items[unit - ctx->units->items];
+        measured->compiled = true;
+        measured->usage = done->result.usage;
+    }
+
+    /* Publish the depfile first: the object marks the entry as complete. */
+    if (rc == 0 && job->publish_obj) {
+        if (bake_compile_publish(unit->dep, job->publish_dep) != 0 ||
+            bake_compile_store_diagnostics(job->publish_obj, output) != 0 ||
+            bake_compile_publish(unit->obj, job->publish_obj) != 0)
+        {
+            rc = -1;
+        }
+    }
+
+    bake_procs_release(ctx->procs, done);
+    bake_compile_job_free(job);
+    return rc;
+}
+
+/* Standalone dependency sources are compiled once per amalgamation snapshot
+ * and command line, into an obj directory next to the cached snapshot. Each
+ * application gets its own copy of the object and depfile, so outdated checks
+ * and linking behave as if the sources had been compiled in place. */
+static int bake_compile_shared(
+    bake_compile_ctx_t *ctx,
+    bake_compile_cmd_ctx_t *cmd_ctx)
+{
+    const bake_compile_unit_t *unit = cmd_ctx->unit;
+    bake_compile_unit_t shared = {
+        .src = unit->shared_src,
+        .obj = "-",
+        .dep = "-",
+        .cpp = unit->cpp
+    };
+    cmd_ctx->unit = &shared;
+    cmd_ctx->shared = true;
+
+    bake_strlist_t argv;
+    bake_strlist_init(&argv);
+    bake_compose_compile_command(cmd_ctx, &argv);
+    uint64_t key = BAKE_HASH_INIT;
+    for (int32_t i = 0; i < argv.count; i++) {
+        key = bake_hash(key, argv.items[i], strlen(argv.items[i]) + 1);
+    }
+    bake_strlist_fini(&argv);
+    bake_strlist_init(&argv);
+
+    int rc = -1;
+    char *snapshot_dir = bake_path_dirname(unit->shared_src);
+    char *obj = flecs_asprintf("%s/obj/%016llx.o",
+        snapshot_dir, (unsigned long long)key);
+    char *dep = flecs_asprintf("%s.d", obj);
+
+    int64_t obj_mtime = bake_os_file_mtime(obj);
+    if (obj_mtime < 0 || bake_depfile_outdated(dep, obj_mtime)) {
+        shared.obj = unit->obj;
+        shared.dep = unit->dep;
+
+        bake_compose_compile_command(cmd_ctx, &argv);
+        rc = bake_compile_submit(ctx, unit, NULL, &argv, obj, dep);
+        goto cleanup;
+    }
+
+    if (ctx->ctx->opts.trace) {
+        ecs_trace("reusing %s", obj);
+    }
+
+    /* Replace rather than overwrite, so the copies get a fresh mtime. */
+    if (bake_remove_file_if_exists(unit->obj) != 0 ||
+        bake_remove_file_if_exists(unit->dep) != 0 ||
+        bake_os_file_copy(obj, unit->obj) != 0 ||
+        bake_os_file_copy(dep, unit->dep) != 0)
+    {
+        goto cleanup;
+    }
+
+    char *diag = bake_compile_obj_sibling(obj, ".diag");
+    char *unit_diag = bake_compile_obj_sibling(unit->obj, ".diag");
+    int diag_rc = bake_path_exists(diag)
+        ? bake_os_file_copy(diag, unit_diag)
+        : bake_remove_file_if_exists(unit_diag);
+    ecs_os_free(diag);
+    ecs_os_free(unit_diag);
+    if (diag_rc != 0) {
+        goto cleanup;
+    }
+
+    rc = 0;
+cleanup:
+    bake_strlist_fini(&argv);
+    ecs_os_free(snapshot_dir);
+    ecs_os_free(obj);
+    ecs_os_free(dep);
+    return rc;
+}
+
+/* With -gsplit-dwarf the compiler writes the debug info of an object to a .dwo
+ * file next to it, named after the object without its extension. */
+static char* bake_compile_unit_dwo(const bake_compile_unit_t *unit) {
+    return bake_compile_obj_sibling(unit->obj, ".dwo");
+}
+
+static bool bake_compile_unit_split_dwarf(
+    const bake_strlist_t *mode_cflags,
+    const bake_strlist_t *mode_cxxflags,
+    const bake_compile_unit_t *unit)
+{
+    return bake_strlist_contains(
+        unit->cpp ? mode_cxxflags : mode_cflags, "-gsplit-dwarf");
+}
+
+static const bake_pch_t* bake_compile_unit_pch(
+    const bake_context_t *ctx,
+    const bake_pch_t *pch,
+    const bake_compile_unit_t *unit)
+{
+    if (!pch || !bake_compile_unit_uses_pch(unit)) {
+        return NULL;
+    }
+    const bake_pch_t *result = &pch[unit->cpp ? 1 : 0];
+    if (result->file && ctx->compiler_kind == BAKE_COMPILER_CLANG) {
+        return bake_pch_unit_includes_first(result, unit) ? result : NULL;
+    }
+    return result->file || result->shared_dirs.count ? result : NULL;
+}
+
+/* Starts compiling a unit. Objects found in the shared cache are copied
+ * without starting a job. */
+static int bake_compile_start(bake_compile_ctx_t *ctx, const bake_compile_unit_t *unit) {
+    int32_t done = ++ctx->compile_done;
     int32_t pct = (done * 100) / ctx->compile_total;
     char *display_path = bake_compile_display_path(ctx->cfg, unit->src);
     ecs_trace("#[green][#[normal]%6d%%#[green]]#[normal] %s", pct, display_path ? display_path : unit->src);
-    if (ctx->print_lock) {
-        ecs_os_mutex_unlock(ctx->print_lock);
-    }
     ecs_os_free(display_path);
 
     const bake_lang_cfg_t *lang = unit->cpp ? ctx->cpp_lang : ctx->c_lang;
     const bake_strlist_t *mode_flags = unit->cpp ? ctx->mode_cxxflags : ctx->mode_cflags;
 
-    ecs_strbuf_t cmd = ECS_STRBUF_INIT;
     bake_compile_cmd_ctx_t cmd_ctx = {
         .ctx = ctx->ctx,
         .cfg = ctx->cfg,
         .unit = unit,
         .lang = lang,
         .mode_flags = mode_flags,
-        .dep_includes = &ctx->dep_includes
+        .dep_includes = &ctx->dep_includes,
+        .pch = bake_compile_unit_pch(ctx->ctx, ctx->pch, unit),
+        .include_root = ctx->include_root ? ctx->include_root[unit->cpp ? 1 : 0] : NULL
     };
 
-    if (ctx->ctx->compiler_kind == BAKE_COMPILER_MSVC) {
-        bake_compose_compile_command_msvc(&cmd_ctx, &cmd);
-    } else {
-        bake_compose_compile_command_posix(&cmd_ctx, &cmd);
+    /* Without a depfile a shared object can't be checked against headers. */
+    if (unit->shared_src && unit->dep) {
+        return bake_compile_shared(ctx, &cmd_ctx);
     }
 
-    char *command = ecs_strbuf_get(&cmd);
-    int rc = bake_run_compiler_command(ctx->ctx, ctx->print_lock, command);
-    ecs_os_free(command);
-    return rc;
-}
-
-static void* bake_compile_worker(void *arg) {
-    bake_compile_ctx_t *ctx = arg;
-
-    for (;;) {
-        if (ctx->failed) {
-            break;
-        }
-
-        int32_t index = ecs_os_ainc(&ctx->cursor) - 1;
-        if (index >= ctx->units->count) {
-            break;
-        }
-
-        if (!ctx->compile_mask[index]) {
-            continue;
-        }
-
-        if (bake_compile_single(ctx, &ctx->units->items[index]) != 0) {
-            ecs_os_ainc(&ctx->failed);
-            break;
+    /* Don't leave the debug info of a previous split build behind. */
+    if (!bake_compile_unit_split_dwarf(ctx->mode_cflags, ctx->mode_cxxflags, unit)) {
+        char *dwo = bake_compile_unit_dwo(unit);
+        int dwo_rc = bake_remove_file_if_exists(dwo);
+        ecs_os_free(dwo);
+        if (dwo_rc != 0) {
+            return -1;
         }
     }
 
-    return NULL;
+    /* Only the arguments of the unit are composed, the rest is shared. */
+    bake_strlist_t args;
+    bake_strlist_init(&args);
+    bake_compose_compile_unit(&cmd_ctx, &args);
+    const bake_strlist_t *prefix =
+        &ctx->prefix[unit->cpp ? 1 : 0][cmd_ctx.pch ? 1 : 0];
+    return bake_compile_submit(ctx, unit, prefix, &args, NULL, NULL);
 }
 
 int bake_compile_units_parallel(
     bake_context_t *ctx,
     ecs_entity_t project_entity,
     const bake_project_cfg_t *cfg,
-    const bake_compile_list_t *units,
+    const bake_build_paths_t *paths,
+    bake_compile_list_t *units,
     const bake_lang_cfg_t *lang,
     const bake_lang_cfg_t *cpp_lang,
     const bake_strlist_t *mode_cflags,
     const bake_strlist_t *mode_cxxflags,
+    const bake_pch_t *pch,
+    char *const *include_root,
     bool force_rebuild,
     int32_t *compiled_count_out)
 {
@@ -363,19 +896,57 @@ int bake_compile_units_parallel(
         .cpp_lang = cpp_lang,
         .mode_cflags = mode_cflags,
         .mode_cxxflags = mode_cxxflags,
+        .pch = pch,
+        .include_root = include_root
     };
 
+    /* Compilers don't color output that is captured, so colors are requested
+     * when bake prints to a terminal. The flag is not part of the command that
+     * keys shared objects, or of the response files. */
+    compile_ctx.color = bake_os_stderr_is_tty() &&
+        (ctx->compiler_kind == BAKE_COMPILER_GCC ||
+            ctx->compiler_kind == BAKE_COMPILER_CLANG);
+
     int rc = -1;
-    ecs_os_thread_t *threads = NULL;
     compile_ctx.compile_mask = ecs_os_calloc_n(bool, units->count);
 
+    /* Depfiles don't list the headers that were read from a precompiled
+     * header, so units that may have used one are rebuilt along with it. */
+    int64_t pch_mtime[2] = { -1, -1 };
+    for (int32_t i = 0; pch && i < 2; i++) {
+        if (pch[i].file) {
+            pch_mtime[i] = bake_os_file_mtime(pch[i].file);
+        }
+        if (pch[i].shared_dirs.count && pch[i].shared_mtime > pch_mtime[i]) {
+            pch_mtime[i] = pch[i].shared_mtime;
+        }
+    }
+
     int64_t project_json_mtime = bake_project_json_mtime(cfg);
+    bool compile_lang[2] = { false, false };
     for (int32_t i = 0; i < units->count; i++) {
-        compile_ctx.compile_mask[i] = force_rebuild || bake_compile_unit_outdated(
-            &units->items[i],
-            project_json_mtime);
+        const bake_compile_unit_t *unit = &units->items[i];
+        int64_t unit_pch_mtime = bake_compile_unit_pch(ctx, pch, unit) ?
+            pch_mtime[unit->cpp ? 1 : 0] : -1;
+        compile_ctx.compile_mask[i] = force_rebuild ||
+            bake_compile_unit_outdated(unit, project_json_mtime) ||
+            (unit_pch_mtime >= 0 &&
+                unit_pch_mtime > bake_os_file_mtime(unit->obj));
+
+        /* Objects with split debug info are incomplete without their .dwo.
+         * Shared objects keep theirs with the project that compiled them. */
+        if (!compile_ctx.compile_mask[i] && !unit->shared_src &&
+            bake_compile_unit_split_dwarf(mode_cflags, mode_cxxflags, unit))
+        {
+            char *dwo = bake_compile_unit_dwo(unit);
+            compile_ctx.compile_mask[i] = !bake_path_exists(dwo);
+            ecs_os_free(dwo);
+        }
         if (compile_ctx.compile_mask[i]) {
             compile_ctx.compile_total++;
+            compile_lang[unit->cpp ? 1 : 0] = true;
+        } else if (ctx->opts.replay_warnings) {
+            bake_compile_replay_diagnostics(unit);
         }
     }
 
@@ -388,33 +959,91 @@ int bake_compile_units_parallel(
     if (resolved) {
         bake_strlist_merge_unique(&compile_ctx.dep_includes, &resolved->include_paths);
     }
-    compile_ctx.print_lock = ecs_os_mutex_new();
 
-    int32_t workers = ctx->thread_count;
-    if (workers < 1) {
-        workers = 1;
-    }
-    if (workers > compile_ctx.compile_total) {
-        workers = compile_ctx.compile_total;
-    }
+    for (int32_t cpp = 0; cpp < 2; cpp++) {
+        const bake_pch_t *lang_pch =
+            pch && (pch[cpp].file || pch[cpp].shared_dirs.count) ? &pch[cpp] : NULL;
+        for (int32_t use_pch = 0; use_pch < 2; use_pch++) {
+            bake_strlist_t *prefix = &compile_ctx.prefix[cpp][use_pch];
+            bake_strlist_init(prefix);
+            if (!compile_lang[cpp]) {
+                continue;
+            }
 
-    threads = ecs_os_malloc_n(ecs_os_thread_t, workers);
-    int32_t started = 0;
-    for (int32_t i = 0; i < workers; i++) {
-        threads[i] = ecs_os_thread_new(bake_compile_worker, &compile_ctx);
-        if (!threads[i]) {
-            ecs_os_ainc(&compile_ctx.failed);
-            break;
+            char *rsp_name = flecs_asprintf("compile-%s%s.rsp",
+                cpp ? "cpp" : "c", use_pch ? "-pch" : "");
+            char *rsp = bake_path_join(paths->build_root, rsp_name);
+            ecs_os_free(rsp_name);
+            if (use_pch && !lang_pch) {
+                bake_remove_file_if_exists(rsp);
+                ecs_os_free(rsp);
+                continue;
+            }
+
+            bake_compile_unit_t lang_unit = { .cpp = cpp == 1 };
+            bake_compile_cmd_ctx_t cmd_ctx = {
+                .ctx = ctx,
+                .cfg = cfg,
+                .unit = &lang_unit,
+                .lang = cpp ? cpp_lang : lang,
+                .mode_flags = cpp ? mode_cxxflags : mode_cflags,
+                .dep_includes = &compile_ctx.dep_includes,
+                .pch = use_pch ? lang_pch : NULL,
+                .include_root = include_root ? include_root[cpp] : NULL
+            };
+            bake_compose_compile_prefix(&cmd_ctx, prefix);
+
+            /* Flags shared by all units of the project are written once, and
+             * each unit only passes its own arguments next to the file. */
+            int rsp_rc = bake_argv_length(prefix) > BAKE_RSP_MIN_LENGTH
+                ? bake_argv_to_rsp(ctx, prefix, rsp)
+                : bake_remove_file_if_exists(rsp);
+            ecs_os_free(rsp);
+            if (rsp_rc != 0) {
+                goto cleanup;
+            }
         }
-        started++;
     }
 
-    if (!started) {
-        goto cleanup;
+    /* Compilers run as jobs of a single event loop, which starts the next
+     * unit whenever one exits. The job count is not limited by threads. */
+    int32_t jobs = ctx->thread_count;
+    if (jobs < 1) {
+        jobs = 1;
     }
 
-    for (int32_t i = 0; i < started; i++) {
-        ecs_os_thread_join(threads[i]);
+    /* Without --keep-going the first failure terminates the compilers that
+     * still run, instead of waiting for them. */
+    bool keep_going = ctx->opts.keep_going;
+    compile_ctx.procs = bake_procs_new();
+    int32_t cursor = 0;
+    for (;;) {
+        while ((keep_going || !compile_ctx.failed) && cursor < units->count &&
+            bake_procs_count(compile_ctx.procs) < jobs)
+        {
+            int32_t index = cursor++;
+            if (compile_ctx.compile_mask[index] &&
+                bake_compile_start(&compile_ctx, &units->items[index]) != 0)
+            {
+                compile_ctx.failed++;
+            }
+        }
+
+        if (compile_ctx.failed && !keep_going) {
+            bake_procs_cancel(compile_ctx.procs);
+        }
+        if (!bake_procs_count(compile_ctx.procs)) {
+            break;
+        }
+
+        bake_proc_done_t done;
+        if (bake_procs_wait(compile_ctx.procs, &done) != 0) {
+            compile_ctx.failed++;
+            break;
+        }
+        if (bake_compile_finish(&compile_ctx, &done) != 0) {
+            compile_ctx.failed++;
+        }
     }
 
     if (!compile_ctx.failed && compiled_count_out) {
@@ -424,19 +1053,116 @@ int bake_compile_units_parallel(
     rc = compile_ctx.failed ? -1 : 0;
 
 cleanup:
-    ecs_os_free(threads);
+    bake_procs_free(compile_ctx.procs);
     bake_strlist_fini(&compile_ctx.dep_includes);
-    if (compile_ctx.print_lock) {
-        ecs_os_mutex_free(compile_ctx.print_lock);
+    for (int32_t i = 0; i < 4; i++) {
+        bake_strlist_fini(&compile_ctx.prefix[i / 2][i % 2]);
     }
     ecs_os_free(compile_ctx.compile_mask);
     return rc;
 }
 
+int bake_compile_unit_shared(
+    bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_compile_unit_t *unit,
+    const bake_lang_cfg_t *lang,
+    const bake_strlist_t *mode_flags)
+{
+    const BakeResolvedDeps *resolved =
+        project_entity ? ecs_get(ctx->world, project_entity, BakeResolvedDeps) : NULL;
+
+    bake_strlist_t dep_includes;
+    bake_strlist_init(&dep_includes);
+    if (resolved) {
+        bake_strlist_merge_unique(&dep_includes, &resolved->include_paths);
+    }
+
+    bake_compile_cmd_ctx_t cmd_ctx = {
+        .ctx = ctx,
+        .cfg = cfg,
+        .unit = unit,
+        .lang = lang,
+        .mode_flags = mode_flags,
+        .dep_includes = &dep_includes,
+        .shared = true
+    };
+
+    bake_strlist_t argv;
+    bake_strlist_init(&argv);
+    bake_compose_compile_command(&cmd_ctx, &argv);
+    int rc = bake_run_compiler_command(ctx, NULL, &argv);
+    bake_strlist_fini(&argv);
+    bake_strlist_fini(&dep_includes);
+    return rc;
+}
+
+/* The link manifest starts with the kind of artefact, followed by a
+ * "<mtime> <object>" line for each object linked into the artefact, as it was
+ * when the artefact was written. Comparing it with
+ * the current objects also catches objects of deleted sources, which an mtime
+ * check can't, and tells which members of a static library changed. */
+static char* bake_link_member_line(const char *obj) {
+    int64_t mtime = bake_os_file_mtime(obj);
+    if (mtime < 0) {
+        return NULL;
+    }
+    return flecs_asprintf("%lld %s", (long long)mtime, obj);
+}
+
+static char* bake_link_manifest(
+    const char *kind,
+    const bake_compile_list_t *units)
+{
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    ecs_strbuf_append(&buf, "%s\n", kind);
+    for (int32_t i = 0; i < units->count; i++) {
+        char *line = bake_link_member_line(units->items[i].obj);
+        if (!line) {
+            ecs_strbuf_reset(&buf);
+            return NULL;
+        }
+        ecs_strbuf_append(&buf, "%s\n", line);
+        ecs_os_free(line);
+    }
+
+    return ecs_strbuf_get(&buf);
+}
+
+/* Thin archives and prelinked objects need GNU compatible tools. */
+static bake_archive_kind_t bake_link_archive_kind(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg)
+{
+    bake_archive_kind_t kind = cfg->archive;
+    if (kind == BAKE_ARCHIVE_STATIC) {
+        return kind;
+    }
+
+    bool supported = ctx->compiler_kind != BAKE_COMPILER_MSVC;
+#if defined(__APPLE__)
+    /* The ar of Xcode can't create thin archives. */
+    if (kind == BAKE_ARCHIVE_THIN && !bake_target_is_emscripten()) {
+        supported = false;
+    }
+#endif
+
+    if (!supported) {
+        ecs_warn("archive '%s' is not supported by this toolchain, "
+            "building a static library for %s",
+            bake_archive_kind_str(kind), cfg->id);
+        return BAKE_ARCHIVE_STATIC;
+    }
+
+    return kind;
+}
+
 static bool bake_link_inputs_outdated(
     const bake_project_cfg_t *cfg,
     const char *artefact,
-    const bake_compile_list_t *units,
+    const char *manifest,
+    const char *members,
     const bake_strlist_t *dep_artefacts)
 {
     if (!artefact || !bake_path_exists(artefact)) {
@@ -452,15 +1178,12 @@ static bool bake_link_inputs_outdated(
         return true;
     }
 
-    for (int32_t i = 0; i < units->count; i++) {
-        int64_t mtime = bake_os_file_mtime(units->items[i].obj);
-        if (mtime < 0 || mtime > artefact_mtime) {
-            return true;
-        }
+    if (!members || !bake_file_equals(manifest, members, strlen(members))) {
+        return true;
     }
 
     for (int32_t i = 0; i < dep_artefacts->count; i++) {
-        int64_t mtime = bake_os_file_mtime(dep_artefacts->items[i]);
+        int64_t mtime = bake_dep_artefact_mtime(dep_artefacts->items[i]);
         if (mtime < 0 || mtime > artefact_mtime) {
             return true;
         }
@@ -469,6 +1192,178 @@ static bool bake_link_inputs_outdated(
     return false;
 }
 
+/* The interface of a shared library is the list of symbols it exports, which
+ * is only written when it changed. Without one dependents relink whenever the
+ * library does. */
+static void bake_link_write_interface(
+    const bake_context_t *ctx,
+    const char *artefact)
+{
+    char *interface = flecs_asprintf("%s.symbols", artefact);
+    char *nm_out = flecs_asprintf("%s.nm", artefact);
+    char *content = NULL;
+    char *symbols = NULL;
+
+#if defined(__APPLE__)
+    const char *argv[] = { "nm", "-gU", artefact, NULL };
+#else
+    const char *argv[] = { "nm", "-D", "-S", "--defined-only", artefact, NULL };
+#endif
+    bake_process_stdio_t stdio_cfg = { .stdout_path = nm_out };
+    bake_trace_compiler_command(ctx, argv);
+    if (bake_run_argv(argv, &stdio_cfg, false) == 0) {
+        content = bake_file_read(nm_out, NULL);
+    }
+
+    if (!content) {
+        ecs_warn("failed to list symbols of %s, dependents relink when it "
+            "changes", artefact);
+        bake_remove_file_if_exists(interface);
+        goto cleanup;
+    }
+
+    /* Keep the type and name of each symbol, addresses change with code.
+     * Data objects also keep their size, since dependents may have copied
+     * them with a copy relocation. Lines are "<addr> [<size>] <type> <name>". */
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    for (char *line = strtok(content, "\n"); line; line = strtok(NULL, "\n")) {
+        char *fields[4];
+        int32_t count = 0;
+        for (char *field = line; *field && count < 4; ) {
+            fields[count++] = field;
+            field += strcspn(field, " ");
+            if (*field) {
+                *field++ = '\0';
+                field += strspn(field, " ");
+            }
+        }
+        if (count < 3) {
+            continue;
+        }
+
+        const char *type = fields[count - 2];
+        const char *name = fields[count - 1];
+        if (count == 4 && strchr("BDRV", type[0] & ~0x20)) {
+            ecs_strbuf_append(&buf, "%s %s %s\n", type, fields[1], name);
+        } else {
+            ecs_strbuf_append(&buf, "%s %s\n", type, name);
+        }
+    }
+    symbols = ecs_strbuf_get(&buf);
+    if (!symbols) {
+        symbols = ecs_os_strdup("");
+    }
+
+    if (!bake_file_equals(interface, symbols, strlen(symbols)) &&
+        bake_file_write(interface, symbols) != 0)
+    {
+        bake_remove_file_if_exists(interface);
+    }
+
+cleanup:
+    bake_remove_file_if_exists(nm_out);
+    ecs_os_free(interface);
+    ecs_os_free(nm_out);
+    ecs_os_free(content);
+    ecs_os_free(symbols);
+}
+
+/* Plans an in-place update of an existing static library: members of objects
+ * that are no longer built are deleted, and members of new or recompiled
+ * objects replaced. Returns 1 when the archive must be rebuilt from scratch,
+ * because there is no usable manifest or because two objects share a file
+ * name, which ar can't tell apart. Objects of the previous archive count as
+ * well, since deleting a member by name may delete the wrong one. */
+static int bake_archive_plan_update(
+    const char *manifest,
+    const char *artefact,
+    const bake_compile_list_t *units,
+    bake_strlist_t *removed,
+    bake_strlist_t *replaced)
+{
+    /* The manifest is written after the archive, so an archive that is newer
+     * was written by something else. */
+    int64_t archive_mtime = bake_os_file_mtime(artefact);
+    int64_t manifest_mtime = bake_os_file_mtime(manifest);
+    if (archive_mtime < 0 || manifest_mtime < archive_mtime) {
+        return 1;
+    }
+
+    char *content = bake_file_read(manifest, NULL);
+    if (!content) {
+        return 1;
+    }
+
+    /* The previous artefact must have been a regular static library too. */
+    const char *kind = bake_archive_kind_str(BAKE_ARCHIVE_STATIC);
+    size_t kind_len = strlen(kind);
+    if (strncmp(content, kind, kind_len) || content[kind_len] != '\n') {
+        ecs_os_free(content);
+        return 1;
+    }
+
+    int rc = 1;
+    bake_strset_t names, objs, members;
+    bake_strset_init(&names);
+    bake_strset_init(&objs);
+    bake_strset_init(&members);
+
+    for (int32_t i = 0; i < units->count; i++) {
+        const char *obj = units->items[i].obj;
+        char *name = bake_path_basename(obj);
+        bool duplicate = bake_strset_contains(&names, name);
+        bake_strset_add(&names, name);
+        ecs_os_free(name);
+        if (duplicate) {
+            goto cleanup;
+        }
+        bake_strset_add(&objs, obj);
+    }
+
+    for (char *line = content + kind_len + 1; *line; ) {
+        char *next = strchr(line, '\n');
+        if (next) {
+            *next = '\0';
+        }
+
+        const char *obj = strchr(line, ' ');
+        if (!obj) {
+            goto cleanup;
+        }
+        obj++;
+
+        bake_strset_add(&members, line);
+        if (!bake_strset_contains(&objs, obj)) {
+            char *name = bake_path_basename(obj);
+            if (bake_strset_contains(&names, name)) {
+                ecs_os_free(name);
+                goto cleanup;
+            }
+            bake_strset_add(&names, name);
+            bake_strlist_append_owned(removed, name);
+        }
+
+        line = next ? next + 1 : NULL;
+    }
+
+    for (int32_t i = 0; i < units->count; i++) {
+        const char *obj = units->items[i].obj;
+        char *line = bake_link_member_line(obj);
+        if (!line || !bake_strset_contains(&members, line)) {
+            bake_strlist_append(replaced, obj);
+        }
+        ecs_os_free(line);
+    }
+
+    rc = 0;
+cleanup:
+    bake_strset_fini(&names);
+    bake_strset_fini(&objs);
+    bake_strset_fini(&members);
+    ecs_os_free(content);
+    return rc;
+}
+
 int bake_link_project_binary(
     bake_context_t *ctx,
     ecs_entity_t project_entity,
@@ -484,6 +1379,17 @@ int bake_link_project_binary(
     int rc = -1;
     char *artefact = NULL;
     char *file_name = NULL;
+    char *manifest = NULL;
+    char *members = NULL;
+    char *kind = NULL;
+    char *rsp = NULL;
+    bake_strlist_t link_cmd;
+    bake_strlist_init(&link_cmd);
+    bake_strlist_t archive_cmds[3];
+    int32_t archive_cmd_count = 0;
+    for (int32_t i = 0; i < 3; i++) {
+        bake_strlist_init(&archive_cmds[i]);
+    }
     if (linked_out) {
         *linked_out = false;
     }
@@ -518,23 +1424,6 @@ int bake_link_project_binary(
     ecs_os_free(file_name);
     file_name = NULL;
 
-    if (!force_relink &&
-        !bake_link_inputs_outdated(cfg, artefact, units, &dep_artefacts))
-    {
-        *artefact_out = artefact;
-        artefact = NULL;
-        rc = 0;
-        goto cleanup;
-    }
-
-    /* Rebuild static libraries from scratch: ar only adds/replaces members,
-     * so objects of deleted sources would otherwise linger in the archive. */
-    if (cfg->kind == BAKE_PROJECT_PACKAGE &&
-        bake_remove_file_if_exists(artefact) != 0)
-    {
-        goto cleanup;
-    }
-
     bool use_cpp = bake_language_is_cpp(cfg);
     for (int32_t i = 0; i < units->count; i++) {
         if (units->items[i].cpp) {
@@ -552,7 +1441,31 @@ int bake_link_project_binary(
         }
     }
 
-    ecs_strbuf_t cmd = ECS_STRBUF_INIT;
+    bool shared = is_lib && bake_project_cfg_shared_library(cfg);
+    bake_archive_kind_t archive = BAKE_ARCHIVE_STATIC;
+    const char *linker = NULL;
+    if (is_lib && !shared) {
+        archive = bake_link_archive_kind(ctx, cfg);
+        kind = ecs_os_strdup(bake_archive_kind_str(archive));
+    } else {
+        linker = bake_select_linker(
+            ctx, cfg, bake_link_driver_posix(ctx, use_cpp), paths->build_root);
+        kind = flecs_asprintf("%s linker=%s",
+            shared ? "shared" : bake_project_kind_str(cfg->kind),
+            linker ? linker : "default");
+    }
+
+    manifest = bake_path_join(paths->build_root, ".bake_link");
+    members = bake_link_manifest(kind, units);
+    if (!force_relink && !bake_link_inputs_outdated(
+        cfg, artefact, manifest, members, &dep_artefacts))
+    {
+        *artefact_out = artefact;
+        artefact = NULL;
+        rc = 0;
+        goto cleanup;
+    }
+
     bake_link_cmd_ctx_t cmd_ctx = {
         .ctx = ctx,
         .cfg = cfg,
@@ -564,21 +1477,84 @@ int bake_link_project_binary(
         .dep_libs = &dep_libs,
         .dep_ldflags = &dep_ldflags,
         .artefact = artefact,
+        .archive = archive,
+        .linker = linker,
         .use_cpp = use_cpp
     };
 
-    if (ctx->compiler_kind == BAKE_COMPILER_MSVC) {
-        bake_compose_link_command_msvc(&cmd_ctx, &cmd);
+    /* Thin archives and prelinked objects are cheap to write from scratch,
+     * as they don't contain copies of the objects. */
+    if (is_lib && !shared && archive == BAKE_ARCHIVE_STATIC &&
+        ctx->compiler_kind != BAKE_COMPILER_MSVC &&
+        !force_relink && bake_path_exists(artefact))
+    {
+        bake_strlist_t removed, replaced;
+        bake_strlist_init(&removed);
+        bake_strlist_init(&replaced);
+        if (bake_archive_plan_update(
+            manifest, artefact, units, &removed, &replaced) == 0)
+        {
+            archive_cmd_count = bake_compose_archive_update_posix(
+                &cmd_ctx, &removed, &replaced, archive_cmds);
+            for (int32_t i = 0; i < archive_cmd_count; i++) {
+                if (bake_argv_length(&archive_cmds[i]) > BAKE_RSP_MIN_LENGTH) {
+                    rsp = bake_path_join(paths->build_root, "archive.rsp");
+                    break;
+                }
+            }
+        }
+        bake_strlist_fini(&removed);
+        bake_strlist_fini(&replaced);
+    }
+
+    /* Remove the manifest first, so an interrupted link is redone. */
+    if (bake_remove_file_if_exists(manifest) != 0) {
+        goto cleanup;
+    }
+
+    if (archive_cmd_count) {
+        for (int32_t i = 0; i < archive_cmd_count; i++) {
+            if (rsp && bake_argv_length(&archive_cmds[i]) > BAKE_RSP_MIN_LENGTH &&
+                bake_argv_to_rsp(ctx, &archive_cmds[i], rsp) != 0)
+            {
+                goto cleanup;
+            }
+            rc = bake_run_compiler_command(ctx, NULL, &archive_cmds[i]);
+            if (rc != 0) {
+                goto cleanup;
+            }
+        }
     } else {
-        bake_compose_link_command_posix(&cmd_ctx, &cmd);
+        /* Rebuild static libraries from scratch: ar only adds/replaces
+         * members, so objects of deleted sources would otherwise linger in
+         * the archive. */
+        if (is_lib && bake_remove_file_if_exists(artefact) != 0) {
+            goto cleanup;
+        }
+
+        if (ctx->compiler_kind == BAKE_COMPILER_MSVC) {
+            bake_compose_link_command_msvc(&cmd_ctx, &link_cmd);
+        } else {
+            bake_compose_link_command_posix(&cmd_ctx, &link_cmd);
+        }
+
+        rsp = bake_path_join(paths->build_root, "link.rsp");
+        if (bake_argv_to_rsp(ctx, &link_cmd, rsp) != 0) {
+            goto cleanup;
+        }
+        rc = bake_run_compiler_command(ctx, NULL, &link_cmd);
+
+        if (rc != 0) {
+            goto cleanup;
+        }
     }
 
-    char *command = ecs_strbuf_get(&cmd);
-    rc = bake_run_compiler_command(ctx, 0, command);
-    ecs_os_free(command);
+    if (members && bake_file_write(manifest, members) != 0) {
+        ecs_warn("failed to write link manifest %s", manifest);
+    }
 
-    if (rc != 0) {
-        goto cleanup;
+    if (shared) {
+        bake_link_write_interface(ctx, artefact);
     }
 
     if (linked_out) {
@@ -593,7 +1569,15 @@ cleanup:
     bake_strlist_fini(&dep_libpaths);
     bake_strlist_fini(&dep_libs);
     bake_strlist_fini(&dep_ldflags);
+    bake_strlist_fini(&link_cmd);
+    for (int32_t i = 0; i < 3; i++) {
+        bake_strlist_fini(&archive_cmds[i]);
+    }
     ecs_os_free(file_name);
     ecs_os_free(artefact);
+    ecs_os_free(manifest);
+    ecs_os_free(members);
+    ecs_os_free(kind);
+    ecs_os_free(rsp);
     return rc;
 }
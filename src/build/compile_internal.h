@@ -10,6 +10,9 @@ typedef struct bake_compile_cmd_ctx_t {
     const bake_lang_cfg_t *lang;
     const bake_strlist_t *mode_flags;
     const bake_strlist_t *dep_includes;
+    const bake_pch_t *pch;
+    const char *include_root; /* replaces the include directories when set */
+    bool shared; /* leave out flags that identify the project being built */
 } bake_compile_cmd_ctx_t;
 
 typedef struct bake_link_cmd_ctx_t {
@@ -23,12 +26,28 @@ typedef struct bake_link_cmd_ctx_t {
     const bake_strlist_t *dep_libs;
     const bake_strlist_t *dep_ldflags;
     const char *artefact;
+    bake_archive_kind_t archive;
+    const char *linker; /* -fuse-ld value, NULL for the default linker */
     bool use_cpp;
 } bake_link_cmd_ctx_t;
 
-int bake_compose_compile_command_posix(const bake_compile_cmd_ctx_t *ctx, ecs_strbuf_t *cmd);
-int bake_compose_compile_command_msvc(const bake_compile_cmd_ctx_t *ctx, ecs_strbuf_t *cmd);
-int bake_compose_link_command_posix(const bake_link_cmd_ctx_t *ctx, ecs_strbuf_t *cmd);
-int bake_compose_link_command_msvc(const bake_link_cmd_ctx_t *ctx, ecs_strbuf_t *cmd);
+/* Commands are composed as argv vectors. The compile prefix holds the
+ * arguments shared by all units of a project and language, the unit part the
+ * ones of a single unit. */
+void bake_argv_append_fmt(bake_strlist_t *argv, const char *fmt, const char *value);
+int bake_compose_compile_prefix_posix(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv);
+int bake_compose_compile_unit_posix(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv);
+int bake_compose_compile_prefix_msvc(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv);
+int bake_compose_compile_unit_msvc(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv);
+const char* bake_link_driver_posix(const bake_context_t *ctx, bool use_cpp);
+int bake_compose_link_command_posix(const bake_link_cmd_ctx_t *ctx, bake_strlist_t *argv);
+int bake_compose_link_command_msvc(const bake_link_cmd_ctx_t *ctx, bake_strlist_t *argv);
+
+/* Fills up to three commands: delete, replace and index. */
+int32_t bake_compose_archive_update_posix(
+    const bake_link_cmd_ctx_t *ctx,
+    const bake_strlist_t *removed,
+    const bake_strlist_t *replaced,
+    bake_strlist_t *commands);
 
 #endif
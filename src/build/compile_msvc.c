@@ -2,52 +2,58 @@
 #include "compile_internal.h"
 #include "bake/os.h"
 
-int bake_compose_compile_command_msvc(const bake_compile_cmd_ctx_t *ctx, ecs_strbuf_t *cmd) {
+int bake_compose_compile_prefix_msvc(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv) {
     const char *compiler = ctx->unit->cpp
         ? (ctx->ctx->opts.cxx ? ctx->ctx->opts.cxx : "cl")
         : (ctx->ctx->opts.cc ? ctx->ctx->opts.cc : "cl");
 
-    ecs_strbuf_append(cmd, "%s /nologo /c", compiler);
-    for (int32_t i = 0; i < ctx->mode_flags->count; i++) {
-        ecs_strbuf_append(cmd, " %s", ctx->mode_flags->items[i]);
-    }
-    bake_list_append_fmt(cmd, &ctx->lang->cflags, "");
+    bake_strlist_append(argv, compiler);
+    bake_strlist_append(argv, "/nologo");
+    bake_strlist_append(argv, "/c");
+    bake_argv_append_list(argv, ctx->mode_flags, "");
+    bake_argv_append_list(argv, &ctx->lang->cflags, "");
     if (ctx->unit->cpp) {
-        bake_list_append_fmt(cmd, &ctx->lang->cxxflags, "");
-    }
-    for (int32_t i = 0; i < ctx->lang->defines.count; i++) {
-        ecs_strbuf_append(cmd, " /D%s", ctx->lang->defines.items[i]);
-    }
-    ecs_strbuf_append(cmd, " /DBAKE_PROJECT_ID=\\\"%s\\\"", ctx->cfg->id);
-    if (ctx->cfg->kind == BAKE_PROJECT_PACKAGE) {
-        char *macro = bake_project_id_as_macro(ctx->cfg->id);
-        ecs_strbuf_append(cmd, " /D%s_EXPORTS", macro);
-        ecs_os_free(macro);
+        bake_argv_append_list(argv, &ctx->lang->cxxflags, "");
     }
+    bake_argv_append_list(argv, &ctx->lang->defines, "/D");
+    if (!ctx->shared) {
+        bake_argv_append_fmt(argv, "/DBAKE_PROJECT_ID=\"%s\"", ctx->cfg->id);
+        if (ctx->cfg->kind == BAKE_PROJECT_PACKAGE) {
+            char *macro = bake_project_id_as_macro(ctx->cfg->id);
+            bake_argv_append_fmt(argv, "/D%s_EXPORTS", macro);
+            ecs_os_free(macro);
+        }
 
-    char *include = bake_path_join(ctx->cfg->path, "include");
-    if (bake_path_exists(include)) {
-        ecs_strbuf_append(cmd, " /I\"%s\"", include);
+        char *include = bake_path_join(ctx->cfg->path, "include");
+        if (bake_path_exists(include)) {
+            bake_argv_append_fmt(argv, "/I%s", include);
+        }
+        ecs_os_free(include);
     }
-    ecs_os_free(include);
 
     for (int32_t i = 0; i < ctx->lang->include_paths.count; i++) {
-        ecs_strbuf_append(cmd, " /I\"%s\"", ctx->lang->include_paths.items[i]);
+        bake_argv_append_fmt(argv, "/I%s", ctx->lang->include_paths.items[i]);
     }
     for (int32_t i = 0; i < ctx->dep_includes->count; i++) {
-        ecs_strbuf_append(cmd, " /I\"%s\"", ctx->dep_includes->items[i]);
+        bake_argv_append_fmt(argv, "/I%s", ctx->dep_includes->items[i]);
     }
+    return 0;
+}
 
-    ecs_strbuf_append(cmd, " /Fo\"%s\" \"%s\"", ctx->unit->obj, ctx->unit->src);
+int bake_compose_compile_unit_msvc(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv) {
+    bake_argv_append_fmt(argv, "/Fo%s", ctx->unit->obj);
+    bake_strlist_append(argv, ctx->unit->src);
     return 0;
 }
 
-int bake_compose_link_command_msvc(const bake_link_cmd_ctx_t *ctx, ecs_strbuf_t *cmd) {
+int bake_compose_link_command_msvc(const bake_link_cmd_ctx_t *ctx, bake_strlist_t *argv) {
     bool is_lib = ctx->cfg->kind == BAKE_PROJECT_PACKAGE;
     if (is_lib) {
-        ecs_strbuf_append(cmd, "lib /nologo /OUT:\"%s\"", ctx->artefact);
+        bake_strlist_append(argv, "lib");
+        bake_strlist_append(argv, "/nologo");
+        bake_argv_append_fmt(argv, "/OUT:%s", ctx->artefact);
         for (int32_t i = 0; i < ctx->units->count; i++) {
-            ecs_strbuf_append(cmd, " \"%s\"", ctx->units->items[i].obj);
+            bake_strlist_append(argv, ctx->units->items[i].obj);
         }
         return 0;
     }
@@ -56,29 +62,30 @@ int bake_compose_link_command_msvc(const bake_link_cmd_ctx_t *ctx, ecs_strbuf_t
         ? (ctx->ctx->opts.cxx ? ctx->ctx->opts.cxx : "cl")
         : (ctx->ctx->opts.cc ? ctx->ctx->opts.cc : "cl");
 
-    ecs_strbuf_append(cmd, "%s /nologo", linker);
+    bake_strlist_append(argv, linker);
+    bake_strlist_append(argv, "/nologo");
     for (int32_t i = 0; i < ctx->units->count; i++) {
-        ecs_strbuf_append(cmd, " \"%s\"", ctx->units->items[i].obj);
+        bake_strlist_append(argv, ctx->units->items[i].obj);
     }
     for (int32_t i = 0; i < ctx->dep_artefacts->count; i++) {
-        ecs_strbuf_append(cmd, " \"%s\"", ctx->dep_artefacts->items[i]);
+        bake_strlist_append(argv, ctx->dep_artefacts->items[i]);
     }
     for (int32_t i = 0; i < ctx->lang->libs.count; i++) {
-        ecs_strbuf_append(cmd, " %s.lib", ctx->lang->libs.items[i]);
+        bake_argv_append_fmt(argv, "%s.lib", ctx->lang->libs.items[i]);
     }
     for (int32_t i = 0; i < ctx->dep_libs->count; i++) {
-        ecs_strbuf_append(cmd, " %s.lib", ctx->dep_libs->items[i]);
+        bake_argv_append_fmt(argv, "%s.lib", ctx->dep_libs->items[i]);
     }
-    ecs_strbuf_append(cmd, " /Fe\"%s\"", ctx->artefact);
-    ecs_strbuf_appendstr(cmd, " /link");
-    bake_list_append_fmt(cmd, ctx->mode_ldflags, "");
-    bake_list_append_fmt(cmd, &ctx->lang->ldflags, "");
-    bake_list_append_fmt(cmd, ctx->dep_ldflags, "");
+    bake_argv_append_fmt(argv, "/Fe%s", ctx->artefact);
+    bake_strlist_append(argv, "/link");
+    bake_argv_append_list(argv, ctx->mode_ldflags, "");
+    bake_argv_append_list(argv, &ctx->lang->ldflags, "");
+    bake_argv_append_list(argv, ctx->dep_ldflags, "");
     for (int32_t i = 0; i < ctx->lang->libpaths.count; i++) {
-        ecs_strbuf_append(cmd, " /LIBPATH:\"%s\"", ctx->lang->libpaths.items[i]);
+        bake_argv_append_fmt(argv, "/LIBPATH:%s", ctx->lang->libpaths.items[i]);
     }
     for (int32_t i = 0; i < ctx->dep_libpaths->count; i++) {
-        ecs_strbuf_append(cmd, " /LIBPATH:\"%s\"", ctx->dep_libpaths->items[i]);
+        bake_argv_append_fmt(argv, "/LIBPATH:%s", ctx->dep_libpaths->items[i]);
     }
     return 0;
 }
@@ -2,122 +2,283 @@
 #include "compile_internal.h"
 #include "bake/os.h"
 
-static void bake_strbuf_append_quoted_path(
-    ecs_strbuf_t *cmd, const char *prefix, const char *path)
-{
-    ecs_strbuf_append(cmd, "%s\"", prefix);
-#if defined(_WIN32)
-    for (const char *p = path; *p; p++) {
-        ecs_strbuf_appendch(cmd, (*p == '\\') ? '/' : *p);
-    }
-#else
-    ecs_strbuf_appendstr(cmd, path);
-#endif
-    ecs_strbuf_appendstr(cmd, "\"");
+static bool bake_is_header_file(const char *path) {
+    return bake_has_suffix(path, ".h") || bake_has_suffix(path, ".hh") ||
+        bake_has_suffix(path, ".hpp") || bake_has_suffix(path, ".hxx");
 }
 
-int bake_compose_compile_command_posix(const bake_compile_cmd_ctx_t *ctx, ecs_strbuf_t *cmd) {
+int bake_compose_compile_prefix_posix(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv) {
     const char *compiler = ctx->unit->cpp
         ? (ctx->ctx->opts.cxx ? ctx->ctx->opts.cxx : "c++")
         : (ctx->ctx->opts.cc ? ctx->ctx->opts.cc : "cc");
 
-    ecs_strbuf_append(cmd, "%s -c", compiler);
-    for (int32_t i = 0; i < ctx->mode_flags->count; i++) {
-        ecs_strbuf_append(cmd, " %s", ctx->mode_flags->items[i]);
+    bake_strlist_append(argv, compiler);
+    bake_strlist_append(argv, "-c");
+    bake_argv_append_list(argv, ctx->mode_flags, "");
+    if (bake_project_cfg_shared_library(ctx->cfg)) {
+        bake_strlist_append(argv, "-fPIC");
     }
 
     if (!ctx->unit->cpp && ctx->lang->c_standard) {
-        ecs_strbuf_append(cmd, " -std=%s", ctx->lang->c_standard);
+        bake_argv_append_fmt(argv, "-std=%s", ctx->lang->c_standard);
     } else if (ctx->unit->cpp && ctx->lang->cpp_standard) {
-        ecs_strbuf_append(cmd, " -std=%s", ctx->lang->cpp_standard);
+        bake_argv_append_fmt(argv, "-std=%s", ctx->lang->cpp_standard);
     }
 
-    bake_list_append_fmt(cmd, &ctx->lang->cflags, "");
+    bake_argv_append_list(argv, &ctx->lang->cflags, "");
     if (ctx->unit->cpp) {
-        bake_list_append_fmt(cmd, &ctx->lang->cxxflags, "");
+        bake_argv_append_list(argv, &ctx->lang->cxxflags, "");
     }
-    bake_list_append_fmt(cmd, &ctx->lang->defines, "-D");
-    ecs_strbuf_append(cmd, " -DBAKE_PROJECT_ID=\\\"%s\\\"", ctx->cfg->id);
-    if (ctx->cfg->kind == BAKE_PROJECT_PACKAGE) {
-        char *macro = bake_project_id_as_macro(ctx->cfg->id);
-        ecs_strbuf_append(cmd, " -D%s_EXPORTS", macro);
-        ecs_os_free(macro);
+    bake_argv_append_list(argv, &ctx->lang->defines, "-D");
+    if (ctx->pch && ctx->pch->file) {
+        if (ctx->ctx->compiler_kind == BAKE_COMPILER_CLANG) {
+            bake_strlist_append(argv, "-include-pch");
+            bake_strlist_append(argv, ctx->pch->file);
+        } else {
+            bake_argv_append_fmt(argv, "-I%s", ctx->pch->dir);
+        }
     }
 
-    char *include = bake_path_join(ctx->cfg->path, "include");
-    if (bake_path_exists(include)) {
-        bake_strbuf_append_quoted_path(cmd, " -I", include);
+    /* Shared objects must not depend on the include root of a project. The
+     * include root links the headers published by dependencies itself. */
+    bool include_root = ctx->include_root && !ctx->shared;
+    for (int32_t i = 0; !include_root && ctx->pch &&
+        i < ctx->pch->shared_dirs.count; i++)
+    {
+        bake_argv_append_fmt(argv, "-I%s", ctx->pch->shared_dirs.items[i]);
     }
-    ecs_os_free(include);
+    if (!ctx->shared) {
+        bake_argv_append_fmt(argv, "-DBAKE_PROJECT_ID=\"%s\"", ctx->cfg->id);
+        if (ctx->cfg->kind == BAKE_PROJECT_PACKAGE) {
+            char *macro = bake_project_id_as_macro(ctx->cfg->id);
+            bake_argv_append_fmt(argv, "-D%s_EXPORTS", macro);
+            ecs_os_free(macro);
+        }
 
-    for (int32_t i = 0; i < ctx->lang->include_paths.count; i++) {
-        bake_strbuf_append_quoted_path(cmd, " -I", ctx->lang->include_paths.items[i]);
+        char *include = bake_path_join(ctx->cfg->path, "include");
+        if (!include_root && bake_path_exists(include)) {
+            bake_argv_append_fmt(argv, "-I%s", include);
+        }
+        ecs_os_free(include);
     }
-    for (int32_t i = 0; i < ctx->dep_includes->count; i++) {
-        bake_strbuf_append_quoted_path(cmd, " -I", ctx->dep_includes->items[i]);
+
+    if (include_root) {
+        bake_argv_append_fmt(argv, "-I%s", ctx->include_root);
+    } else {
+        for (int32_t i = 0; i < ctx->lang->include_paths.count; i++) {
+            bake_argv_append_fmt(argv, "-I%s", ctx->lang->include_paths.items[i]);
+        }
+        for (int32_t i = 0; i < ctx->dep_includes->count; i++) {
+            bake_argv_append_fmt(argv, "-I%s", ctx->dep_includes->items[i]);
+        }
     }
 
+    return 0;
+}
+
+int bake_compose_compile_unit_posix(const bake_compile_cmd_ctx_t *ctx, bake_strlist_t *argv) {
     if (ctx->unit->dep) {
-        bake_strbuf_append_quoted_path(cmd, " -MMD -MF ", ctx->unit->dep);
+        bake_strlist_append(argv, "-MMD");
+        bake_strlist_append(argv, "-MF");
+        bake_strlist_append(argv, ctx->unit->dep);
     }
 
-    bake_strbuf_append_quoted_path(cmd, " -o ", ctx->unit->obj);
-    bake_strbuf_append_quoted_path(cmd, " ", ctx->unit->src);
+    bake_strlist_append(argv, "-o");
+    bake_strlist_append(argv, ctx->unit->obj);
+    if (bake_is_header_file(ctx->unit->src)) {
+        bake_strlist_append(argv, "-x");
+        bake_strlist_append(argv, ctx->unit->cpp ? "c++-header" : "c-header");
+    }
+    bake_strlist_append(argv, ctx->unit->src);
     return 0;
 }
 
-int bake_compose_link_command_posix(const bake_link_cmd_ctx_t *ctx, ecs_strbuf_t *cmd) {
+/* Updates an existing archive without writing its symbol index for every
+ * change: members are deleted and replaced with the S modifier, after which
+ * the index is written once. */
+int32_t bake_compose_archive_update_posix(
+    const bake_link_cmd_ctx_t *ctx,
+    const bake_strlist_t *removed,
+    const bake_strlist_t *replaced,
+    bake_strlist_t *commands)
+{
+    const char *ar = bake_target_is_emscripten() ? "emar" : "ar";
+    int32_t count = 0;
+
+    if (removed->count) {
+        bake_strlist_t *argv = &commands[count++];
+        bake_strlist_append(argv, ar);
+        bake_strlist_append(argv, "dS");
+        bake_strlist_append(argv, ctx->artefact);
+        for (int32_t i = 0; i < removed->count; i++) {
+            bake_strlist_append(argv, removed->items[i]);
+        }
+    }
+
+    if (replaced->count) {
+        bake_strlist_t *argv = &commands[count++];
+        bake_strlist_append(argv, ar);
+        bake_strlist_append(argv, "rS");
+        bake_strlist_append(argv, ctx->artefact);
+        for (int32_t i = 0; i < replaced->count; i++) {
+            bake_strlist_append(argv, replaced->items[i]);
+        }
+    }
+
+    bake_strlist_t *argv = &commands[count++];
+    bake_strlist_append(argv, ar);
+    bake_strlist_append(argv, "s");
+    bake_strlist_append(argv, ctx->artefact);
+    return count;
+}
+
+/* The GNU linker can't build a gdb index, which saves debuggers from reading
+ * the .dwo files of a binary with split debug info to find its symbols. */
+static void bake_append_linker_posix(
+    const bake_link_cmd_ctx_t *ctx,
+    bake_strlist_t *argv)
+{
+    if (!ctx->linker) {
+        return;
+    }
+
+    bake_argv_append_fmt(argv, "-fuse-ld=%s", ctx->linker);
+    if (strcmp(ctx->linker, "bfd") &&
+        bake_strlist_contains(ctx->mode_ldflags, "-gsplit-dwarf"))
+    {
+        bake_strlist_append(argv, "-Wl,--gdb-index");
+    }
+}
+
+/* Dependencies are left out of shared libraries: static packages aren't
+ * position independent, and are linked into the executables instead, which
+ * export the symbols that shared libraries use. */
+static int bake_compose_shared_library_command_posix(
+    const bake_link_cmd_ctx_t *ctx,
+    const char *linker,
+    bake_strlist_t *argv)
+{
+    char *file_name = bake_path_basename(ctx->artefact);
+    bake_strlist_append(argv, linker);
+#if defined(__APPLE__)
+    bake_strlist_append(argv, "-dynamiclib");
+    bake_strlist_append(argv, "-install_name");
+    bake_argv_append_fmt(argv, "@rpath/%s", file_name);
+    bake_strlist_append(argv, "-undefined");
+    bake_strlist_append(argv, "dynamic_lookup");
+#else
+    bake_strlist_append(argv, "-shared");
+    bake_argv_append_fmt(argv, "-Wl,-soname,%s", file_name);
+#endif
+    ecs_os_free(file_name);
+
+    bake_append_linker_posix(ctx, argv);
+    for (int32_t i = 0; i < ctx->units->count; i++) {
+        bake_strlist_append(argv, ctx->units->items[i].obj);
+    }
+    bake_argv_append_list(argv, ctx->mode_ldflags, "");
+    bake_argv_append_list(argv, &ctx->lang->ldflags, "");
+    for (int32_t i = 0; i < ctx->lang->libpaths.count; i++) {
+        bake_argv_append_fmt(argv, "-L%s", ctx->lang->libpaths.items[i]);
+    }
+    for (int32_t i = 0; i < ctx->lang->libs.count; i++) {
+        bake_argv_append_fmt(argv, "-l%s", ctx->lang->libs.items[i]);
+    }
+
+    bake_strlist_append(argv, "-o");
+    bake_strlist_append(argv, ctx->artefact);
+    return 0;
+}
+
+const char* bake_link_driver_posix(const bake_context_t *ctx, bool use_cpp) {
+    return use_cpp
+        ? (ctx->opts.cxx ? ctx->opts.cxx : "c++")
+        : (ctx->opts.cc ? ctx->opts.cc : "cc");
+}
+
+int bake_compose_link_command_posix(const bake_link_cmd_ctx_t *ctx, bake_strlist_t *argv) {
     bool is_lib = ctx->cfg->kind == BAKE_PROJECT_PACKAGE;
-    if (is_lib) {
-        const char *ar_prefix = bake_target_is_emscripten() ? "emar rcs " : "ar rcs ";
-        bake_strbuf_append_quoted_path(cmd, ar_prefix, ctx->artefact);
+    const char *linker = bake_link_driver_posix(ctx->ctx, ctx->use_cpp);
+
+    if (is_lib && bake_project_cfg_shared_library(ctx->cfg)) {
+        return bake_compose_shared_library_command_posix(ctx, linker, argv);
+    }
+
+    if (is_lib && ctx->archive == BAKE_ARCHIVE_PRELINK) {
+        /* Link through the compiler driver, so that LTO objects are prelinked
+         * with the LTO plugin instead of being concatenated. */
+        bake_strlist_append(argv, linker);
+        bake_strlist_append(argv, "-r");
+        bake_strlist_append(argv, "-nostdlib");
         for (int32_t i = 0; i < ctx->units->count; i++) {
-            bake_strbuf_append_quoted_path(cmd, " ", ctx->units->items[i].obj);
+            bake_strlist_append(argv, ctx->units->items[i].obj);
         }
+        bake_argv_append_list(argv, ctx->mode_ldflags, "");
+        bake_strlist_append(argv, "-o");
+        bake_strlist_append(argv, ctx->artefact);
         return 0;
     }
 
-    const char *linker = ctx->use_cpp
-        ? (ctx->ctx->opts.cxx ? ctx->ctx->opts.cxx : "c++")
-        : (ctx->ctx->opts.cc ? ctx->ctx->opts.cc : "cc");
+    if (is_lib) {
+        bool thin = ctx->archive == BAKE_ARCHIVE_THIN;
+        bake_strlist_append(argv, bake_target_is_emscripten() ? "emar" : "ar");
+        bake_strlist_append(argv, thin ? "rcsT" : "rcs");
+        bake_strlist_append(argv, ctx->artefact);
+        for (int32_t i = 0; i < ctx->units->count; i++) {
+            const char *obj = ctx->units->items[i].obj;
 
-    ecs_strbuf_append(cmd, "%s", linker);
+            /* Thin archives store members by the path they're added with, so
+             * absolute paths keep copies of the archive in BAKE_HOME valid. */
+            char *abs = thin ? bake_path_resolve(obj) : NULL;
+            bake_strlist_append(argv, abs ? abs : obj);
+            ecs_os_free(abs);
+        }
+        return 0;
+    }
+
+    bake_strlist_append(argv, linker);
+    bake_append_linker_posix(ctx, argv);
     for (int32_t i = 0; i < ctx->units->count; i++) {
-        bake_strbuf_append_quoted_path(cmd, " ", ctx->units->items[i].obj);
+        bake_strlist_append(argv, ctx->units->items[i].obj);
     }
 #if !defined(__APPLE__)
     if (ctx->dep_artefacts->count > 0) {
-        ecs_strbuf_appendstr(cmd, " -Wl,--start-group");
+        bake_strlist_append(argv, "-Wl,--start-group");
     }
 #endif
     for (int32_t i = 0; i < ctx->dep_artefacts->count; i++) {
-        bake_strbuf_append_quoted_path(cmd, " ", ctx->dep_artefacts->items[i]);
+        bake_strlist_append(argv, ctx->dep_artefacts->items[i]);
     }
 #if !defined(__APPLE__)
     if (ctx->dep_artefacts->count > 0) {
-        ecs_strbuf_appendstr(cmd, " -Wl,--end-group");
+        bake_strlist_append(argv, "-Wl,--end-group");
     }
 #endif
-    bake_list_append_fmt(cmd, ctx->mode_ldflags, "");
-    bake_list_append_fmt(cmd, &ctx->lang->ldflags, "");
-    bake_list_append_fmt(cmd, ctx->dep_ldflags, "");
+    bake_argv_append_list(argv, ctx->mode_ldflags, "");
+    bake_argv_append_list(argv, &ctx->lang->ldflags, "");
+    bake_argv_append_list(argv, ctx->dep_ldflags, "");
     for (int32_t i = 0; i < ctx->lang->libpaths.count; i++) {
-        bake_strbuf_append_quoted_path(cmd, " -L", ctx->lang->libpaths.items[i]);
+        bake_argv_append_fmt(argv, "-L%s", ctx->lang->libpaths.items[i]);
     }
     for (int32_t i = 0; i < ctx->dep_libpaths->count; i++) {
-        bake_strbuf_append_quoted_path(cmd, " -L", ctx->dep_libpaths->items[i]);
+        bake_argv_append_fmt(argv, "-L%s", ctx->dep_libpaths->items[i]);
     }
     for (int32_t i = 0; i < ctx->lang->libs.count; i++) {
-        ecs_strbuf_append(cmd, " -l%s", ctx->lang->libs.items[i]);
+        bake_argv_append_fmt(argv, "-l%s", ctx->lang->libs.items[i]);
     }
     for (int32_t i = 0; i < ctx->dep_libs->count; i++) {
-        ecs_strbuf_append(cmd, " -l%s", ctx->dep_libs->items[i]);
+        bake_argv_append_fmt(argv, "-l%s", ctx->dep_libs->items[i]);
     }
 
     if (bake_target_is_emscripten()) {
-        ecs_strbuf_appendstr(cmd, " -s ALLOW_MEMORY_GROWTH=1");
-        ecs_strbuf_appendstr(cmd, " -s EXPORTED_RUNTIME_METHODS=cwrap");
-        ecs_strbuf_appendstr(cmd, " -s MODULARIZE=1");
+        static const char *em_flags[] = {
+            "-s", "ALLOW_MEMORY_GROWTH=1",
+            "-s", "EXPORTED_RUNTIME_METHODS=cwrap",
+            "-s", "MODULARIZE=1", NULL
+        };
+        for (int32_t i = 0; em_flags[i]; i++) {
+            bake_strlist_append(argv, em_flags[i]);
+        }
 
         const char *export_name = ctx->cfg->output_name;
         char *export_name_alloc = NULL;
@@ -125,15 +286,17 @@ int bake_compose_link_command_posix(const bake_link_cmd_ctx_t *ctx, ecs_strbuf_t
             export_name_alloc = bake_project_id_as_macro(ctx->cfg->id);
             export_name = export_name_alloc;
         }
-        ecs_strbuf_append(cmd, " -s EXPORT_NAME=\"%s\"", export_name);
+        bake_strlist_append(argv, "-s");
+        bake_argv_append_fmt(argv, "EXPORT_NAME=%s", export_name);
         ecs_os_free(export_name_alloc);
 
         for (int32_t i = 0; i < ctx->lang->embed.count; i++) {
-            bake_strbuf_append_quoted_path(
-                cmd, " --embed-file ", ctx->lang->embed.items[i]);
+            bake_strlist_append(argv, "--embed-file");
+            bake_strlist_append(argv, ctx->lang->embed.items[i]);
         }
     }
 
-    bake_strbuf_append_quoted_path(cmd, " -o ", ctx->artefact);
+    bake_strlist_append(argv, "-o");
+    bake_strlist_append(argv, ctx->artefact);
     return 0;
 }
@@ -2,11 +2,8 @@
 #include "depcheck_internal.h"
 #include "bake/os.h"
 
-static bool bake_dep_token_outdated(const char *token, int64_t obj_mtime) {
-    if (!token[0]) {
-        return false;
-    }
-
+static bool bake_dep_token_outdated(const char *token, void *ctx) {
+    int64_t obj_mtime = *(const int64_t*)ctx;
     int64_t mtime = bake_os_file_mtime(token);
     if (mtime < 0) {
         return true;
@@ -28,15 +25,17 @@ static char* bake_dep_token_reserve(char *token, size_t token_len, size_t *token
     return ecs_os_realloc_n(token, char, next_cap);
 }
 
-bool bake_depfile_outdated(const char *dep_path, int64_t obj_mtime) {
-    size_t len = 0;
-    char *content = bake_file_read(dep_path, &len);
-    if (!content) {
-        return true;
+int bake_depfile_walk(const char *dep_path, bake_depfile_cb cb, void *ctx) {
+    bake_file_map_t map;
+    if (bake_file_map(dep_path, &map) != 0) {
+        return -1;
     }
 
+    const char *content = map.data;
+    size_t len = map.len;
+
     bool seen_colon = false;
-    bool outdated = false;
+    bool stopped = false;
     size_t token_cap = 256;
     size_t token_len = 0;
     char *token = ecs_os_malloc(token_cap);
@@ -72,8 +71,8 @@ bool bake_depfile_outdated(const char *dep_path, int64_t obj_mtime) {
                 next_ch == ':';
             token = bake_dep_token_reserve(token, token_len, &token_cap);
             if (!token) {
-                ecs_os_free(content);
-                return true;
+                bake_file_unmap(&map);
+                return -1;
             }
             if (is_escape) {
                 token[token_len++] = content[++i];
@@ -85,11 +84,11 @@ bool bake_depfile_outdated(const char *dep_path, int64_t obj_mtime) {
 
         if (bake_char_is_space(ch)) {
             token[token_len] = '\0';
-            if (token_len && bake_dep_token_outdated(token, obj_mtime)) {
-                outdated = true;
+            if (token_len && cb(token, ctx)) {
+                stopped = true;
             }
             token_len = 0;
-            if (outdated) {
+            if (stopped) {
                 break;
             }
             continue;
@@ -97,22 +96,26 @@ bool bake_depfile_outdated(const char *dep_path, int64_t obj_mtime) {
 
         token = bake_dep_token_reserve(token, token_len, &token_cap);
         if (!token) {
-            ecs_os_free(content);
-            return true;
+            bake_file_unmap(&map);
+            return -1;
         }
         token[token_len++] = ch;
     }
 
-    if (!outdated) {
+    if (!stopped) {
         token[token_len] = '\0';
-        if (token_len && bake_dep_token_outdated(token, obj_mtime)) {
-            outdated = true;
+        if (token_len && cb(token, ctx)) {
+            stopped = true;
         }
     }
 
     ecs_os_free(token);
-    ecs_os_free(content);
-    return outdated;
+    bake_file_unmap(&map);
+    return stopped ? 1 : 0;
+}
+
+bool bake_depfile_outdated(const char *dep_path, int64_t obj_mtime) {
+    return bake_depfile_walk(dep_path, bake_dep_token_outdated, &obj_mtime) != 0;
 }
 
 int64_t bake_project_json_mtime(const bake_project_cfg_t *cfg) {
@@ -187,11 +190,15 @@ char* bake_library_name_from_artefact(const char *artefact) {
         name[len - suffix_len] = '\0';
     }
 #else
-    const char *suffix = ".a";
+    /* Packages can also be a relocatable object or a shared library. */
+    const char *suffixes[] = { ".a", ".o", ".so", ".dylib" };
     size_t len = strlen(name);
-    size_t suffix_len = strlen(suffix);
-    if (len > suffix_len && !strcmp(name + len - suffix_len, suffix)) {
-        name[len - suffix_len] = '\0';
+    for (int i = 0; i < 4; i++) {
+        size_t suffix_len = strlen(suffixes[i]);
+        if (len > suffix_len && !strcmp(name + len - suffix_len, suffixes[i])) {
+            name[len - suffix_len] = '\0';
+            break;
+        }
     }
     if (!strncmp(name, "lib", 3)) {
         memmove(name, name + 3, strlen(name + 3) + 1);
@@ -201,6 +208,24 @@ char* bake_library_name_from_artefact(const char *artefact) {
     return name;
 }
 
+bool bake_artefact_is_shared_library(const char *artefact) {
+    return bake_has_suffix(artefact, ".so") || bake_has_suffix(artefact, ".dylib");
+}
+
+/* Dependents of a shared library only relink when the symbols it exports
+ * change, which is when its interface file is written. */
+int64_t bake_dep_artefact_mtime(const char *artefact) {
+    if (bake_artefact_is_shared_library(artefact)) {
+        char *interface = flecs_asprintf("%s.symbols", artefact);
+        int64_t mtime = bake_os_file_mtime(interface);
+        ecs_os_free(interface);
+        if (mtime >= 0) {
+            return mtime;
+        }
+    }
+    return bake_os_file_mtime(artefact);
+}
+
 bool bake_has_dep_artefact_for_lib(
     const bake_strlist_t *artefacts,
     const char *lib)
@@ -3,6 +3,12 @@
 
 #include "build_internal.h"
 
+/* Called for each prerequisite of a depfile, returns true to stop the walk. */
+typedef bool (*bake_depfile_cb)(const char *path, void *ctx);
+
+/* Returns -1 when the depfile can't be read, 1 when the callback stopped the
+ * walk and 0 otherwise. */
+int bake_depfile_walk(const char *dep_path, bake_depfile_cb cb, void *ctx);
 bool bake_depfile_outdated(const char *dep_path, int64_t obj_mtime);
 int64_t bake_project_json_mtime(const bake_project_cfg_t *cfg);
 bool bake_compile_unit_outdated(
@@ -12,6 +18,8 @@ bool bake_project_json_outdated(
     const bake_project_cfg_t *cfg,
     int64_t artefact_mtime);
 char* bake_library_name_from_artefact(const char *artefact);
+bool bake_artefact_is_shared_library(const char *artefact);
+int64_t bake_dep_artefact_mtime(const char *artefact);
 bool bake_has_dep_artefact_for_lib(
     const bake_strlist_t *artefacts,
     const char *lib);
@@ -0,0 +1,128 @@
+#include "build_internal.h"
+#include "depcheck_internal.h"
+#include "bake/os.h"
+
+typedef struct bake_include_dir_t {
+    char *path;
+    int32_t dep;
+} bake_include_dir_t;
+
+typedef struct bake_include_walk_t {
+    const bake_include_dir_t *dirs;
+    int32_t dir_count;
+    bool *used; /* Indexed by dependency */
+} bake_include_walk_t;
+
+static bool bake_include_report_visit(const char *path, void *arg) {
+    bake_include_walk_t *walk = arg;
+    for (int32_t i = 0; i < walk->dir_count; i++) {
+        if (bake_path_has_prefix_normalized(path, walk->dirs[i].path, NULL)) {
+            walk->used[walk->dirs[i].dep] = true;
+            break;
+        }
+    }
+    return false;
+}
+
+static void bake_include_report_add_dir(
+    ecs_vec_t *dirs,
+    char *path,
+    int32_t dep)
+{
+    if (!path || !bake_path_exists(path)) {
+        ecs_os_free(path);
+        return;
+    }
+    bake_include_dir_t *dir = ecs_vec_append_t(NULL, dirs, bake_include_dir_t);
+    dir->path = path;
+    dir->dep = dep;
+}
+
+/* Depfiles list every header a unit read, so a dependency is needed by a unit
+ * when one of the listed headers is in the include directory of the dependency.
+ * Precompiled headers are disabled while reporting, as headers read from them
+ * are left out of depfiles. */
+void bake_report_include_usage(
+    const bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_compile_list_t *units)
+{
+    const BakeResolvedDeps *resolved =
+        ecs_get(ctx->world, project_entity, BakeResolvedDeps);
+    int32_t dep_count = resolved ? resolved->dep_count : 0;
+
+    ecs_vec_t dirs;
+    ecs_vec_init_t(NULL, &dirs, bake_include_dir_t, 0);
+    const char **ids = ecs_os_calloc_n(const char*, dep_count ? dep_count : 1);
+    for (int32_t d = 0; d < dep_count; d++) {
+        const BakeProject *dep = ecs_get(ctx->world, resolved->deps[d], BakeProject);
+        if (!dep || !dep->cfg || !dep->cfg->id) {
+            continue;
+        }
+        ids[d] = dep->cfg->id;
+        if (dep->cfg->path) {
+            bake_include_report_add_dir(
+                &dirs, bake_path_join(dep->cfg->path, "include"), d);
+        }
+        bake_include_report_add_dir(
+            &dirs, bake_path_join3(ctx->bake_home, "include", dep->cfg->id), d);
+    }
+
+    int32_t unit_count = units->count;
+    bool *used = ecs_os_calloc_n(bool, (dep_count ? dep_count : 1) * (unit_count ? unit_count : 1));
+    bool *reported = ecs_os_calloc_n(bool, unit_count ? unit_count : 1);
+    int32_t reported_count = 0;
+    for (int32_t u = 0; u < unit_count; u++) {
+        const bake_compile_unit_t *unit = &units->items[u];
+        if (!unit->dep) {
+            continue;
+        }
+
+        bake_include_walk_t walk = {
+            .dirs = ecs_vec_first_t(&dirs, bake_include_dir_t),
+            .dir_count = ecs_vec_count(&dirs),
+            .used = &used[u * dep_count]
+        };
+        if (bake_depfile_walk(unit->dep, bake_include_report_visit, &walk) < 0) {
+            continue;
+        }
+        reported[u] = true;
+        reported_count++;
+    }
+
+    printf("include usage of %s (%d units):\n", cfg->id, reported_count);
+    for (int32_t d = 0; d < dep_count; d++) {
+        if (!ids[d]) {
+            continue;
+        }
+
+        int32_t count = 0;
+        for (int32_t u = 0; u < unit_count; u++) {
+            count += reported[u] && used[u * dep_count + d];
+        }
+        if (!count) {
+            printf("  %s: not included\n", ids[d]);
+            continue;
+        }
+
+        printf("  %s: %d units\n", ids[d], count);
+        for (int32_t u = 0; u < unit_count; u++) {
+            if (!reported[u] || !used[u * dep_count + d]) {
+                continue;
+            }
+            char *display = bake_display_path(units->items[u].src, cfg->path);
+            printf("    %s\n", display);
+            ecs_os_free(display);
+        }
+    }
+
+    bake_include_dir_t *items = ecs_vec_first_t(&dirs, bake_include_dir_t);
+    for (int32_t i = 0; i < ecs_vec_count(&dirs); i++) {
+        ecs_os_free(items[i].path);
+    }
+    ecs_vec_fini_t(NULL, &dirs, bake_include_dir_t);
+    ecs_os_free(ids);
+    ecs_os_free(used);
+    ecs_os_free(reported);
+}
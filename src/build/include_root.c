@@ -0,0 +1,207 @@
+#include "build_internal.h"
+#include "bake/os.h"
+
+/* An include root is a directory of symlinks to the entries of every include
+ * directory of a build, so that the compiler searches one directory instead
+ * of probing each include directory for every include. Entries are linked in
+ * search order and the first one wins, like it would with -I. Directories
+ * that exist in more than one include directory are created in the root, and
+ * their entries merged the same way.
+ *
+ * The layout is planned first, as lines of "d <dir>" and "l <link>\t<target>".
+ * The root is only recreated when the plan differs from the previous build. */
+
+static int bake_include_root_plan(
+    ecs_strbuf_t *plan,
+    const char *rel,
+    const bake_strlist_t *dirs)
+{
+    bake_strlist_t handled;
+    bake_strlist_init(&handled);
+    int rc = -1;
+
+    for (int32_t i = 0; i < dirs->count; i++) {
+        bake_dir_entry_t *entries = NULL;
+        int32_t count = 0;
+        if (bake_dir_list(dirs->items[i], &entries, &count) != 0) {
+            goto cleanup;
+        }
+
+        for (int32_t e = 0; e < count; e++) {
+            const bake_dir_entry_t *entry = &entries[e];
+            if (bake_is_dot_dir(entry->name) ||
+                bake_strlist_contains(&handled, entry->name))
+            {
+                continue;
+            }
+            bake_strlist_append(&handled, entry->name);
+
+            char *entry_rel = rel[0] ?
+                flecs_asprintf("%s/%s", rel, entry->name) :
+                ecs_os_strdup(entry->name);
+
+            /* Later include directories only matter when the entry is a
+             * directory in more than one of them. */
+            bake_strlist_t merge;
+            bake_strlist_init(&merge);
+            if (bake_path_is_dir(entry->path)) {
+                for (int32_t j = i; j < dirs->count; j++) {
+                    char *path = bake_path_join(dirs->items[j], entry->name);
+                    if (bake_path_is_dir(path)) {
+                        bake_strlist_append(&merge, path);
+                    }
+                    ecs_os_free(path);
+                }
+            }
+
+            int entry_rc = 0;
+            if (merge.count > 1) {
+                ecs_strbuf_append(plan, "d %s\n", entry_rel);
+                entry_rc = bake_include_root_plan(plan, entry_rel, &merge);
+            } else {
+                ecs_strbuf_append(plan, "l %s\t%s\n", entry_rel, entry->path);
+            }
+
+            bake_strlist_fini(&merge);
+            ecs_os_free(entry_rel);
+            if (entry_rc != 0) {
+                bake_dir_entries_free(entries, count);
+                goto cleanup;
+            }
+        }
+
+        bake_dir_entries_free(entries, count);
+    }
+
+    rc = 0;
+cleanup:
+    bake_strlist_fini(&handled);
+    return rc;
+}
+
+static int bake_include_root_create(const char *root, char *plan) {
+    if (bake_os_rmtree(root) != 0 || bake_os_mkdirs(root) != 0) {
+        return -1;
+    }
+
+    for (char *line = plan; line && *line; ) {
+        char *next = strchr(line, '\n');
+        if (next) {
+            *next = '\0';
+        }
+
+        int rc = 0;
+        char *target = strchr(line, '\t');
+        if (target) {
+            *target = '\0';
+        }
+        char *path = bake_path_join(root, line + 2);
+        if (line[0] == 'd') {
+            rc = bake_os_mkdir(path);
+            if (rc != 0) {
+                bake_log_errno_last("create directory", path);
+            }
+        } else if (target) {
+            rc = bake_os_symlink(target + 1, path);
+            *target = '\t';
+        }
+        ecs_os_free(path);
+        if (next) {
+            *next = '\n';
+        }
+        if (rc != 0) {
+            return -1;
+        }
+
+        line = next ? next + 1 : NULL;
+    }
+
+    return 0;
+}
+
+static void bake_include_root_add(bake_strlist_t *dirs, const char *path) {
+    char *abs = bake_path_resolve(path);
+    if (abs && bake_path_is_dir(abs)) {
+        bake_strlist_append_unique(dirs, abs);
+    }
+    ecs_os_free(abs);
+}
+
+int bake_include_root_prepare(
+    const bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_lang_cfg_t *lang,
+    bool cpp,
+    const bake_pch_t *pch,
+    char **root_out)
+{
+    *root_out = NULL;
+
+#if defined(_WIN32)
+    /* Creating symlinks requires developer mode or elevation on Windows. */
+    (void)ctx; (void)project_entity; (void)cfg; (void)paths; (void)lang; (void)cpp;
+    (void)pch;
+    return 0;
+#else
+    const BakeResolvedDeps *resolved =
+        ecs_get(ctx->world, project_entity, BakeResolvedDeps);
+
+    bake_strlist_t dirs;
+    bake_strlist_init(&dirs);
+    char *include = bake_path_join(cfg->path, "include");
+    bake_include_root_add(&dirs, include);
+    ecs_os_free(include);
+    for (int32_t i = 0; i < lang->include_paths.count; i++) {
+        bake_include_root_add(&dirs, lang->include_paths.items[i]);
+    }
+    if (resolved) {
+        for (int32_t i = 0; i < resolved->include_paths.count; i++) {
+            bake_include_root_add(&dirs, resolved->include_paths.items[i]);
+        }
+    }
+
+    /* Headers published by dependencies are searched last. Their stubs are
+     * shadowed by the real headers, and the precompiled variants are linked
+     * next to those, where the compiler looks for them. */
+    for (int32_t i = 0; pch && i < pch->shared_dirs.count; i++) {
+        bake_include_root_add(&dirs, pch->shared_dirs.items[i]);
+    }
+
+    int rc = -1;
+    char *plan = NULL;
+    char *root = bake_path_join3(paths->build_root, "include_root", cpp ? "cpp" : "c");
+    char *plan_path = flecs_asprintf("%s.plan", root);
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    if (bake_include_root_plan(&buf, "", &dirs) != 0) {
+        ecs_strbuf_reset(&buf);
+        goto cleanup;
+    }
+
+    plan = ecs_strbuf_get(&buf);
+    if (!plan) {
+        plan = ecs_os_strdup("");
+    }
+
+    if (!bake_path_is_dir(root) || !bake_file_equals(plan_path, plan, strlen(plan))) {
+        /* Remove the plan first, so an interrupted update is redone. */
+        if (bake_remove_file_if_exists(plan_path) != 0 ||
+            bake_include_root_create(root, plan) != 0 ||
+            bake_file_write(plan_path, plan) != 0)
+        {
+            goto cleanup;
+        }
+    }
+
+    *root_out = root;
+    root = NULL;
+    rc = 0;
+cleanup:
+    bake_strlist_fini(&dirs);
+    ecs_os_free(plan);
+    ecs_os_free(plan_path);
+    ecs_os_free(root);
+    return rc;
+#endif
+}
@@ -0,0 +1,212 @@
+#include "build_internal.h"
+#include "bake/os.h"
+
+/* Linkers that "fast" picks from, fastest first. */
+static const char *bake_fast_linkers[] = { "mold", "lld", "gold", NULL };
+
+/* A linker is usable when the compiler driver accepts -fuse-ld for it and
+ * links a program with it. Older compilers reject linkers they don't know,
+ * even if the linker is installed. */
+static bool bake_linker_probe(
+    const char *driver,
+    const char *linker,
+    const char *probe_dir)
+{
+    char *src = bake_path_join(probe_dir, "linker_probe.c");
+    char *out = bake_path_join(probe_dir, "linker_probe");
+    char *log = bake_path_join(probe_dir, "linker_probe.log");
+    char *flag = flecs_asprintf("-fuse-ld=%s", linker);
+    bool available = false;
+
+    if (bake_file_write(src, "int main(void) { return 0; }\n") == 0) {
+        const char *argv[] = { driver, flag, src, "-o", out, NULL };
+        bake_process_stdio_t stdio_cfg = {
+            .stdout_path = log,
+            .stderr_to_stdout = true
+        };
+        bake_process_result_t result = {0};
+        available = bake_proc_run(argv, &stdio_cfg, &result) == 0 &&
+            !result.exit_code && !result.term_signal && !result.interrupted;
+    }
+
+    bake_remove_file_if_exists(src);
+    bake_remove_file_if_exists(out);
+    bake_remove_file_if_exists(log);
+    ecs_os_free(src);
+    ecs_os_free(out);
+    ecs_os_free(log);
+    ecs_os_free(flag);
+    return available;
+}
+
+/* Finds a program the way the shell does, returns NULL when it's not found. */
+static char* bake_linker_find_program(const char *name) {
+    if (bake_path_last_sep(name)) {
+        return bake_path_exists(name) ? ecs_os_strdup(name) : NULL;
+    }
+
+    const char *path = getenv("PATH");
+#if defined(_WIN32)
+    const char list_sep = ';';
+    const char *ext = bake_has_suffix(name, ".exe") ? "" : ".exe";
+#else
+    const char list_sep = ':';
+    const char *ext = "";
+#endif
+    while (path && path[0]) {
+        const char *end = strchr(path, list_sep);
+        size_t len = end ? (size_t)(end - path) : strlen(path);
+        if (len) {
+            char *dir = ecs_os_malloc(len + 1);
+            memcpy(dir, path, len);
+            dir[len] = '\0';
+            char *file = flecs_asprintf("%s%c%s%s", dir, bake_path_sep(), name, ext);
+            ecs_os_free(dir);
+            if (bake_path_exists(file)) {
+                return file;
+            }
+            ecs_os_free(file);
+        }
+        path = end ? end + 1 : NULL;
+    }
+    return NULL;
+}
+
+/* Identifies a probe by the driver and the ld.<linker> program it runs, with
+ * their modification times, so that a probe is redone when either of them is
+ * installed or updated. */
+static char* bake_linker_probe_key(const char *driver, const char *linker) {
+    char *ld_name = flecs_asprintf("ld.%s", linker);
+    char *programs[2] = {
+        bake_linker_find_program(driver),
+        bake_linker_find_program(ld_name)
+    };
+    ecs_os_free(ld_name);
+
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    ecs_strbuf_append(&buf, "%s", linker);
+    for (int i = 0; i < 2; i++) {
+        ecs_strbuf_append(&buf, " %lld %s",
+            (long long)(programs[i] ? bake_os_file_mtime(programs[i]) : -1),
+            programs[i] ? programs[i] : (i ? "-" : driver));
+        ecs_os_free(programs[i]);
+    }
+    return ecs_strbuf_get(&buf);
+}
+
+/* Probe results are kept in BAKE_HOME, so that builds with nothing to link
+ * don't spawn probes. Each line has a 0 or 1 followed by the probe key. */
+static char* bake_linker_cache_path(const bake_context_t *ctx) {
+    return bake_path_join3(ctx->bake_home, "cache", "linkers");
+}
+
+static void bake_linker_cache_load(bake_context_t *ctx) {
+    ctx->linkers_loaded = true;
+    char *path = bake_linker_cache_path(ctx);
+    char *content = bake_path_exists(path) ? bake_file_read(path, NULL) : NULL;
+    char *line = content;
+    while (line && *line) {
+        char *eol = strchr(line, '\n');
+        if (eol) {
+            *eol = '\0';
+        }
+        if ((line[0] == '0' || line[0] == '1') && line[1] == ' ' && line[2]) {
+            bake_strlist_append(line[0] == '1' ?
+                &ctx->linkers_found : &ctx->linkers_missing, line + 2);
+        }
+        line = eol ? eol + 1 : NULL;
+    }
+    ecs_os_free(content);
+    ecs_os_free(path);
+}
+
+static void bake_linker_cache_store(const bake_context_t *ctx) {
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    for (int32_t i = 0; i < ctx->linkers_found.count; i++) {
+        ecs_strbuf_append(&buf, "1 %s\n", ctx->linkers_found.items[i]);
+    }
+    for (int32_t i = 0; i < ctx->linkers_missing.count; i++) {
+        ecs_strbuf_append(&buf, "0 %s\n", ctx->linkers_missing.items[i]);
+    }
+
+    char *path = bake_linker_cache_path(ctx);
+    char *dir = bake_path_dirname(path);
+    char *content = ecs_strbuf_get(&buf);
+    if (bake_os_mkdirs(dir) != 0 || bake_file_write(path, content) != 0) {
+        ecs_warn("failed to store linker probe results in %s", path);
+    }
+    ecs_os_free(content);
+    ecs_os_free(dir);
+    ecs_os_free(path);
+}
+
+/* Probes each linker once per driver, however many projects are linked, and
+ * stores the result until the driver or linker changes. */
+static bool bake_linker_available(
+    bake_context_t *ctx,
+    const char *driver,
+    const char *linker,
+    const char *probe_dir,
+    bool required)
+{
+    if (!ctx->linkers_loaded) {
+        bake_linker_cache_load(ctx);
+    }
+
+    char *key = bake_linker_probe_key(driver, linker);
+    bool available = bake_strlist_contains(&ctx->linkers_found, key);
+    bool missing = !available && bake_strlist_contains(&ctx->linkers_missing, key);
+    if (!available && !missing) {
+        available = bake_linker_probe(driver, linker, probe_dir);
+        if (ctx->opts.trace) {
+            ecs_trace("linker %s is %s for %s",
+                linker, available ? "available" : "not available", driver);
+        }
+        bake_strlist_append(
+            available ? &ctx->linkers_found : &ctx->linkers_missing, key);
+        bake_linker_cache_store(ctx);
+    }
+    if (!available && required &&
+        !bake_strlist_contains(&ctx->linkers_warned, key))
+    {
+        ecs_warn("linker '%s' is not available for %s, "
+            "using the default linker", linker, driver);
+        bake_strlist_append(&ctx->linkers_warned, key);
+    }
+    ecs_os_free(key);
+    return available;
+}
+
+const char* bake_select_linker(
+    bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const char *driver,
+    const char *probe_dir)
+{
+    const char *linker = ctx->opts.linker ? ctx->opts.linker : cfg->linker;
+    if (!linker || !linker[0] || !strcmp(linker, "default")) {
+        return NULL;
+    }
+
+    /* MSVC and emscripten come with a single linker. */
+    if (ctx->compiler_kind == BAKE_COMPILER_MSVC || bake_target_is_emscripten()) {
+        return NULL;
+    }
+
+    if (!strcmp(linker, "fast")) {
+        for (int32_t i = 0; bake_fast_linkers[i]; i++) {
+            if (bake_linker_available(
+                ctx, driver, bake_fast_linkers[i], probe_dir, false))
+            {
+                return bake_fast_linkers[i];
+            }
+        }
+        return NULL;
+    }
+
+    if (!bake_linker_available(ctx, driver, linker, probe_dir, true)) {
+        return NULL;
+    }
+
+    return linker;
+}
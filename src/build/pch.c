@@ -0,0 +1,517 @@
+#include "build_internal.h"
+#include "depcheck_internal.h"
+#include "bake/os.h"
+
+/* A precompiled header only pays off when it is shared by several units. */
+#define BAKE_PCH_MIN_UNITS (2)
+
+bool bake_compile_unit_uses_pch(const bake_compile_unit_t *unit) {
+    /* Shared dependency objects must not depend on the application, and
+     * Objective-C can't use a C or C++ precompiled header. */
+    if (unit->shared_src) {
+        return false;
+    }
+    return !bake_has_suffix(unit->src, ".m") && !bake_has_suffix(unit->src, ".mm");
+}
+
+static const char* bake_pch_skip_ws_and_comments(const char *ptr) {
+    for (;;) {
+        ptr += strspn(ptr, " \t\n\r\f\v");
+        if (ptr[0] == '/' && ptr[1] == '/') {
+            ptr += strcspn(ptr, "\n");
+        } else if (ptr[0] == '/' && ptr[1] == '*') {
+            const char *end = strstr(ptr + 2, "*/");
+            ptr = end ? end + 2 : ptr + strlen(ptr);
+        } else {
+            return ptr;
+        }
+    }
+}
+
+/* Clang can only use a precompiled header by including it ahead of the
+ * source, which changes the meaning of sources that define macros or include
+ * something else first. Such sources parse the header themselves, like they
+ * would with GCC. */
+bool bake_pch_unit_includes_first(const bake_pch_t *pch, const bake_compile_unit_t *unit) {
+    char *content = bake_file_read(unit->src, NULL);
+    if (!content) {
+        return false;
+    }
+
+    bool result = false;
+    const char *ptr = bake_pch_skip_ws_and_comments(content);
+    if (*ptr != '#') {
+        goto cleanup;
+    }
+    ptr += 1 + strspn(ptr + 1, " \t");
+    if (strncmp(ptr, "include", 7)) {
+        goto cleanup;
+    }
+    ptr += 7 + strspn(ptr + 7, " \t");
+    char close = *ptr == '<' ? '>' : *ptr == '"' ? '"' : '\0';
+    const char *end = close ? strchr(ptr + 1, close) : NULL;
+    if (!end) {
+        goto cleanup;
+    }
+
+    /* The include may name the header relative to any include directory. */
+    char *header = bake_path_stem(pch->file);
+    size_t header_len = strlen(header);
+    size_t len = (size_t)(end - ptr - 1);
+    result = len >= header_len &&
+        !strncmp(end - header_len, header, header_len) &&
+        (len == header_len || end[-(ptrdiff_t)header_len - 1] == '/');
+    ecs_os_free(header);
+
+cleanup:
+    ecs_os_free(content);
+    return result;
+}
+
+void bake_pch_fini(bake_pch_t pch[2]) {
+    for (int i = 0; i < 2; i++) {
+        ecs_os_free(pch[i].dir);
+        ecs_os_free(pch[i].file);
+        pch[i].dir = NULL;
+        pch[i].file = NULL;
+        bake_strlist_fini(&pch[i].shared_dirs);
+        pch[i].shared_mtime = 0;
+    }
+}
+
+static char* bake_pch_find_header(
+    const bake_project_cfg_t *cfg,
+    const bake_lang_cfg_t *lang)
+{
+    if (lang->precompile_header_file) {
+        char *header = bake_path_is_abs(lang->precompile_header_file) ?
+            ecs_os_strdup(lang->precompile_header_file) :
+            bake_path_join(cfg->path, lang->precompile_header_file);
+        if (!bake_path_exists(header)) {
+            ecs_err("cannot find precompiled header '%s'", header);
+            ecs_os_free(header);
+            return NULL;
+        }
+        return header;
+    }
+
+    char *ids[2] = { ecs_os_strdup(cfg->id), bake_project_id_base(cfg->id) };
+    char *header = NULL;
+    for (int i = 0; i < 2 && !header; i++) {
+        char *macro = bake_project_id_as_macro(ids[i]);
+        char *name = flecs_asprintf("%s.h", macro);
+        char *path = bake_path_join3(cfg->path, "include", name);
+        if (bake_path_exists(path)) {
+            header = path;
+        } else {
+            ecs_os_free(path);
+        }
+        ecs_os_free(macro);
+        ecs_os_free(name);
+    }
+
+    ecs_os_free(ids[0]);
+    ecs_os_free(ids[1]);
+    return header;
+}
+
+/* The precompiled header is built from a stub next to it that includes the
+ * real header. A unit that includes the header finds the stub directory
+ * first, and GCC uses the precompiled form when it is valid for the unit.
+ * Otherwise GCC falls back to the stub and parses the header normally. */
+static int bake_pch_add_unit(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_lang_cfg_t *lang,
+    bool cpp,
+    bake_compile_list_t *pch_units,
+    bake_pch_t *pch)
+{
+    int rc = -1;
+    char *header = bake_pch_find_header(cfg, lang);
+    if (!header) {
+        return lang->precompile_header_file ? -1 : 0;
+    }
+
+    char *name = bake_path_basename(header);
+    char *dir = bake_path_join3(paths->gen_dir, "pch", cpp ? "cpp" : "c");
+    char *stub = bake_path_join(dir, name);
+    char *content = flecs_asprintf("#include \"%s\"\n", header);
+    for (char *p = content; *p; p++) {
+        if (*p == '\\') {
+            *p = '/';
+        }
+    }
+    const char *ext = ctx->compiler_kind == BAKE_COMPILER_CLANG ? "pch" : "gch";
+    char *file = flecs_asprintf("%s.%s", stub, ext);
+    char *dep = flecs_asprintf("%s.d", file);
+
+    if (bake_file_write(stub, content) != 0) {
+        goto cleanup;
+    }
+    if (bake_compile_list_append(pch_units, stub, file, dep, cpp) != 0) {
+        goto cleanup;
+    }
+
+    pch->dir = dir;
+    pch->file = file;
+    dir = NULL;
+    file = NULL;
+    rc = 0;
+
+cleanup:
+    ecs_os_free(header);
+    ecs_os_free(name);
+    ecs_os_free(dir);
+    ecs_os_free(stub);
+    ecs_os_free(content);
+    ecs_os_free(file);
+    ecs_os_free(dep);
+    return rc;
+}
+
+/* Packages publish their main header for dependents in
+ * $BAKE_HOME/pch/<id>/<c|cpp>, a directory that dependents search before the
+ * include directories of the package. It holds a stub at the include path of
+ * the header that includes the real header with #include_next, and next to
+ * the stub a .gch directory with precompiled variants, named after a key of
+ * the compiler and flags. As with the header of the project itself, GCC only
+ * uses a variant for units that start with an include of the header and
+ * parses the stub in all other cases. The variants are compiled from a source
+ * outside of the directory, which includes the header by name. */
+static char* bake_pch_shared_root(const bake_context_t *ctx, const char *id) {
+    return bake_path_join3(ctx->bake_home, "pch", id);
+}
+
+static char* bake_pch_shared_dir(
+    const bake_context_t *ctx,
+    const char *id,
+    bool cpp)
+{
+    char *root = bake_pch_shared_root(ctx, id);
+    char *dir = bake_path_join(root, cpp ? "cpp" : "c");
+    ecs_os_free(root);
+    return dir;
+}
+
+/* The flags of the package are part of the key, as a variant compiled with
+ * other flags is not outdated according to its depfile. */
+static uint64_t bake_pch_shared_key(
+    const bake_context_t *ctx,
+    const bake_lang_cfg_t *lang,
+    const bake_strlist_t *mode_flags,
+    bool cpp)
+{
+    const char *compiler = cpp
+        ? (ctx->opts.cxx ? ctx->opts.cxx : "c++")
+        : (ctx->opts.cc ? ctx->opts.cc : "cc");
+    const char *std = cpp ? lang->cpp_standard : lang->c_standard;
+
+    uint64_t key = bake_hash(BAKE_HASH_INIT, compiler, strlen(compiler) + 1);
+    const bake_strlist_t *lists[] = {
+        mode_flags, &lang->cflags, cpp ? &lang->cxxflags : NULL, &lang->defines
+    };
+    for (size_t l = 0; l < sizeof(lists) / sizeof(lists[0]); l++) {
+        for (int32_t i = 0; lists[l] && i < lists[l]->count; i++) {
+            const char *flag = lists[l]->items[i];
+            key = bake_hash(key, flag, strlen(flag) + 1);
+        }
+        key = bake_hash(key, "", 1);
+    }
+    if (std) {
+        key = bake_hash(key, std, strlen(std));
+    }
+    return key;
+}
+
+static char* bake_pch_shared_variant(const char *stub, uint64_t key) {
+    return flecs_asprintf("%s.gch/%016llx", stub, (unsigned long long)key);
+}
+
+/* Removes the variants built from an older version of the header, which GCC
+ * would otherwise still accept. Depfiles are kept out of the .gch directory,
+ * as GCC tries every file in it. */
+static void bake_pch_remove_stale_variants(
+    const char *stub,
+    const char *build_base,
+    uint64_t key)
+{
+    char *gch_dir = flecs_asprintf("%s.gch", stub);
+    char *name = flecs_asprintf("%016llx", (unsigned long long)key);
+    bake_dir_entry_t *entries = NULL;
+    int32_t count = 0;
+    if (bake_dir_list(gch_dir, &entries, &count) == 0) {
+        for (int32_t i = 0; i < count; i++) {
+            if (entries[i].is_dir || !strcmp(entries[i].name, name)) {
+                continue;
+            }
+            char *dep = flecs_asprintf("%s.%s.d", build_base, entries[i].name);
+            bake_remove_file_if_exists(entries[i].path);
+            bake_remove_file_if_exists(dep);
+            ecs_os_free(dep);
+        }
+        bake_dir_entries_free(entries, count);
+    }
+    ecs_os_free(gch_dir);
+    ecs_os_free(name);
+}
+
+int bake_publish_shared_pch(
+    bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_lang_cfg_t *lang,
+    const bake_lang_cfg_t *cpp_lang,
+    const bake_strlist_t *mode_cflags,
+    const bake_strlist_t *mode_cxxflags)
+{
+    bool cpp = bake_language_is_cpp(cfg);
+    const bake_lang_cfg_t *pch_lang = cpp ? cpp_lang : lang;
+    if (ctx->compiler_kind != BAKE_COMPILER_GCC ||
+        cfg->kind != BAKE_PROJECT_PACKAGE || !cfg->public_project ||
+        !pch_lang->precompile_header)
+    {
+        return 0;
+    }
+
+    char *header = bake_pch_find_header(cfg, pch_lang);
+    if (!header) {
+        return 0;
+    }
+
+    /* Only headers that are synced to BAKE_HOME can be published. */
+    char *include = bake_path_join(cfg->path, "include");
+    size_t prefix_len = 0;
+    if (!bake_path_has_prefix_normalized(header, include, &prefix_len)) {
+        ecs_os_free(include);
+        ecs_os_free(header);
+        return 0;
+    }
+
+    int rc = -1;
+    const char *rel = header + prefix_len;
+    while (bake_path_is_sep(rel[0])) {
+        rel++;
+    }
+
+    const char *lang_name = cpp ? "cpp" : "c";
+    char *synced_dir = bake_path_join3(ctx->bake_home, "include", cfg->id);
+    char *synced = bake_path_join(synced_dir, rel);
+    char *root = bake_pch_shared_root(ctx, cfg->id);
+    char *shared_dir = bake_pch_shared_dir(ctx, cfg->id, cpp);
+    char *stub = bake_path_join(shared_dir, rel);
+    char *src = flecs_asprintf("%s/%s.h", root, lang_name);
+    char *build_base = bake_path_join(root, lang_name);
+    const bake_strlist_t *mode_flags = cpp ? mode_cxxflags : mode_cflags;
+    uint64_t key = bake_pch_shared_key(ctx, pch_lang, mode_flags, cpp);
+    char *variant = bake_pch_shared_variant(stub, key);
+    char *tmp = flecs_asprintf("%s.%016llx.tmp", build_base, (unsigned long long)key);
+    char *dep = flecs_asprintf("%s.%016llx.d", build_base, (unsigned long long)key);
+    char *src_content = NULL;
+    char *stub_content = NULL;
+    bake_lang_cfg_t shared_lang = {0};
+
+    if (!bake_path_exists(synced)) {
+        rc = 0;
+        goto cleanup;
+    }
+
+    int64_t mtime = bake_os_file_mtime(variant);
+    if (mtime >= 0 && bake_path_exists(stub) && bake_path_exists(src) &&
+        !bake_depfile_outdated(dep, mtime))
+    {
+        rc = 0;
+        goto cleanup;
+    }
+
+    /* Include the header by name, so that dependents resolve it to the same
+     * file as their own includes of it. */
+    src_content = flecs_asprintf("#include <%s>\n", rel);
+    stub_content = flecs_asprintf("#include_next <%s>\n", rel);
+    for (char *p = src_content; *p; p++) {
+        if (*p == '\\') {
+            *p = '/';
+        }
+    }
+    for (char *p = stub_content; *p; p++) {
+        if (*p == '\\') {
+            *p = '/';
+        }
+    }
+
+    /* Units don't list headers read from a precompiled header in their
+     * depfiles, so dependents compare against the mtime of the source of the
+     * variants. It is replaced before the variant is compiled, so that the
+     * variant is not older than the source in its own depfile. */
+    char *gch_dir = bake_path_dirname(variant);
+    int mkdir_rc = bake_os_mkdirs(gch_dir);
+    ecs_os_free(gch_dir);
+    if (mkdir_rc != 0 || bake_file_write(stub, stub_content) != 0 ||
+        bake_remove_file_if_exists(src) != 0 ||
+        bake_file_write(src, src_content) != 0)
+    {
+        goto cleanup;
+    }
+
+    /* The header finds its own includes through the synced copy. */
+    bake_lang_cfg_copy(&shared_lang, pch_lang);
+    bake_strlist_append_unique(&shared_lang.include_paths, synced_dir);
+
+    bake_compile_unit_t unit = {
+        .src = src,
+        .obj = tmp,
+        .dep = dep,
+        .cpp = cpp
+    };
+    if (bake_compile_unit_shared(
+        ctx, project_entity, cfg, &unit, &shared_lang, mode_flags) != 0)
+    {
+        /* Dependents parse the header themselves, as they would without it. */
+        ecs_warn("failed to publish precompiled header for %s", cfg->id);
+        bake_remove_file_if_exists(tmp);
+        rc = 0;
+        goto cleanup;
+    }
+
+    if (rename(tmp, variant) != 0) {
+        bake_log_errno_last("rename file", tmp);
+        bake_remove_file_if_exists(tmp);
+        goto cleanup;
+    }
+
+    bake_pch_remove_stale_variants(stub, build_base, key);
+
+    rc = 0;
+cleanup:
+    bake_lang_cfg_fini(&shared_lang);
+    ecs_os_free(header);
+    ecs_os_free(include);
+    ecs_os_free(synced_dir);
+    ecs_os_free(synced);
+    ecs_os_free(root);
+    ecs_os_free(shared_dir);
+    ecs_os_free(stub);
+    ecs_os_free(src);
+    ecs_os_free(build_base);
+    ecs_os_free(variant);
+    ecs_os_free(tmp);
+    ecs_os_free(dep);
+    ecs_os_free(src_content);
+    ecs_os_free(stub_content);
+    return rc;
+}
+
+/* Collects the directories of headers published by dependencies. They are
+ * searched whether or not a variant matches the flags of the project, since
+ * the stubs include the real headers. */
+static void bake_pch_find_shared(
+    const bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    bool cpp,
+    bake_pch_t *pch)
+{
+    const BakeResolvedDeps *resolved =
+        ecs_get(ctx->world, project_entity, BakeResolvedDeps);
+    if (!resolved) {
+        return;
+    }
+
+    for (int32_t i = 0; i < resolved->dep_count; i++) {
+        const BakeProject *dep = ecs_get(ctx->world, resolved->deps[i], BakeProject);
+        if (!dep || !dep->cfg || !dep->cfg->id) {
+            continue;
+        }
+
+        char *dir = bake_pch_shared_dir(ctx, dep->cfg->id, cpp);
+        char *src = flecs_asprintf("%s.h", dir);
+        int64_t mtime = bake_os_file_mtime(src);
+        if (mtime >= 0 && bake_path_is_dir(dir)) {
+            if (mtime > pch->shared_mtime) {
+                pch->shared_mtime = mtime;
+            }
+            bake_strlist_append(&pch->shared_dirs, dir);
+        }
+        ecs_os_free(dir);
+        ecs_os_free(src);
+    }
+}
+
+int bake_precompile_headers(
+    bake_context_t *ctx,
+    ecs_entity_t project_entity,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_compile_list_t *units,
+    const bake_lang_cfg_t *lang,
+    const bake_lang_cfg_t *cpp_lang,
+    const bake_strlist_t *mode_cflags,
+    const bake_strlist_t *mode_cxxflags,
+    bool use_shared,
+    bool force_rebuild,
+    bake_pch_t pch[2])
+{
+    /* Depfiles leave out headers read from a precompiled header, which the
+     * include report needs. */
+    if (ctx->opts.include_report ||
+        (ctx->compiler_kind != BAKE_COMPILER_GCC &&
+         ctx->compiler_kind != BAKE_COMPILER_CLANG))
+    {
+        return 0;
+    }
+
+    int32_t counts[2] = {0, 0};
+    for (int32_t i = 0; i < units->count; i++) {
+        if (bake_compile_unit_uses_pch(&units->items[i])) {
+            counts[units->items[i].cpp ? 1 : 0]++;
+        }
+    }
+
+    int rc = -1;
+    bake_compile_list_t pch_units;
+    bake_compile_list_init(&pch_units);
+
+    const bake_lang_cfg_t *langs[2] = { lang, cpp_lang };
+    for (int i = 0; i < 2; i++) {
+        if (!langs[i]->precompile_header || !counts[i]) {
+            continue;
+        }
+
+        /* Units that start with an include of a dependency header use its
+         * published variant, others the header of the project. */
+        if (use_shared && ctx->compiler_kind == BAKE_COMPILER_GCC) {
+            bake_pch_find_shared(ctx, project_entity, i == 1, &pch[i]);
+        }
+
+        if (counts[i] < BAKE_PCH_MIN_UNITS) {
+            continue;
+        }
+        if (bake_pch_add_unit(
+            ctx, cfg, paths, langs[i], i == 1, &pch_units, &pch[i]) != 0)
+        {
+            goto cleanup;
+        }
+    }
+
+    if (pch_units.count && bake_compile_units_parallel(
+        ctx, project_entity, cfg, paths, &pch_units, lang, cpp_lang,
+        mode_cflags, mode_cxxflags, NULL, NULL, force_rebuild, NULL) != 0)
+    {
+        /* Units still build without the precompiled header, just slower. */
+        ecs_warn("precompiled header failed for %s, building without it", cfg->id);
+        for (int i = 0; i < 2; i++) {
+            if (pch[i].file) {
+                bake_remove_file_if_exists(pch[i].file);
+                ecs_os_free(pch[i].dir);
+                ecs_os_free(pch[i].file);
+                pch[i].dir = NULL;
+                pch[i].file = NULL;
+            }
+        }
+    }
+
+    rc = 0;
+cleanup:
+    bake_compile_list_fini(&pch_units);
+    return rc;
+}
@@ -52,6 +52,7 @@ void bake_compile_list_fini(bake_compile_list_t *list) {
         ecs_os_free(list->items[i].src);
         ecs_os_free(list->items[i].obj);
         ecs_os_free(list->items[i].dep);
+        ecs_os_free(list->items[i].shared_src);
     }
     ecs_os_free(list->items);
     list->items = NULL;
@@ -76,7 +77,10 @@ int bake_compile_list_append(
     unit->src = ecs_os_strdup(src);
     unit->obj = ecs_os_strdup(obj);
     unit->dep = dep ? ecs_os_strdup(dep) : NULL;
+    unit->shared_src = NULL;
     unit->cpp = cpp;
+    unit->compiled = false;
+    unit->usage = (bake_process_usage_t){0};
     list->count++;
     return 0;
 }
@@ -301,14 +305,16 @@ int bake_execute_rules(
     return 0;
 }
 
+/* Standalone projects include dependency headers from their deps directory,
+ * relative to the generated header. */
 static void bake_append_dep_include(
     ecs_strbuf_t *header,
     const char *dep_id,
-    bool standalone_local_headers)
+    const char *local_prefix)
 {
     char *dep_macro = bake_project_id_as_macro(dep_id);
-    if (standalone_local_headers) {
-        ecs_strbuf_append(header, "#include \"../../deps/%s.h\"\n", dep_macro);
+    if (local_prefix) {
+        ecs_strbuf_append(header, "#include \"%sdeps/%s.h\"\n", local_prefix, dep_macro);
     } else {
         ecs_strbuf_append(header, "#include <%s.h>\n", dep_macro);
     }
@@ -319,7 +325,7 @@ static void bake_append_dep_include(
 static void bake_append_dep_includes(
     ecs_strbuf_t *header,
     const bake_strlist_t *deps,
-    bool standalone_local_headers)
+    const char *local_prefix)
 {
     if (!deps || deps->count == 0) {
         ecs_strbuf_appendstr(header, "/* No dependencies */\n");
@@ -327,8 +333,91 @@ static void bake_append_dep_includes(
     }
 
     for (int32_t i = 0; i < deps->count; i++) {
-        bake_append_dep_include(header, deps->items[i], standalone_local_headers);
+        bake_append_dep_include(header, deps->items[i], local_prefix);
+    }
+}
+
+#define BAKE_FORWARDING_HEADER_MARKER "/* Forwarding header generated by bake"
+
+static bool bake_is_forwarding_header(const char *path) {
+    size_t len = 0;
+    char *content = bake_file_read(path, &len);
+    bool result = content &&
+        !strncmp(content, BAKE_FORWARDING_HEADER_MARKER,
+            strlen(BAKE_FORWARDING_HEADER_MARKER));
+    ecs_os_free(content);
+    return result;
+}
+
+/* In lean mode bake_config.h doesn't include the headers of dependencies, so
+ * that units only parse the headers of dependencies they include themselves.
+ * Each dependency gets a forwarding header in include/<project>/deps, which
+ * finds the dependency header the same way bake_config.h would. Forwarding
+ * headers of removed dependencies are deleted, as are all of them when lean
+ * mode is disabled. */
+static int bake_generate_forwarding_headers(
+    const char *project_dir,
+    const bake_strlist_t *public_deps,
+    const bake_strlist_t *private_deps,
+    bool lean,
+    bool standalone_local_headers)
+{
+    int rc = -1;
+    char *deps_dir = bake_path_join(project_dir, "deps");
+    bake_strlist_t names;
+    bake_strlist_init(&names);
+
+    const bake_strlist_t *lists[2] = { public_deps, private_deps };
+    for (int l = 0; lean && l < 2; l++) {
+        for (int32_t i = 0; i < lists[l]->count; i++) {
+            const char *dep_id = lists[l]->items[i];
+            char *dep_macro = bake_project_id_as_macro(dep_id);
+            char *name = flecs_asprintf("%s.h", dep_macro);
+            char *path = bake_path_join(deps_dir, name);
+
+            ecs_strbuf_t buf = ECS_STRBUF_INIT;
+            ecs_strbuf_append(&buf,
+                BAKE_FORWARDING_HEADER_MARKER " for %s. Do not edit! */\n", dep_id);
+            bake_append_dep_include(&buf, dep_id,
+                standalone_local_headers ? "../../../" : NULL);
+            char *content = ecs_strbuf_get(&buf);
+            int write_rc = bake_file_write(path, content);
+
+            bake_strlist_append_unique(&names, name);
+            ecs_os_free(content);
+            ecs_os_free(path);
+            ecs_os_free(name);
+            ecs_os_free(dep_macro);
+            if (write_rc != 0) {
+                goto cleanup;
+            }
+        }
+    }
+
+    bake_dir_entry_t *entries = NULL;
+    int32_t count = 0;
+    if (bake_path_exists(deps_dir) &&
+        bake_dir_list(deps_dir, &entries, &count) == 0)
+    {
+        for (int32_t i = 0; i < count; i++) {
+            if (entries[i].is_dir || bake_strlist_contains(&names, entries[i].name) ||
+                !bake_is_forwarding_header(entries[i].path))
+            {
+                continue;
+            }
+            if (bake_remove_file(entries[i].path) != 0) {
+                bake_dir_entries_free(entries, count);
+                goto cleanup;
+            }
+        }
+        bake_dir_entries_free(entries, count);
     }
+
+    rc = 0;
+cleanup:
+    bake_strlist_fini(&names);
+    ecs_os_free(deps_dir);
+    return rc;
 }
 
 int bake_generate_config_header(ecs_world_t *world, const bake_project_cfg_t *cfg) {
@@ -340,6 +429,7 @@ int bake_generate_config_header(ecs_world_t *world, const bake_project_cfg_t *cf
     }
 
     char *include_root = NULL;
+    char *dash_id = NULL;
     char *project_dir = NULL;
     char *header_path = NULL;
     char *project_macro = NULL;
@@ -360,11 +450,8 @@ int bake_generate_config_header(ecs_world_t *world, const bake_project_cfg_t *cf
         goto cleanup;
     }
 
-    project_dir = bake_project_id_as_dash(cfg->id);
-    char *tmp = bake_path_join(include_root, project_dir);
-    ecs_os_free(project_dir);
-    project_dir = tmp;
-    tmp = NULL;
+    dash_id = bake_project_id_as_dash(cfg->id);
+    project_dir = bake_path_join(include_root, dash_id);
 
     if (bake_os_mkdirs(project_dir) != 0) {
         goto cleanup;
@@ -426,21 +513,28 @@ int bake_generate_config_header(ecs_world_t *world, const bake_project_cfg_t *cf
     ecs_strbuf_append(&header, "#ifndef %s\n", guard_macro);
     ecs_strbuf_append(&header, "#define %s\n\n", guard_macro);
 
-    ecs_strbuf_appendstr(&header, "/* Headers of public dependencies */\n");
-    bake_append_dep_includes(&header, &public_deps, standalone_local_headers);
+    const char *local_prefix = standalone_local_headers ? "../../" : NULL;
+    if (cfg->lean_config) {
+        ecs_strbuf_append(&header,
+            "/* Headers of dependencies are included from %s/deps */\n",
+            dash_id);
+    } else {
+        ecs_strbuf_appendstr(&header, "/* Headers of public dependencies */\n");
+        bake_append_dep_includes(&header, &public_deps, local_prefix);
+    }
     if (cfg->kind == BAKE_PROJECT_TEST && cfg->has_test_spec) {
         ecs_strbuf_appendstr(&header, "#include <bake_test.h>\n");
     }
     ecs_strbuf_appendstr(&header, "\n");
 
-    if (cfg->use_private.count) {
+    if (cfg->use_private.count && !cfg->lean_config) {
         ecs_strbuf_appendstr(&header, "/* Headers of private dependencies */\n");
         if (cfg->kind == BAKE_PROJECT_PACKAGE) {
             ecs_strbuf_append(&header, "#ifdef %s_EXPORTS\n", project_macro);
-            bake_append_dep_includes(&header, &cfg->use_private, standalone_local_headers);
+            bake_append_dep_includes(&header, &cfg->use_private, local_prefix);
             ecs_strbuf_appendstr(&header, "#endif\n\n");
         } else {
-            bake_append_dep_includes(&header, &cfg->use_private, standalone_local_headers);
+            bake_append_dep_includes(&header, &cfg->use_private, local_prefix);
             ecs_strbuf_appendstr(&header, "\n");
         }
     }
@@ -469,6 +563,12 @@ int bake_generate_config_header(ecs_world_t *world, const bake_project_cfg_t *cf
         goto cleanup;
     }
 
+    if (bake_generate_forwarding_headers(project_dir, &public_deps,
+        &cfg->use_private, cfg->lean_config, standalone_local_headers) != 0)
+    {
+        goto cleanup;
+    }
+
     rc = 0;
 
 cleanup:
@@ -477,6 +577,7 @@ cleanup:
     }
     ecs_os_free(content);
     ecs_os_free(include_root);
+    ecs_os_free(dash_id);
     ecs_os_free(project_dir);
     ecs_os_free(header_path);
     ecs_os_free(project_macro);
@@ -0,0 +1,471 @@
+#include "build_internal.h"
+#include "bake/os.h"
+
+/* A batch may grow to this many times the average batch size before the
+ * recorded assignment is discarded and all batches are balanced again. */
+#define BAKE_UNITY_MAX_SKEW (2)
+
+typedef struct bake_unity_member_t {
+    bake_compile_unit_t *unit;
+    const char *path;   /* interned, with forward slashes */
+    int64_t size;
+    int32_t batch;
+} bake_unity_member_t;
+
+typedef struct bake_unity_ctx_t {
+    const bake_context_t *ctx;
+    const bake_project_cfg_t *cfg;
+    const bake_build_paths_t *paths;
+    bake_strtable_t strings;
+    ecs_map_t members;  /* interned path -> member index + 1 */
+    char *dir;
+} bake_unity_ctx_t;
+
+static int32_t bake_unity_batch_count(
+    const bake_context_t *ctx,
+    const bake_lang_cfg_t *lang)
+{
+    if (ctx->opts.unity < 0) {
+        return 0;
+    }
+    if (ctx->opts.unity > 0) {
+        return ctx->opts.unity;
+    }
+    return lang->unity > 0 ? lang->unity : 0;
+}
+
+static bool bake_unity_excluded(
+    const bake_project_cfg_t *cfg,
+    const bake_lang_cfg_t *lang,
+    const char *src)
+{
+    /* Only called for sources inside the project, see bake_unity_eligible */
+    bool result = false;
+    char *rel = ecs_os_strdup(src + strlen(cfg->path) + 1);
+    for (char *p = rel; *p; p++) {
+        if (*p == '\\') {
+            *p = '/';
+        }
+    }
+
+    for (int32_t i = 0; i < lang->unity_exclude.count; i++) {
+        const char *pattern = lang->unity_exclude.items[i];
+        size_t len = strlen(pattern);
+        while (len && pattern[len - 1] == '/') {
+            len--;
+        }
+        if (len && !strncmp(rel, pattern, len) &&
+            (!rel[len] || rel[len] == '/'))
+        {
+            result = true;
+            break;
+        }
+    }
+
+    ecs_os_free(rel);
+    return result;
+}
+
+/* Only project sources are batched: dependency sources in deps/ are already
+ * amalgamated, and Objective-C can't be included from a C batch. */
+static bool bake_unity_eligible(const bake_project_cfg_t *cfg, const char *src) {
+    if (bake_has_suffix(src, ".m") || bake_has_suffix(src, ".mm")) {
+        return false;
+    }
+
+    const char *dirs[] = { "src", "test" };
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        char *dir = bake_path_join(cfg->path, dirs[i]);
+        size_t len = strlen(dir);
+        bool inside = !strncmp(src, dir, len) &&
+            (src[len] == '/' || src[len] == '\\');
+        ecs_os_free(dir);
+        if (inside) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static char* bake_unity_batch_name(bool cpp, int32_t index) {
+    return cpp ?
+        flecs_asprintf("unity_cpp_%d.cpp", index + 1) :
+        flecs_asprintf("unity_c_%d.c", index + 1);
+}
+
+/* Restore the batch each member was assigned to by the previous build from
+ * the include lines of the existing batch files. */
+static void bake_unity_load_history(
+    bake_unity_ctx_t *ctx,
+    bake_unity_member_t *members,
+    int32_t batch_count,
+    bool cpp)
+{
+    for (int32_t b = 0; b < batch_count; b++) {
+        char *name = bake_unity_batch_name(cpp, b);
+        char *path = bake_path_join(ctx->dir, name);
+        ecs_os_free(name);
+
+        bake_file_map_t map;
+        if (bake_file_map(path, &map) != 0) {
+            ecs_os_free(path);
+            continue;
+        }
+        ecs_os_free(path);
+
+        const char *prefix = "#include \"";
+        size_t prefix_len = strlen(prefix);
+        const char *ptr = map.data;
+        const char *end = ptr + map.len;
+        while (ptr < end) {
+            const char *eol = memchr(ptr, '\n', (size_t)(end - ptr));
+            if (!eol) {
+                eol = end;
+            }
+
+            size_t len = (size_t)(eol - ptr);
+            if (len > prefix_len + 1 && !strncmp(ptr, prefix, prefix_len) &&
+                ptr[len - 1] == '"')
+            {
+                char *file = ecs_os_malloc(len - prefix_len);
+                memcpy(file, ptr + prefix_len, len - prefix_len - 1);
+                file[len - prefix_len - 1] = '\0';
+                const char *key = bake_strtable_intern(&ctx->strings, file);
+                ecs_os_free(file);
+
+                ecs_map_val_t *index = ecs_map_get(
+                    &ctx->members, (ecs_map_key_t)(uintptr_t)key);
+                if (index) {
+                    members[*index - 1].batch = b;
+                }
+            }
+
+            ptr = eol + 1;
+        }
+
+        bake_file_unmap(&map);
+    }
+}
+
+static int bake_unity_member_cmp_size(const void *a, const void *b) {
+    const bake_unity_member_t *const *ma = a;
+    const bake_unity_member_t *const *mb = b;
+    if ((*ma)->size != (*mb)->size) {
+        return (*ma)->size < (*mb)->size ? 1 : -1;
+    }
+    return strcmp((*ma)->path, (*mb)->path);
+}
+
+static int bake_unity_member_cmp_path(const void *a, const void *b) {
+    const bake_unity_member_t *ma = a;
+    const bake_unity_member_t *mb = b;
+    return strcmp(ma->path, mb->path);
+}
+
+/* Largest-first assignment of members without a batch to the smallest batch.
+ * When the recorded assignment has drifted too far out of balance, all
+ * members are assigned again. */
+static void bake_unity_assign(
+    bake_unity_member_t *members,
+    int32_t count,
+    int32_t batch_count)
+{
+    int64_t *sizes = ecs_os_calloc_n(int64_t, batch_count);
+    int32_t *lengths = ecs_os_calloc_n(int32_t, batch_count);
+    bake_unity_member_t **order = ecs_os_malloc_n(bake_unity_member_t*, count);
+    int64_t total = 0;
+
+    for (int32_t i = 0; i < count; i++) {
+        order[i] = &members[i];
+        total += members[i].size;
+    }
+    qsort(order, (size_t)count, sizeof(*order), bake_unity_member_cmp_size);
+
+    for (int pass = 0; pass < 2; pass++) {
+        memset(sizes, 0, sizeof(int64_t) * (size_t)batch_count);
+        memset(lengths, 0, sizeof(int32_t) * (size_t)batch_count);
+        for (int32_t i = 0; i < count; i++) {
+            if (order[i]->batch >= 0) {
+                sizes[order[i]->batch] += order[i]->size;
+                lengths[order[i]->batch]++;
+            }
+        }
+
+        for (int32_t i = 0; i < count; i++) {
+            if (order[i]->batch >= 0) {
+                continue;
+            }
+            int32_t lightest = 0;
+            for (int32_t b = 1; b < batch_count; b++) {
+                if (sizes[b] < sizes[lightest] ||
+                    (sizes[b] == sizes[lightest] && lengths[b] < lengths[lightest]))
+                {
+                    lightest = b;
+                }
+            }
+            order[i]->batch = lightest;
+            sizes[lightest] += order[i]->size;
+            lengths[lightest]++;
+        }
+
+        bool balanced = true;
+        int64_t limit = BAKE_UNITY_MAX_SKEW * (total / batch_count + 1);
+        for (int32_t b = 0; b < batch_count; b++) {
+            if (!lengths[b] || (sizes[b] > limit && lengths[b] > 1)) {
+                balanced = false;
+            }
+        }
+        if (balanced || pass) {
+            break;
+        }
+
+        for (int32_t i = 0; i < count; i++) {
+            order[i]->batch = -1;
+        }
+    }
+
+    ecs_os_free(order);
+    ecs_os_free(lengths);
+    ecs_os_free(sizes);
+}
+
+static int bake_unity_write_batch(
+    bake_unity_ctx_t *ctx,
+    const bake_unity_member_t *members,
+    int32_t count,
+    int32_t batch,
+    bool cpp,
+    bake_compile_list_t *out)
+{
+    int rc = -1;
+    char *name = bake_unity_batch_name(cpp, batch);
+    char *path = bake_path_join(ctx->dir, name);
+    char *obj_dir = bake_path_join(ctx->paths->obj_dir, "unity");
+#if defined(_WIN32)
+    char *obj = flecs_asprintf("%s/%s.obj", obj_dir, name);
+#else
+    char *obj = flecs_asprintf("%s/%s.o", obj_dir, name);
+#endif
+    char *dep = NULL;
+    char *content = NULL;
+
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    ecs_strbuf_appendstr(&buf, "/* Generated by bake, do not edit */\n");
+    int64_t newest = 0;
+    for (int32_t i = 0; i < count; i++) {
+        if (members[i].batch != batch) {
+            continue;
+        }
+        ecs_strbuf_append(&buf, "#include \"%s\"\n", members[i].path);
+        int64_t mtime = bake_os_file_mtime(members[i].unit->src);
+        if (mtime > newest) {
+            newest = mtime;
+        }
+    }
+    content = ecs_strbuf_get(&buf);
+
+    /* Touch the batch when a member changed, so that the batch is recompiled
+     * even by compilers that don't emit a depfile. */
+    bool same = bake_file_equals(path, content, strlen(content));
+    if (same && bake_os_file_mtime(path) < newest) {
+        if (bake_remove_file(path) != 0) {
+            goto cleanup;
+        }
+        same = false;
+    }
+    if (!same && bake_file_write(path, content) != 0) {
+        goto cleanup;
+    }
+
+    if (bake_os_mkdirs(obj_dir) != 0) {
+        goto cleanup;
+    }
+    if (ctx->ctx->compiler_kind != BAKE_COMPILER_MSVC) {
+        dep = flecs_asprintf("%s.d", obj);
+    }
+
+    rc = bake_compile_list_append(out, path, obj, dep, cpp);
+cleanup:
+    ecs_os_free(content);
+    ecs_os_free(name);
+    ecs_os_free(path);
+    ecs_os_free(obj_dir);
+    ecs_os_free(obj);
+    ecs_os_free(dep);
+    return rc;
+}
+
+static int bake_unity_remove_stale(
+    const char *dir,
+    bool cpp,
+    int32_t batch_count)
+{
+    bake_dir_entry_t *entries = NULL;
+    int32_t count = 0;
+    if (!bake_path_is_dir(dir)) {
+        return 0;
+    }
+    if (bake_dir_list(dir, &entries, &count) != 0) {
+        return -1;
+    }
+
+    const char *prefix = cpp ? "unity_cpp_" : "unity_c_";
+    size_t prefix_len = strlen(prefix);
+    int rc = 0;
+    for (int32_t i = 0; i < count && rc == 0; i++) {
+        const char *name = entries[i].name;
+        if (entries[i].is_dir || strncmp(name, prefix, prefix_len)) {
+            continue;
+        }
+        int index = atoi(name + prefix_len);
+        if (index < 1 || index > batch_count) {
+            rc = bake_remove_file(entries[i].path);
+        }
+    }
+
+    bake_dir_entries_free(entries, count);
+    return rc;
+}
+
+static int bake_unity_group_lang(
+    bake_unity_ctx_t *ctx,
+    const bake_lang_cfg_t *lang,
+    bool cpp,
+    bake_compile_list_t *units,
+    bake_compile_list_t *out)
+{
+    int32_t batch_count = bake_unity_batch_count(ctx->ctx, lang);
+    int rc = -1;
+    ecs_vec_t members = {0};
+    ecs_vec_init_t(NULL, &members, bake_unity_member_t, 0);
+
+    if (batch_count > 0) {
+        for (int32_t i = 0; i < units->count; i++) {
+            bake_compile_unit_t *unit = &units->items[i];
+            if (!unit->src || unit->cpp != cpp ||
+                !bake_unity_eligible(ctx->cfg, unit->src) ||
+                bake_unity_excluded(ctx->cfg, lang, unit->src))
+            {
+                continue;
+            }
+
+            char *path = ecs_os_strdup(unit->src);
+            for (char *p = path; *p; p++) {
+                if (*p == '\\') {
+                    *p = '/';
+                }
+            }
+
+            bake_unity_member_t *m = ecs_vec_append_t(
+                NULL, &members, bake_unity_member_t);
+            m->unit = unit;
+            m->path = bake_strtable_intern(&ctx->strings, path);
+            m->size = bake_os_file_size(unit->src);
+            m->batch = -1;
+            ecs_os_free(path);
+        }
+    }
+
+    int32_t count = ecs_vec_count(&members);
+    if (batch_count > count) {
+        batch_count = count;
+    }
+
+    /* A single source gains nothing from being batched. */
+    if (count < 2) {
+        rc = bake_unity_remove_stale(ctx->dir, cpp, 0);
+        goto cleanup;
+    }
+
+    bake_unity_member_t *items = ecs_vec_first_t(&members, bake_unity_member_t);
+    qsort(items, (size_t)count, sizeof(*items), bake_unity_member_cmp_path);
+
+    ecs_map_clear(&ctx->members);
+    for (int32_t i = 0; i < count; i++) {
+        ecs_map_insert(&ctx->members,
+            (ecs_map_key_t)(uintptr_t)items[i].path, (ecs_map_val_t)(i + 1));
+    }
+
+    bake_unity_load_history(ctx, items, batch_count, cpp);
+    bake_unity_assign(items, count, batch_count);
+
+    for (int32_t b = 0; b < batch_count; b++) {
+        if (bake_unity_write_batch(ctx, items, count, b, cpp, out) != 0) {
+            goto cleanup;
+        }
+    }
+
+    /* Batched units are replaced by their batch. */
+    for (int32_t i = 0; i < count; i++) {
+        ecs_os_free(items[i].unit->src);
+        items[i].unit->src = NULL;
+    }
+
+    rc = bake_unity_remove_stale(ctx->dir, cpp, batch_count);
+cleanup:
+    ecs_vec_fini_t(NULL, &members, bake_unity_member_t);
+    return rc;
+}
+
+int bake_unity_group_units(
+    const bake_context_t *ctx,
+    const bake_project_cfg_t *cfg,
+    const bake_build_paths_t *paths,
+    const bake_lang_cfg_t *c_lang,
+    const bake_lang_cfg_t *cpp_lang,
+    bake_compile_list_t *units)
+{
+    bake_unity_ctx_t unity_ctx = {
+        .ctx = ctx,
+        .cfg = cfg,
+        .paths = paths,
+        .dir = bake_path_join(paths->gen_dir, "unity")
+    };
+    ecs_map_init(&unity_ctx.members, NULL);
+
+    int rc = -1;
+    bake_compile_list_t out;
+    bake_compile_list_init(&out);
+
+    if (bake_unity_group_lang(&unity_ctx, c_lang, false, units, &out) != 0 ||
+        bake_unity_group_lang(&unity_ctx, cpp_lang, true, units, &out) != 0)
+    {
+        bake_compile_list_fini(&out);
+        goto cleanup;
+    }
+
+    if (!out.count) {
+        bake_compile_list_fini(&out);
+        rc = 0;
+        goto cleanup;
+    }
+
+    /* Units that were not batched keep their position ahead of the batches. */
+    bake_compile_list_t result;
+    bake_compile_list_init(&result);
+    for (int32_t i = 0; i < units->count; i++) {
+        bake_compile_unit_t *unit = &units->items[i];
+        if (!unit->src) {
+            continue;
+        }
+        bake_compile_list_append(&result, unit->src, unit->obj, unit->dep, unit->cpp);
+        if (unit->shared_src) {
+            result.items[result.count - 1].shared_src = ecs_os_strdup(unit->shared_src);
+        }
+    }
+    for (int32_t i = 0; i < out.count; i++) {
+        bake_compile_unit_t *unit = &out.items[i];
+        bake_compile_list_append(&result, unit->src, unit->obj, unit->dep, unit->cpp);
+    }
+
+    bake_compile_list_fini(&out);
+    bake_compile_list_fini(units);
+    *units = result;
+    rc = 0;
+
+cleanup:
+    ecs_map_fini(&unity_ctx.members);
+    bake_strtable_fini(&unity_ctx.strings);
+    ecs_os_free(unity_ctx.dir);
+    return rc;
+}
@@ -0,0 +1,174 @@
+#include "build_internal.h"
+#include "bake/os.h"
+
+/* Number of units listed by bake_report_usage. */
+#define BAKE_USAGE_REPORT_MAX (10)
+
+/* The usage history of a project has a line per unit with the figures of its
+ * last compile, followed by the source:
+ *   <user_us> <sys_us> <max_rss_kb> <in> <out> <vol_sw> <invol_sw> <src>
+ * Units that are up to date keep the figures of the build that compiled them,
+ * so the history describes the cost of every unit after the first build. */
+static char* bake_usage_history_path(const bake_build_paths_t *paths) {
+    return bake_path_join(paths->build_root, ".bake_usage");
+}
+
+static ecs_map_key_t bake_usage_key(const char *src) {
+    return (ecs_map_key_t)bake_hash(BAKE_HASH_INIT, src, strlen(src));
+}
+
+static void bake_usage_load(
+    const char *path,
+    bake_compile_list_t *units,
+    ecs_map_t *index,
+    bool *recorded)
+{
+    char *content = bake_file_read(path, NULL);
+    if (!content) {
+        return;
+    }
+
+    char *line = content;
+    while (*line) {
+        char *eol = strchr(line, '\n');
+        if (eol) {
+            *eol = '\0';
+        }
+
+        long long v[7];
+        int src_offset = 0;
+        if (sscanf(line, "%lld %lld %lld %lld %lld %lld %lld %n",
+            &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &src_offset) == 7 &&
+            src_offset)
+        {
+            const char *src = line + src_offset;
+            ecs_map_val_t *i = ecs_map_get(index, bake_usage_key(src));
+            bake_compile_unit_t *unit = i ? &units->items[*i - 1] : NULL;
+            if (unit && !unit->compiled && !strcmp(unit->src, src)) {
+                unit->usage = (bake_process_usage_t){
+                    .user_us = v[0],
+                    .sys_us = v[1],
+                    .max_rss_kb = v[2],
+                    .in_blocks = v[3],
+                    .out_blocks = v[4],
+                    .vol_switches = v[5],
+                    .invol_switches = v[6]
+                };
+                recorded[*i - 1] = true;
+            }
+        }
+
+        if (!eol) {
+            break;
+        }
+        line = eol + 1;
+    }
+
+    ecs_os_free(content);
+}
+
+int bake_usage_update(
+    const bake_build_paths_t *paths,
+    bake_compile_list_t *units,
+    bake_process_usage_t *total_out)
+{
+    char *path = bake_usage_history_path(paths);
+    bool *recorded = ecs_os_calloc_n(bool, units->count ? units->count : 1);
+    ecs_map_t index;
+    ecs_map_init(&index, NULL);
+    for (int32_t i = 0; i < units->count; i++) {
+        recorded[i] = units->items[i].compiled;
+        *ecs_map_ensure(&index, bake_usage_key(units->items[i].src)) =
+            (ecs_map_val_t)i + 1;
+    }
+
+    bake_usage_load(path, units, &index, recorded);
+
+    bake_process_usage_t total = {0};
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    for (int32_t i = 0; i < units->count; i++) {
+        if (!recorded[i]) {
+            continue;
+        }
+
+        const bake_process_usage_t *u = &units->items[i].usage;
+        ecs_strbuf_append(&buf, "%lld %lld %lld %lld %lld %lld %lld %s\n",
+            (long long)u->user_us, (long long)u->sys_us,
+            (long long)u->max_rss_kb, (long long)u->in_blocks,
+            (long long)u->out_blocks, (long long)u->vol_switches,
+            (long long)u->invol_switches, units->items[i].src);
+
+        /* Units compile one after another or side by side, so the peak of
+         * the project is the highest peak of a unit, not the sum. */
+        total.user_us += u->user_us;
+        total.sys_us += u->sys_us;
+        if (u->max_rss_kb > total.max_rss_kb) {
+            total.max_rss_kb = u->max_rss_kb;
+        }
+        total.in_blocks += u->in_blocks;
+        total.out_blocks += u->out_blocks;
+        total.vol_switches += u->vol_switches;
+        total.invol_switches += u->invol_switches;
+    }
+
+    char *content = ecs_strbuf_get(&buf);
+    int rc = bake_file_write(path, content ? content : "");
+    ecs_os_free(content);
+    ecs_map_fini(&index);
+    ecs_os_free(recorded);
+    ecs_os_free(path);
+
+    if (total_out) {
+        *total_out = total;
+    }
+    return rc;
+}
+
+static int64_t bake_usage_cpu_us(const bake_process_usage_t *usage) {
+    return usage->user_us + usage->sys_us;
+}
+
+static int bake_usage_cmp_cpu(const void *a, const void *b) {
+    const bake_compile_unit_t *const *ua = a;
+    const bake_compile_unit_t *const *ub = b;
+    int64_t ca = bake_usage_cpu_us(&(*ua)->usage);
+    int64_t cb = bake_usage_cpu_us(&(*ub)->usage);
+    if (ca != cb) {
+        return ca < cb ? 1 : -1;
+    }
+    return strcmp((*ua)->src, (*ub)->src);
+}
+
+void bake_report_usage(
+    const bake_project_cfg_t *cfg,
+    const bake_compile_list_t *units,
+    const bake_process_usage_t *total)
+{
+    const bake_compile_unit_t **sorted = ecs_os_malloc_n(
+        const bake_compile_unit_t*, units->count ? units->count : 1);
+    int32_t count = 0;
+    for (int32_t i = 0; i < units->count; i++) {
+        const bake_process_usage_t *u = &units->items[i].usage;
+        if (bake_usage_cpu_us(u) || u->max_rss_kb) {
+            sorted[count++] = &units->items[i];
+        }
+    }
+    qsort(sorted, (size_t)count, sizeof(sorted[0]), bake_usage_cmp_cpu);
+
+    printf("resource usage of %s (%d units): %.2fs user, %.2fs sys, %.1f MB peak\n",
+        cfg->id, count, (double)total->user_us / 1e6,
+        (double)total->sys_us / 1e6, (double)total->max_rss_kb / 1024.0);
+    for (int32_t i = 0; i < count && i < BAKE_USAGE_REPORT_MAX; i++) {
+        const bake_compile_unit_t *unit = sorted[i];
+        const bake_process_usage_t *u = &unit->usage;
+        char *display = bake_display_path(unit->src, cfg->path);
+        printf("  %8.2fs cpu %8.1f MB rss %6lld in %6lld out %6lld csw  %s%s\n",
+            (double)bake_usage_cpu_us(u) / 1e6, (double)u->max_rss_kb / 1024.0,
+            (long long)u->in_blocks, (long long)u->out_blocks,
+            (long long)(u->vol_switches + u->invol_switches),
+            display, unit->compiled ? "" : " (up to date)");
+        ecs_os_free(display);
+    }
+
+    ecs_os_free(sorted);
+}
@@ -89,6 +89,25 @@ int bake_json_get_bool(const JSON_Object *object, const char *key, bool *out) {
     return 0;
 }
 
+int bake_json_get_int(const JSON_Object *object, const char *key, int32_t *out) {
+    JSON_Value *value = json_object_get_value(object, key);
+    if (!value) {
+        return 1;
+    }
+
+    if (json_value_get_type(value) != JSONNumber) {
+        return -1;
+    }
+
+    double number = json_value_get_number(value);
+    if (number != (double)(int32_t)number) {
+        return -1;
+    }
+
+    *out = (int32_t)number;
+    return 0;
+}
+
 int bake_json_get_bool_alias(
     const JSON_Object *object,
     const char *key,
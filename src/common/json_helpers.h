@@ -14,6 +14,8 @@ int bake_json_get_string(const JSON_Object *object, const char *key, char **out)
 
 int bake_json_get_bool(const JSON_Object *object, const char *key, bool *out);
 
+int bake_json_get_int(const JSON_Object *object, const char *key, int32_t *out);
+
 int bake_json_get_bool_alias(
     const JSON_Object *object,
     const char *key,
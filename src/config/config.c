@@ -121,12 +121,48 @@ bake_project_kind_t bake_project_kind_parse(const char *value) {
     return BAKE_PROJECT_APPLICATION;
 }
 
+const char* bake_archive_kind_str(bake_archive_kind_t kind) {
+    switch (kind) {
+    case BAKE_ARCHIVE_STATIC: return "static";
+    case BAKE_ARCHIVE_THIN: return "thin";
+    case BAKE_ARCHIVE_PRELINK: return "prelink";
+    default: return "static";
+    }
+}
+
+int bake_debug_info_parse(const char *value, bake_debug_info_t *out) {
+    if (!strcmp(value, "full")) {
+        *out = BAKE_DEBUG_INFO_FULL;
+    } else if (!strcmp(value, "split")) {
+        *out = BAKE_DEBUG_INFO_SPLIT;
+    } else if (!strcmp(value, "compressed")) {
+        *out = BAKE_DEBUG_INFO_COMPRESSED;
+    } else if (!strcmp(value, "split-compressed")) {
+        *out = BAKE_DEBUG_INFO_SPLIT | BAKE_DEBUG_INFO_COMPRESSED;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
 bool bake_project_kind_has_artefact(bake_project_kind_t kind) {
     return kind == BAKE_PROJECT_PACKAGE ||
         kind == BAKE_PROJECT_APPLICATION ||
         kind == BAKE_PROJECT_TEST;
 }
 
+/* Shared libraries are not built on Windows, where they'd need import
+ * libraries and explicitly exported symbols, nor for emscripten. */
+bool bake_project_cfg_shared_library(const bake_project_cfg_t *cfg) {
+#if defined(_WIN32)
+    (void)cfg;
+    return false;
+#else
+    return cfg->kind == BAKE_PROJECT_PACKAGE && cfg->shared_library &&
+        !bake_target_is_emscripten();
+#endif
+}
+
 char* bake_project_cfg_artefact_name(const bake_project_cfg_t *cfg) {
     if (!cfg || !cfg->output_name || !bake_project_kind_has_artefact(cfg->kind)) {
         return NULL;
@@ -147,6 +183,18 @@ char* bake_project_cfg_artefact_name(const bake_project_cfg_t *cfg) {
         exe_ext = target_exe_ext;
     }
 
+#if !defined(_WIN32)
+    if (bake_project_cfg_shared_library(cfg)) {
+#if defined(__APPLE__)
+        lib_ext = ".dylib";
+#else
+        lib_ext = ".so";
+#endif
+    } else if (cfg->archive == BAKE_ARCHIVE_PRELINK) {
+        lib_ext = ".o";
+    }
+#endif
+
     if (cfg->kind == BAKE_PROJECT_PACKAGE) {
         return flecs_asprintf("%s%s%s", lib_prefix, cfg->output_name, lib_ext);
     }
@@ -273,12 +321,15 @@ static void bake_lang_cfg_init_impl(bake_lang_cfg_t *cfg, bool set_defaults) {
 #define F(n) bake_strlist_init(&cfg->n)
     F(cflags); F(cxxflags); F(defines); F(ldflags); F(libs);
     F(static_libs); F(libpaths); F(links); F(include_paths); F(embed);
+    F(unity_exclude);
 #undef F
     cfg->c_standard = set_defaults ? ecs_os_strdup("c99") : NULL;
     cfg->cpp_standard = set_defaults ? ecs_os_strdup("c++17") : NULL;
+    cfg->precompile_header_file = NULL;
     cfg->static_lib = false;
     cfg->export_symbols = false;
     cfg->precompile_header = set_defaults;
+    cfg->unity = 0;
 }
 
 void bake_lang_cfg_init(bake_lang_cfg_t *cfg) {
@@ -290,13 +341,16 @@ void bake_lang_cfg_copy(bake_lang_cfg_t *dst, const bake_lang_cfg_t *src) {
 
     dst->c_standard = ecs_os_strdup(src->c_standard);
     dst->cpp_standard = ecs_os_strdup(src->cpp_standard);
+    dst->precompile_header_file = ecs_os_strdup(src->precompile_header_file);
     dst->static_lib = src->static_lib;
     dst->export_symbols = src->export_symbols;
     dst->precompile_header = src->precompile_header;
+    dst->unity = src->unity;
 
 #define CP(f) bake_strlist_copy(&dst->f, &src->f)
     CP(cflags); CP(cxxflags); CP(defines); CP(ldflags); CP(libs);
     CP(static_libs); CP(libpaths); CP(links); CP(include_paths); CP(embed);
+    CP(unity_exclude);
 #undef CP
 }
 
@@ -304,11 +358,14 @@ void bake_lang_cfg_fini(bake_lang_cfg_t *cfg) {
 #define F(n) bake_strlist_fini(&cfg->n)
     F(cflags); F(cxxflags); F(defines); F(ldflags); F(libs);
     F(static_libs); F(libpaths); F(links); F(include_paths); F(embed);
+    F(unity_exclude);
 #undef F
     ecs_os_free(cfg->c_standard);
     ecs_os_free(cfg->cpp_standard);
+    ecs_os_free(cfg->precompile_header_file);
     cfg->c_standard = NULL;
     cfg->cpp_standard = NULL;
+    cfg->precompile_header_file = NULL;
 }
 
 void bake_dependee_cfg_init(bake_dependee_cfg_t *cfg) {
@@ -357,7 +414,7 @@ void bake_project_cfg_init(bake_project_cfg_t *cfg) {
 
 static void bake_project_cfg_fini_impl(bake_project_cfg_t *cfg, bool fini_dependee) {
 #define F(n) ecs_os_free(cfg->n)
-    F(id); F(path); F(language); F(output_name);
+    F(id); F(path); F(language); F(output_name); F(linker);
 #undef F
 
 #define F(n) bake_strlist_fini(&cfg->n)
@@ -400,12 +457,39 @@ void bake_project_cfg_fini(bake_project_cfg_t *cfg) {
     X("libpath", "libpaths", libpaths) \
     X("link", "links", links) \
     X("include", NULL, include_paths) \
-    X("embed", NULL, embed)
+    X("embed", NULL, embed) \
+    X("unity-exclude", NULL, unity_exclude)
 
 #define BAKE_LANG_BOOL_KEYS(X) \
     X("static", static_lib) \
-    X("export-symbols", export_symbols) \
-    X("precompile-header", precompile_header)
+    X("export-symbols", export_symbols)
+
+/* "precompile-header" is either a boolean, or the path of the header to
+ * precompile, which also enables it. */
+static int bake_parse_precompile_header(
+    const JSON_Object *object,
+    bake_lang_cfg_t *cfg)
+{
+    JSON_Value *value = json_object_get_value(object, "precompile-header");
+    if (!value) {
+        return 0;
+    }
+
+    if (json_value_get_type(value) == JSONBoolean) {
+        cfg->precompile_header = json_value_get_boolean(value) != 0;
+        return 0;
+    }
+
+    if (json_value_get_type(value) == JSONString) {
+        ecs_os_free(cfg->precompile_header_file);
+        cfg->precompile_header_file = ecs_os_strdup(json_value_get_string(value));
+        cfg->precompile_header = true;
+        return 0;
+    }
+
+    ecs_err("'precompile-header' must be a boolean or a header path");
+    return -1;
+}
 
 static int bake_parse_lang_cfg(const JSON_Object *object, bake_lang_cfg_t *cfg) {
     if (!object) {
@@ -419,12 +503,18 @@ static int bake_parse_lang_cfg(const JSON_Object *object, bake_lang_cfg_t *cfg)
 
     if (bake_json_get_string(object, "c-standard", &cfg->c_standard) < 0) return -1;
     if (bake_json_get_string(object, "cpp-standard", &cfg->cpp_standard) < 0) return -1;
+    if (bake_json_get_int(object, "unity", &cfg->unity) < 0) {
+        ecs_err("'unity' must be an integer");
+        return -1;
+    }
 
 #define B(key, field) \
     if (bake_json_get_bool(object, key, &cfg->field) < 0) return -1;
     BAKE_LANG_BOOL_KEYS(B)
 #undef B
 
+    if (bake_parse_precompile_header(object, cfg) != 0) return -1;
+
     size_t key_count = json_object_get_count(object);
     for (size_t i = 0; i < key_count; i++) {
         const char *key = json_object_get_name(object, i);
@@ -493,6 +583,58 @@ static int bake_parse_amalgamate(
     return -1;
 }
 
+static int bake_parse_archive(
+    const JSON_Object *object,
+    bake_project_cfg_t *cfg)
+{
+    char *value = NULL;
+    int rc = bake_json_get_string(object, "archive", &value);
+    if (rc != 0) {
+        if (rc < 0) {
+            ecs_err("'archive' must be a string");
+        }
+        return rc < 0 ? -1 : 0;
+    }
+
+    rc = 0;
+    if (!strcmp(value, "static")) {
+        cfg->archive = BAKE_ARCHIVE_STATIC;
+    } else if (!strcmp(value, "thin")) {
+        cfg->archive = BAKE_ARCHIVE_THIN;
+    } else if (!strcmp(value, "prelink")) {
+        cfg->archive = BAKE_ARCHIVE_PRELINK;
+    } else {
+        ecs_err("'archive' must be \"static\", \"thin\" or \"prelink\"");
+        rc = -1;
+    }
+
+    ecs_os_free(value);
+    return rc;
+}
+
+static int bake_parse_debug_info(
+    const JSON_Object *object,
+    bake_project_cfg_t *cfg)
+{
+    char *value = NULL;
+    int rc = bake_json_get_string(object, "debug-info", &value);
+    if (rc != 0) {
+        if (rc < 0) {
+            ecs_err("'debug-info' must be a string");
+        }
+        return rc < 0 ? -1 : 0;
+    }
+
+    rc = bake_debug_info_parse(value, &cfg->debug_info);
+    if (rc != 0) {
+        ecs_err("'debug-info' must be \"full\", \"split\", \"compressed\" "
+            "or \"split-compressed\"");
+    }
+
+    ecs_os_free(value);
+    return rc;
+}
+
 static int bake_parse_project_value_cfg(
     const JSON_Object *object,
     bake_project_cfg_t *cfg)
@@ -507,6 +649,16 @@ static int bake_parse_project_value_cfg(
     if (bake_json_get_bool(object, "private", &cfg->private_project) < 0) return -1;
     if (bake_json_get_bool(object, "public", &cfg->public_project) < 0) return -1;
     if (bake_json_get_bool(object, "standalone", &cfg->standalone) < 0) return -1;
+    if (bake_json_get_bool(object, "lean-config", &cfg->lean_config) < 0) return -1;
+    if (bake_json_get_bool(object, "include-root", &cfg->include_root) < 0) return -1;
+    if (bake_parse_archive(object, cfg) < 0) return -1;
+    if (bake_json_get_bool(object, "shared", &cfg->shared_library) < 0) return -1;
+    if (bake_json_get_string(object, "linker", &cfg->linker) < 0) return -1;
+    if (bake_parse_debug_info(object, cfg) < 0) return -1;
+    if (bake_json_get_int(object, "standalone-units", &cfg->standalone_units) < 0) {
+        ecs_err("'standalone-units' must be an integer");
+        return -1;
+    }
     if (bake_parse_amalgamate(object, cfg) < 0) return -1;
 
     if (bake_json_get_array_alias(object, "use", NULL, &cfg->use) < 0) return -1;
@@ -524,6 +676,17 @@ static int bake_parse_project_value_cfg(
     if (bake_json_get_string(object, "c-standard", &cfg->c_lang.c_standard) < 0) return -1;
     if (bake_json_get_string(object, "cpp-standard", &cfg->cpp_lang.cpp_standard) < 0) return -1;
 
+    int32_t unity = 0;
+    int unity_rc = bake_json_get_int(object, "unity", &unity);
+    if (unity_rc < 0) {
+        ecs_err("'unity' must be an integer");
+        return -1;
+    }
+    if (unity_rc == 0) {
+        cfg->c_lang.unity = unity;
+        cfg->cpp_lang.unity = unity;
+    }
+
 #define LBOOL(key, field) { \
     bool _v = false; int _rc = bake_json_get_bool(object, key, &_v); \
     if (_rc < 0) return -1; \
@@ -532,6 +695,12 @@ static int bake_parse_project_value_cfg(
     BAKE_LANG_BOOL_KEYS(LBOOL)
 #undef LBOOL
 
+    if (bake_parse_precompile_header(object, &cfg->c_lang) != 0 ||
+        bake_parse_precompile_header(object, &cfg->cpp_lang) != 0)
+    {
+        return -1;
+    }
+
     return 0;
 }
 
@@ -22,14 +22,22 @@ static const char *bake_help_text =
     "  --cfg <mode>        Build mode: sanitize|debug|profile|release\n"
     "  --cc <compiler>     Override C compiler\n"
     "  --cxx <compiler>    Override C++ compiler\n"
+    "  --linker <name>     Link applications with mold|lld|gold|bfd|fast|default\n"
+    "  --debug-info <kind> Debug info: full|split|compressed|split-compressed\n"
     "  --target <name>     Cross-compile target (em = emscripten/wasm)\n"
     "  --run-prefix <cmd>  Prefix command when running binaries\n"
     "  --local-env[=<name>] Use ./.bake/local_env (or ./.bake/local_env/<name>) as isolated BAKE_HOME and build root\n"
     "  --local             Setup only: install into BAKE_HOME (skip /usr/local/bin)\n"
     "  --standalone        Use amalgamated dependency sources in deps/\n"
     "  --strict            Enable strict compiler warnings and checks\n"
+    "  --unity <count>     Compile sources in <count> unity batches (0 disables)\n"
     "  --trace             Echo compiler and linker commands\n"
+    "  --include-report    Report which sources include headers of each dependency\n"
+    "  --include-root      Search includes in a single directory of symlinks\n"
+    "  --usage-report      Report CPU time and peak memory of the costliest sources\n"
+    "  --replay-warnings   Print stored compiler warnings of up-to-date sources\n"
     "  -j <count>          Number of parallel jobs for build/test execution\n"
+    "  -k, --keep-going    Keep building what doesn't depend on a failure\n"
     "  -r                  Recursive clean/rebuild\n"
     "  -h, --help          Show this help\n";
 
@@ -24,6 +24,16 @@ char* bake_project_id_as_macro(const char *id) {
     return out;
 }
 
+uint64_t bake_hash(uint64_t seed, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 bool bake_char_is_space(char ch) {
     return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
 }
@@ -234,4 +234,10 @@ void bake_context_fini(bake_context_t *ctx) {
 
     ecs_os_free(ctx->bake_home);
     ctx->bake_home = NULL;
+
+    bake_strlist_fini(&ctx->linkers_found);
+    bake_strlist_fini(&ctx->linkers_missing);
+    bake_strlist_fini(&ctx->linkers_warned);
+
+    bake_intern_fini();
 }
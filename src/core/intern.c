@@ -0,0 +1,80 @@
+#include "bake/strlist.h"
+
+typedef struct bake_strtable_slot_t {
+    uint64_t hash;
+    char *value;
+} bake_strtable_slot_t;
+
+static bake_strtable_t bake_interned;
+
+static bake_strtable_slot_t* bake_strtable_find_slot(
+    bake_strtable_slot_t *slots,
+    int32_t capacity,
+    uint64_t hash,
+    const char *value)
+{
+    uint64_t mask = (uint64_t)capacity - 1;
+    for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+        bake_strtable_slot_t *slot = &slots[i];
+        if (!slot->value) {
+            return slot;
+        }
+        if (slot->hash == hash && !strcmp(slot->value, value)) {
+            return slot;
+        }
+    }
+}
+
+static void bake_strtable_grow(bake_strtable_t *table) {
+    int32_t capacity = table->capacity ? table->capacity * 2 : 256;
+    bake_strtable_slot_t *slots = ecs_os_calloc_n(bake_strtable_slot_t, capacity);
+
+    for (int32_t i = 0; i < table->capacity; i++) {
+        bake_strtable_slot_t *old = &table->slots[i];
+        if (old->value) {
+            *bake_strtable_find_slot(slots, capacity, old->hash, old->value) = *old;
+        }
+    }
+
+    ecs_os_free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+}
+
+const char* bake_strtable_intern(bake_strtable_t *table, const char *value) {
+    if (!value) {
+        return NULL;
+    }
+
+    /* Keep the load factor under 1/2 so probe sequences stay short. */
+    if ((table->count + 1) * 2 > table->capacity) {
+        bake_strtable_grow(table);
+    }
+
+    uint64_t hash = bake_hash(BAKE_HASH_INIT, value, strlen(value));
+    bake_strtable_slot_t *slot = bake_strtable_find_slot(
+        table->slots, table->capacity, hash, value);
+    if (!slot->value) {
+        slot->hash = hash;
+        slot->value = ecs_os_strdup(value);
+        table->count++;
+    }
+
+    return slot->value;
+}
+
+void bake_strtable_fini(bake_strtable_t *table) {
+    for (int32_t i = 0; i < table->capacity; i++) {
+        ecs_os_free(table->slots[i].value);
+    }
+    ecs_os_free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+const char* bake_intern(const char *value) {
+    return bake_strtable_intern(&bake_interned, value);
+}
+
+void bake_intern_fini(void) {
+    bake_strtable_fini(&bake_interned);
+}
@@ -13,6 +13,8 @@ ECS_TAG_DECLARE(BakeExternal);
 
 ecs_entity_t BakeDependsOn = 0;
 
+static uint32_t bake_model_revision = 0;
+
 static const char* bake_project_entity_id(const ecs_world_t *world, ecs_entity_t entity) {
     const BakeProject *project = ecs_get(world, entity, BakeProject);
     const char *id = (project && project->cfg && project->cfg->id)
@@ -164,11 +166,35 @@ static void bake_model_append_dep_entity(BakeResolvedDeps *resolved, ecs_entity_
     resolved->deps[resolved->dep_count++] = dep;
 }
 
-static void bake_model_try_append_include_path(
+/* Hashed sets used while collecting, moved into BakeResolvedDeps when done */
+typedef struct bake_resolved_sets_t {
+    bake_strset_t include_paths;
+    bake_strset_t libs;
+    bake_strset_t ldflags;
+    bake_strset_t build_libpaths;
+} bake_resolved_sets_t;
+
+static void bake_model_resolved_sets_init(bake_resolved_sets_t *sets) {
+    bake_strset_init(&sets->include_paths);
+    bake_strset_init(&sets->libs);
+    bake_strset_init(&sets->ldflags);
+    bake_strset_init(&sets->build_libpaths);
+}
+
+static void bake_model_resolved_sets_take(
+    bake_resolved_sets_t *sets,
+    BakeResolvedDeps *resolved)
+{
+    bake_strset_take(&sets->include_paths, &resolved->include_paths);
+    bake_strset_take(&sets->libs, &resolved->libs);
+    bake_strset_take(&sets->ldflags, &resolved->ldflags);
+    bake_strset_take(&sets->build_libpaths, &resolved->build_libpaths);
+}
+
+static char* bake_model_find_include_path(
     const bake_project_cfg_t *cfg,
     const char *bake_home,
-    bool external,
-    BakeResolvedDeps *resolved)
+    bool external)
 {
     char *include = NULL;
     if (external && bake_home && cfg && cfg->id) {
@@ -183,12 +209,12 @@ static void bake_model_try_append_include_path(
         include = bake_path_join(cfg->path, "include");
     }
 
-    if (include && bake_path_exists(include) &&
-        !bake_strlist_contains(&resolved->include_paths, include))
-    {
-        bake_strlist_append(&resolved->include_paths, include);
+    if (include && !bake_path_exists(include)) {
+        ecs_os_free(include);
+        include = NULL;
     }
-    ecs_os_free(include);
+
+    return include;
 }
 
 static bool bake_cfg_is_external_placeholder(const bake_project_cfg_t *cfg) {
@@ -323,7 +349,8 @@ ecs_entity_t bake_model_add_project(ecs_world_t *world, bake_project_cfg_t *cfg,
 
     BakeProject project = {
         .cfg = cfg,
-        .external = external
+        .external = external,
+        .revision = ++bake_model_revision
     };
 
     ecs_set_ptr(world, entity, BakeProject, &project);
@@ -589,116 +616,294 @@ void bake_model_mark_build_targets(ecs_world_t *world, const char *target, const
         bake_model_mark_build_recursive(world, entity, mode, true, standalone);
     }
 }
-static void bake_model_collect_resolved_deps(
-    const ecs_world_t *world,
-    ecs_entity_t project_entity,
-    const char *mode,
-    const char *bake_home,
-    BakeResolvedDeps *resolved,
-    ecs_map_t *visited)
-{
+/* Per-project state for one bake_model_refresh_resolved_deps pass. Projects
+ * are indexed in topological order so each closure is computed from the
+ * already-resolved closures of its direct dependencies. */
+typedef struct bake_resolve_node_t {
+    ecs_entity_t entity;
+    int32_t state;          /* 0: new, 1: on stack, 2: visited */
+    bool resolved;
+    bool dirty;
+    bool has_contrib;
+    char *include_path;     /* Memoized include path contribution */
+    char *build_libpath;    /* Memoized build root contribution */
+    const BakeResolvedDeps *prev;
+    BakeResolvedDeps result;
+} bake_resolve_node_t;
+
+typedef struct bake_resolve_ctx_t {
+    const ecs_world_t *world;
+    const char *mode;
+    const char *bake_home;
+    ecs_vec_t nodes;        /* vec<bake_resolve_node_t> */
+    ecs_vec_t order;        /* vec<int32_t>, post-order */
+    ecs_map_t index;        /* entity -> node index + 1 */
+} bake_resolve_ctx_t;
+
+static bake_resolve_node_t* bake_resolve_node(bake_resolve_ctx_t *rctx, int32_t index) {
+    return ecs_vec_get_t(&rctx->nodes, bake_resolve_node_t, index);
+}
+
+static int32_t bake_resolve_node_index(bake_resolve_ctx_t *rctx, ecs_entity_t entity) {
+    ecs_map_val_t *index = ecs_map_get(&rctx->index, (ecs_map_key_t)entity);
+    if (index) {
+        return (int32_t)*index - 1;
+    }
+
+    int32_t result = ecs_vec_count(&rctx->nodes);
+    bake_resolve_node_t *node = ecs_vec_append_t(NULL, &rctx->nodes, bake_resolve_node_t);
+    memset(node, 0, sizeof(*node));
+    node->entity = entity;
+    ecs_map_insert(&rctx->index, (ecs_map_key_t)entity, (ecs_map_val_t)result + 1);
+    return result;
+}
+
+static void bake_resolve_visit(bake_resolve_ctx_t *rctx, int32_t index) {
+    bake_resolve_node_t *node = bake_resolve_node(rctx, index);
+    if (node->state) {
+        return;
+    }
+
+    node->state = 1;
+    ecs_entity_t entity = node->entity;
     for (int32_t i = 0;; i++) {
-        ecs_entity_t dep = ecs_get_target(world, project_entity, BakeDependsOn, i);
+        ecs_entity_t dep = ecs_get_target(rctx->world, entity, BakeDependsOn, i);
         if (!dep) {
             break;
         }
+        /* Appending may reallocate the node vector, so no node pointer is
+         * held across this call. */
+        bake_resolve_visit(rctx, bake_resolve_node_index(rctx, dep));
+    }
 
-        if (ecs_map_get(visited, (ecs_map_key_t)dep)) {
-            continue;
+    bake_resolve_node(rctx, index)->state = 2;
+    *ecs_vec_append_t(NULL, &rctx->order, int32_t) = index;
+}
+
+static uint64_t bake_resolve_node_key(bake_resolve_ctx_t *rctx, ecs_entity_t entity) {
+    uint64_t key = bake_hash(BAKE_HASH_INIT, rctx->mode, strlen(rctx->mode));
+
+    const BakeProject *project = ecs_get(rctx->world, entity, BakeProject);
+    if (project) {
+        key = bake_hash(key, &project->revision, sizeof(project->revision));
+        key = bake_hash(key, &project->external, sizeof(project->external));
+    }
+
+    for (int32_t i = 0;; i++) {
+        ecs_entity_t dep = ecs_get_target(rctx->world, entity, BakeDependsOn, i);
+        if (!dep) {
+            break;
         }
-        ecs_map_insert(visited, (ecs_map_key_t)dep, 0);
+        key = bake_hash(key, &dep, sizeof(dep));
+    }
 
-        bake_model_append_dep_entity(resolved, dep);
+    return key;
+}
 
-        const BakeProject *dep_project = ecs_get(world, dep, BakeProject);
-        if (dep_project && dep_project->cfg) {
-            const bake_project_cfg_t *cfg = dep_project->cfg;
-            bake_model_try_append_include_path(cfg, bake_home, dep_project->external, resolved);
+static const BakeResolvedDeps* bake_resolve_node_closure(const bake_resolve_node_t *node) {
+    return node->dirty ? &node->result : node->prev;
+}
 
-            if (!dep_project->external && cfg->path) {
-                char *lib = bake_project_build_root(cfg->path, cfg->id, mode);
-                if (lib && bake_path_exists(lib)) {
-                    bake_strlist_append_unique(&resolved->build_libpaths, lib);
-                }
+/* Adds what a project contributes to the closure of its dependees. The path
+ * lookups are done once per pass, however many dependees reach the project. */
+static void bake_resolve_add_contrib(
+    bake_resolve_ctx_t *rctx,
+    bake_resolve_node_t *dep_node,
+    bake_resolved_sets_t *sets)
+{
+    const BakeProject *dep_project = ecs_get(rctx->world, dep_node->entity, BakeProject);
+    if (!dep_project || !dep_project->cfg) {
+        return;
+    }
+
+    const bake_project_cfg_t *cfg = dep_project->cfg;
+    if (!dep_node->has_contrib) {
+        dep_node->include_path = bake_model_find_include_path(
+            cfg, rctx->bake_home, dep_project->external);
+
+        if (!dep_project->external && cfg->path) {
+            char *lib = bake_project_build_root(cfg->path, cfg->id, rctx->mode);
+            if (lib && bake_path_exists(lib)) {
+                dep_node->build_libpath = lib;
+            } else {
                 ecs_os_free(lib);
             }
+        }
+        dep_node->has_contrib = true;
+    }
+
+    if (dep_node->include_path) {
+        bake_strset_add(&sets->include_paths, dep_node->include_path);
+    }
+    if (dep_node->build_libpath) {
+        bake_strset_add(&sets->build_libpaths, dep_node->build_libpath);
+    }
 
-            bake_strlist_merge_unique(&resolved->libs, &cfg->c_lang.libs);
-            bake_strlist_merge_unique(&resolved->libs, &cfg->cpp_lang.libs);
-            bake_strlist_merge_unique(&resolved->ldflags, &cfg->c_lang.ldflags);
-            bake_strlist_merge_unique(&resolved->ldflags, &cfg->cpp_lang.ldflags);
+    bake_strset_merge(&sets->libs, &cfg->c_lang.libs);
+    bake_strset_merge(&sets->libs, &cfg->cpp_lang.libs);
+    bake_strset_merge(&sets->ldflags, &cfg->c_lang.ldflags);
+    bake_strset_merge(&sets->ldflags, &cfg->cpp_lang.ldflags);
 
-            bake_strlist_merge_unique(&resolved->include_paths, &cfg->bundle_includes);
-            bake_strlist_merge_unique(&resolved->build_libpaths, &cfg->bundle_libpaths);
-            bake_strlist_merge_unique(&resolved->libs, &cfg->bundle_libs);
-            bake_strlist_merge_unique(&resolved->ldflags, &cfg->bundle_ldflags);
+    bake_strset_merge(&sets->include_paths, &cfg->bundle_includes);
+    bake_strset_merge(&sets->build_libpaths, &cfg->bundle_libpaths);
+    bake_strset_merge(&sets->libs, &cfg->bundle_libs);
+    bake_strset_merge(&sets->ldflags, &cfg->bundle_ldflags);
 
-            if (cfg->dependee.cfg) {
-                bake_strlist_merge_unique(&resolved->libs, &cfg->dependee.cfg->c_lang.libs);
-                bake_strlist_merge_unique(&resolved->libs, &cfg->dependee.cfg->cpp_lang.libs);
-                bake_strlist_merge_unique(&resolved->ldflags, &cfg->dependee.cfg->c_lang.ldflags);
-                bake_strlist_merge_unique(&resolved->ldflags, &cfg->dependee.cfg->cpp_lang.ldflags);
+    if (cfg->dependee.cfg) {
+        bake_strset_merge(&sets->libs, &cfg->dependee.cfg->c_lang.libs);
+        bake_strset_merge(&sets->libs, &cfg->dependee.cfg->cpp_lang.libs);
+        bake_strset_merge(&sets->ldflags, &cfg->dependee.cfg->c_lang.ldflags);
+        bake_strset_merge(&sets->ldflags, &cfg->dependee.cfg->cpp_lang.ldflags);
+    }
+}
+
+static bool bake_resolve_bit_test_set(uint64_t *bits, int32_t index) {
+    uint64_t mask = 1ULL << (index & 63);
+    bool result = (bits[index >> 6] & mask) != 0;
+    bits[index >> 6] |= mask;
+    return result;
+}
+
+/* Resolves one project from its direct dependencies. This yields the same
+ * order as a depth-first walk: a dependency is followed by its contributions
+ * and then by whatever part of its own closure was not reached yet. */
+static void bake_resolve_compute(
+    bake_resolve_ctx_t *rctx,
+    int32_t index,
+    uint64_t *bits)
+{
+    int32_t node_count = ecs_vec_count(&rctx->nodes);
+    memset(bits, 0, sizeof(uint64_t) * (size_t)((node_count + 63) / 64));
+
+    bake_resolve_node_t *node = bake_resolve_node(rctx, index);
+    BakeResolvedDeps *resolved = &node->result;
+    bake_model_resolved_deps_init(resolved);
+    bake_resolve_bit_test_set(bits, index);
+
+    bake_resolved_sets_t sets;
+    bake_model_resolved_sets_init(&sets);
+
+    for (int32_t i = 0;; i++) {
+        ecs_entity_t dep = ecs_get_target(rctx->world, node->entity, BakeDependsOn, i);
+        if (!dep) {
+            break;
+        }
+
+        int32_t dep_index = bake_resolve_node_index(rctx, dep);
+        if (bake_resolve_bit_test_set(bits, dep_index)) {
+            continue;
+        }
+
+        bake_resolve_node_t *dep_node = bake_resolve_node(rctx, dep_index);
+        bake_model_append_dep_entity(resolved, dep);
+        bake_resolve_add_contrib(rctx, dep_node, &sets);
+
+        /* A dependency without a closure yet is part of a cycle; cycles are
+         * reported by bake_model_build_order. */
+        const BakeResolvedDeps *closure = dep_node->resolved
+            ? bake_resolve_node_closure(dep_node)
+            : NULL;
+        if (!closure) {
+            continue;
+        }
+
+        for (int32_t d = 0; d < closure->dep_count; d++) {
+            int32_t trans_index = bake_resolve_node_index(rctx, closure->deps[d]);
+            if (!bake_resolve_bit_test_set(bits, trans_index)) {
+                bake_model_append_dep_entity(resolved, closure->deps[d]);
             }
         }
 
-        bake_model_collect_resolved_deps(
-            world, dep, mode, bake_home, resolved, visited);
+        bake_strset_merge(&sets.include_paths, &closure->include_paths);
+        bake_strset_merge(&sets.libs, &closure->libs);
+        bake_strset_merge(&sets.ldflags, &closure->ldflags);
+        bake_strset_merge(&sets.build_libpaths, &closure->build_libpaths);
+    }
+
+    const BakeProject *self_project = ecs_get(rctx->world, node->entity, BakeProject);
+    if (self_project && self_project->cfg && !self_project->external) {
+        const bake_project_cfg_t *self_cfg = self_project->cfg;
+        bake_strset_merge(&sets.include_paths, &self_cfg->bundle_includes);
+        bake_strset_merge(&sets.build_libpaths, &self_cfg->bundle_libpaths);
+        bake_strset_merge(&sets.libs, &self_cfg->bundle_libs);
+        bake_strset_merge(&sets.ldflags, &self_cfg->bundle_ldflags);
     }
+
+    bake_model_resolved_sets_take(&sets, resolved);
 }
 
 int bake_model_refresh_resolved_deps(ecs_world_t *world, const char *mode) {
-    const char *resolved_mode = bake_effective_mode(mode);
-    const char *bake_home = bake_env_home();
+    bake_resolve_ctx_t rctx = {
+        .world = world,
+        .mode = bake_effective_mode(mode),
+        .bake_home = bake_env_home()
+    };
+    ecs_vec_init_t(NULL, &rctx.nodes, bake_resolve_node_t, 0);
+    ecs_vec_init_t(NULL, &rctx.order, int32_t, 0);
+    ecs_map_init(&rctx.index, NULL);
 
     /* Collect entities first: adding BakeResolvedDeps moves entities between
      * tables, which is not allowed while iterating. */
-    ecs_vec_t entities;
-    ecs_vec_init_t(NULL, &entities, ecs_entity_t, 0);
     ecs_iter_t it = ecs_each_id(world, ecs_id(BakeProject));
     while (ecs_each_next(&it)) {
         for (int32_t i = 0; i < it.count; i++) {
-            *ecs_vec_append_t(NULL, &entities, ecs_entity_t) = it.entities[i];
+            bake_resolve_node_index(&rctx, it.entities[i]);
         }
     }
 
-    for (int32_t e = 0; e < ecs_vec_count(&entities); e++) {
-        ecs_entity_t entity = *ecs_vec_get_t(&entities, ecs_entity_t, e);
+    for (int32_t i = 0; i < ecs_vec_count(&rctx.nodes); i++) {
+        bake_resolve_visit(&rctx, i);
+    }
 
-        BakeResolvedDeps resolved;
-        bake_model_resolved_deps_init(&resolved);
+    int32_t node_count = ecs_vec_count(&rctx.nodes);
+    uint64_t *bits = ecs_os_malloc_n(uint64_t, (node_count + 63) / 64 + 1);
+    int32_t *order = ecs_vec_first_t(&rctx.order, int32_t);
 
-        ecs_map_t visited = {0};
-        ecs_map_init(&visited, NULL);
-        ecs_map_insert(&visited, (ecs_map_key_t)entity, 0);
+    /* Only projects whose inputs changed, or that depend on one that did, are
+     * recomputed. The world is not modified until all closures are known, so
+     * pointers to unchanged closures stay valid. */
+    for (int32_t o = 0; o < node_count; o++) {
+        bake_resolve_node_t *node = bake_resolve_node(&rctx, order[o]);
+        uint64_t key = bake_resolve_node_key(&rctx, node->entity);
+        node->prev = ecs_get(world, node->entity, BakeResolvedDeps);
+        node->dirty = !node->prev || node->prev->key != key;
 
-        bake_model_collect_resolved_deps(
-            world,
-            entity,
-            resolved_mode,
-            bake_home,
-            &resolved,
-            &visited);
+        for (int32_t i = 0; !node->dirty; i++) {
+            ecs_entity_t dep = ecs_get_target(world, node->entity, BakeDependsOn, i);
+            if (!dep) {
+                break;
+            }
+            node->dirty = bake_resolve_node(&rctx, bake_resolve_node_index(&rctx, dep))->dirty;
+        }
 
-        ecs_map_fini(&visited);
+        if (node->dirty) {
+            bake_resolve_compute(&rctx, order[o], bits);
+            node->result.key = key;
+        }
+        node->resolved = true;
+    }
 
-        const BakeProject *self_project = ecs_get(world, entity, BakeProject);
-        if (self_project && self_project->cfg && !self_project->external) {
-            const bake_project_cfg_t *self_cfg = self_project->cfg;
-            bake_strlist_merge_unique(&resolved.include_paths, &self_cfg->bundle_includes);
-            bake_strlist_merge_unique(&resolved.build_libpaths, &self_cfg->bundle_libpaths);
-            bake_strlist_merge_unique(&resolved.libs, &self_cfg->bundle_libs);
-            bake_strlist_merge_unique(&resolved.ldflags, &self_cfg->bundle_ldflags);
+    ecs_os_free(bits);
+
+    for (int32_t i = 0; i < node_count; i++) {
+        bake_resolve_node_t *node = bake_resolve_node(&rctx, i);
+        ecs_os_free(node->include_path);
+        ecs_os_free(node->build_libpath);
+        if (!node->dirty) {
+            continue;
         }
 
         /* Replace the previous value by hand: ecs_set_ptr without a copy hook
          * would memcpy over the old lists and leak them. */
-        BakeResolvedDeps *dst = ecs_ensure(world, entity, BakeResolvedDeps);
+        BakeResolvedDeps *dst = ecs_ensure(world, node->entity, BakeResolvedDeps);
         bake_model_resolved_deps_fini(dst);
-        *dst = resolved;
-        ecs_modified(world, entity, BakeResolvedDeps);
+        *dst = node->result;
+        ecs_modified(world, node->entity, BakeResolvedDeps);
     }
 
-    ecs_vec_fini_t(NULL, &entities, ecs_entity_t);
+    ecs_map_fini(&rctx.index);
+    ecs_vec_fini_t(NULL, &rctx.order, int32_t);
+    ecs_vec_fini_t(NULL, &rctx.nodes, bake_resolve_node_t);
     return 0;
 }
 
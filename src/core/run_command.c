@@ -1,5 +1,6 @@
 #include "bake/common.h"
 #include "bake/os.h"
+#include "bake/strlist.h"
 #include <flecs.h>
 
 typedef enum bake_cmd_redir_t {
@@ -290,50 +291,129 @@ static int bake_parse_command_line(const char *line, bake_cmd_line_t *cmd) {
     return 0;
 }
 
-int bake_run_command(const char *cmd, bool log_command) {
-    if (!cmd || !cmd[0]) {
-        return -1;
+int bake_strlist_append_args(bake_strlist_t *list, const char *line) {
+    const char *cursor = line;
+    for (;;) {
+        char *token = NULL;
+        bool quoted = false;
+        if (bake_cmd_next_token(&cursor, &token, &quoted) != 0) {
+            return -1;
+        }
+        if (!token) {
+            return 0;
+        }
+        if (token[0]) {
+            bake_strlist_append_owned(list, token);
+        } else {
+            ecs_os_free(token);
+        }
     }
+}
 
-    bake_cmd_line_t parsed;
-    if (bake_parse_command_line(cmd, &parsed) != 0) {
-        ecs_err("invalid command line: %s", cmd);
-        return -1;
+/* Arguments are only quoted when they'd otherwise be split or unescaped. */
+char* bake_argv_str(const char *const *argv) {
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    for (int i = 0; argv[i]; i++) {
+        const char *arg = argv[i];
+        if (i) {
+            ecs_strbuf_appendch(&buf, ' ');
+        }
+        if (!arg[0] || strpbrk(arg, " \t\n\"'\\")) {
+            char *quoted = bake_shell_quote_arg(arg);
+            ecs_strbuf_appendstr(&buf, quoted);
+            ecs_os_free(quoted);
+        } else {
+            ecs_strbuf_appendstr(&buf, arg);
+        }
     }
+    return ecs_strbuf_get(&buf);
+}
 
-    if (log_command) {
-        ecs_trace("$ %s", cmd);
+/* The command is only turned into a string when it fails. */
+static int bake_run_report(
+    const char *const *argv,
+    const char *cmd,
+    int rc,
+    const bake_process_result_t *result)
+{
+    if (rc == 0 && !result->interrupted && !result->term_signal &&
+        !result->exit_code)
+    {
+        return 0;
+    }
+
+    char *str = cmd ? NULL : bake_argv_str(argv);
+    if (!cmd) {
+        cmd = str;
     }
 
-    bake_process_result_t result = {0};
-    int rc = bake_proc_run(
-        (const char *const*)parsed.argv,
-        &parsed.stdio_cfg,
-        &result);
     if (rc != 0) {
         ecs_err("failed to start command: %s", cmd);
-        bake_cmd_line_fini(&parsed);
-        return -1;
+    } else if (result->interrupted) {
+        ecs_err("command interrupted: %s", cmd);
+    } else if (result->term_signal) {
+        ecs_err("command terminated by signal %d: %s", result->term_signal, cmd);
+    } else {
+        ecs_err("command failed with exit code %d: %s", result->exit_code, cmd);
     }
 
-    if (result.interrupted) {
-        ecs_err("command interrupted: %s", cmd);
-        bake_cmd_line_fini(&parsed);
+    ecs_os_free(str);
+    return -1;
+}
+
+int bake_run_check_result(
+    const char *const *argv,
+    int rc,
+    const bake_process_result_t *result)
+{
+    return bake_run_report(argv, NULL, rc, result);
+}
+
+static int bake_run_checked(
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    const char *cmd)
+{
+    bake_process_result_t result = {0};
+    int rc = bake_proc_run(argv, stdio_cfg, &result);
+    return bake_run_report(argv, cmd, rc, &result);
+}
+
+int bake_run_argv(
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    bool log_command)
+{
+    if (!argv || !argv[0]) {
         return -1;
     }
 
-    if (result.term_signal) {
-        ecs_err("command terminated by signal %d: %s", result.term_signal, cmd);
-        bake_cmd_line_fini(&parsed);
+    if (log_command) {
+        char *cmd = bake_argv_str(argv);
+        ecs_trace("$ %s", cmd);
+        ecs_os_free(cmd);
+    }
+
+    return bake_run_checked(argv, stdio_cfg, NULL);
+}
+
+int bake_run_command(const char *cmd, bool log_command) {
+    if (!cmd || !cmd[0]) {
         return -1;
     }
 
-    if (result.exit_code != 0) {
-        ecs_err("command failed with exit code %d: %s", result.exit_code, cmd);
-        bake_cmd_line_fini(&parsed);
+    bake_cmd_line_t parsed;
+    if (bake_parse_command_line(cmd, &parsed) != 0) {
+        ecs_err("invalid command line: %s", cmd);
         return -1;
     }
 
+    if (log_command) {
+        ecs_trace("$ %s", cmd);
+    }
+
+    int rc = bake_run_checked(
+        (const char *const*)parsed.argv, &parsed.stdio_cfg, cmd);
     bake_cmd_line_fini(&parsed);
-    return 0;
+    return rc;
 }
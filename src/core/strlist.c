@@ -45,7 +45,22 @@ int bake_strlist_append_owned(bake_strlist_t *list, char *value) {
     return 0;
 }
 
+/* Below this size a linear scan beats building a hashed index. */
+#define BAKE_STRLIST_LINEAR_MAX (16)
+
 int bake_strlist_merge_unique(bake_strlist_t *dst, const bake_strlist_t *src) {
+    if ((dst->count + src->count) > BAKE_STRLIST_LINEAR_MAX) {
+        bake_strset_t set;
+        bake_strset_init(&set);
+        set.list = *dst;
+        for (int32_t i = 0; i < dst->count; i++) {
+            ecs_map_ensure(&set.index, (ecs_map_key_t)(uintptr_t)bake_intern(dst->items[i]));
+        }
+        int rc = bake_strset_merge(&set, src);
+        bake_strset_take(&set, dst);
+        return rc;
+    }
+
     for (int32_t i = 0; i < src->count; i++) {
         if (!bake_strlist_contains(dst, src->items[i])) {
             if (bake_strlist_append(dst, src->items[i]) != 0) {
@@ -110,3 +125,43 @@ char* bake_strlist_join(const bake_strlist_t *list, const char *separator) {
 
     return out;
 }
+
+void bake_strset_init(bake_strset_t *set) {
+    bake_strlist_init(&set->list);
+    ecs_map_init(&set->index, NULL);
+}
+
+void bake_strset_fini(bake_strset_t *set) {
+    bake_strlist_fini(&set->list);
+    ecs_map_fini(&set->index);
+}
+
+bool bake_strset_contains(const bake_strset_t *set, const char *value) {
+    const char *interned = bake_intern(value);
+    return ecs_map_get(&set->index, (ecs_map_key_t)(uintptr_t)interned) != NULL;
+}
+
+int bake_strset_add(bake_strset_t *set, const char *value) {
+    const char *interned = bake_intern(value);
+    ecs_map_key_t key = (ecs_map_key_t)(uintptr_t)interned;
+    if (ecs_map_get(&set->index, key)) {
+        return 0;
+    }
+    ecs_map_insert(&set->index, key, 0);
+    return bake_strlist_append(&set->list, interned);
+}
+
+int bake_strset_merge(bake_strset_t *set, const bake_strlist_t *src) {
+    for (int32_t i = 0; i < src->count; i++) {
+        if (bake_strset_add(set, src->items[i]) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void bake_strset_take(bake_strset_t *set, bake_strlist_t *dst) {
+    *dst = set->list;
+    bake_strlist_init(&set->list);
+    ecs_map_fini(&set->index);
+}
@@ -67,6 +67,24 @@ static int bake_env_copy_artefact_to_path(const char *src_artefact, const char *
         rc = -1;
     }
 
+    /* The interface of a shared library is only rewritten when it changed, so
+     * that dependents linking against the installed copy don't relink. */
+    char *src_symbols = flecs_asprintf("%s.symbols", src_artefact);
+    char *dst_symbols = flecs_asprintf("%s.symbols", dst_path);
+    char *symbols = rc == 0 ? bake_file_read(src_symbols, NULL) : NULL;
+    if (symbols) {
+        if (!bake_file_equals(dst_symbols, symbols, strlen(symbols)) &&
+            bake_file_write(dst_symbols, symbols) != 0)
+        {
+            rc = -1;
+        }
+    } else if (rc == 0 && bake_remove_file_if_exists(dst_symbols) != 0) {
+        rc = -1;
+    }
+
+    ecs_os_free(symbols);
+    ecs_os_free(src_symbols);
+    ecs_os_free(dst_symbols);
     ecs_os_free(dst_dir);
     return rc;
 }
@@ -126,17 +144,17 @@ static int bake_env_project_entry_complete(
     return 1;
 }
 
-static void bake_env_add_dependency_ids(bake_strlist_t *queue, const bake_strlist_t *deps) {
+static void bake_env_add_dependency_ids(bake_strset_t *queue, const bake_strlist_t *deps) {
     for (int32_t i = 0; i < deps->count; i++) {
         const char *id = deps->items[i];
-        if (!id || !id[0] || bake_strlist_contains(queue, id)) {
+        if (!id || !id[0]) {
             continue;
         }
-        bake_strlist_append(queue, id);
+        bake_strset_add(queue, id);
     }
 }
 
-static void bake_env_queue_project_deps(bake_strlist_t *queue, const bake_project_cfg_t *cfg) {
+static void bake_env_queue_project_deps(bake_strset_t *queue, const bake_project_cfg_t *cfg) {
     const bake_strlist_t *lists[] = {
         &cfg->use, &cfg->use_private, &cfg->use_build, &cfg->use_runtime
     };
@@ -234,10 +252,9 @@ cleanup:
 }
 
 int bake_env_import_dependency_closure(bake_context_t *ctx) {
-    bake_strlist_t queue;
-    bake_strlist_t seen;
-    bake_strlist_init(&queue);
-    bake_strlist_init(&seen);
+    /* The queue doubles as the seen set: each id is appended at most once. */
+    bake_strset_t queue;
+    bake_strset_init(&queue);
 
     int rc = -1;
     int imported = 0;
@@ -253,13 +270,8 @@ int bake_env_import_dependency_closure(bake_context_t *ctx) {
         }
     }
 
-    for (int32_t i = 0; i < queue.count; i++) {
-        const char *id = queue.items[i];
-        if (bake_strlist_contains(&seen, id)) {
-            continue;
-        }
-
-        bake_strlist_append(&seen, id);
+    for (int32_t i = 0; i < queue.list.count; i++) {
+        const char *id = queue.list.items[i];
 
         ecs_entity_t entity = 0;
         const BakeProject *project = bake_model_find_project(ctx->world, id, &entity);
@@ -281,8 +293,7 @@ int bake_env_import_dependency_closure(bake_context_t *ctx) {
 
     rc = imported;
 cleanup:
-    bake_strlist_fini(&queue);
-    bake_strlist_fini(&seen);
+    bake_strset_fini(&queue);
     return rc;
 }
 
@@ -546,7 +557,11 @@ static int bake_env_remove_cfg_artefacts(
     char *path = bake_path_join(base, file_name);
     int rc = -1;
 
-    if (bake_remove_file_if_exists(path) != 0) {
+    char *symbols = flecs_asprintf("%s.symbols", path);
+    bool removed = bake_remove_file_if_exists(path) == 0 &&
+        bake_remove_file_if_exists(symbols) == 0;
+    ecs_os_free(symbols);
+    if (!removed) {
         goto cleanup;
     }
 
@@ -555,7 +570,11 @@ static int bake_env_remove_cfg_artefacts(
         char *scoped_dir = bake_path_join(base, cfg->id);
         char *scoped_path = bake_path_join(scoped_dir, file_name);
 
-        if (bake_remove_file_if_exists(scoped_path) != 0) {
+        char *scoped_symbols = flecs_asprintf("%s.symbols", scoped_path);
+        bool scoped_removed = bake_remove_file_if_exists(scoped_path) == 0 &&
+            bake_remove_file_if_exists(scoped_symbols) == 0;
+        ecs_os_free(scoped_symbols);
+        if (!scoped_removed) {
             ecs_os_free(scoped_path);
             ecs_os_free(scoped_dir);
             goto cleanup;
@@ -600,6 +619,8 @@ static int bake_env_remove_project_artefacts(const bake_context_t *ctx, const ba
         if (!strcmp(platform_dir->name, "meta") ||
             !strcmp(platform_dir->name, "include") ||
             !strcmp(platform_dir->name, "template") ||
+            !strcmp(platform_dir->name, "cache") ||
+            !strcmp(platform_dir->name, "pch") ||
             !strcmp(platform_dir->name, "bin"))
         {
             continue;
@@ -637,6 +658,10 @@ static int bake_env_remove_project_entry(const bake_context_t *ctx, const char *
     char *meta_dir = bake_env_meta_project_dir(ctx, id);
     char *include_dir = bake_path_join3(ctx->bake_home, "include", id);
     char *template_dir = bake_path_join3(ctx->bake_home, "template", id);
+    char *pch_dir = bake_path_join3(ctx->bake_home, "pch", id);
+    char *cache_dir = bake_path_join3(ctx->bake_home, "cache", "amalgamate");
+    char *amalg_dir = bake_path_join(cache_dir, id);
+    ecs_os_free(cache_dir);
 
     bake_project_cfg_t cfg;
     bake_project_cfg_init(&cfg);
@@ -650,7 +675,9 @@ static int bake_env_remove_project_entry(const bake_context_t *ctx, const char *
 
     if (bake_os_rmtree(meta_dir) != 0 ||
         bake_os_rmtree(include_dir) != 0 ||
-        bake_os_rmtree(template_dir) != 0)
+        bake_os_rmtree(template_dir) != 0 ||
+        bake_os_rmtree(pch_dir) != 0 ||
+        bake_os_rmtree(amalg_dir) != 0)
     {
         goto cleanup_cfg;
     }
@@ -666,6 +693,7 @@ static int bake_env_remove_project_entry(const bake_context_t *ctx, const char *
 cleanup_cfg:
     bake_project_cfg_fini(&cfg);
     ecs_os_free(meta_dir); ecs_os_free(include_dir); ecs_os_free(template_dir);
+    ecs_os_free(pch_dir); ecs_os_free(amalg_dir);
     return rc;
 }
 
@@ -92,6 +92,12 @@ int main(int argc, char *argv[]) {
         BFLAG("--standalone", standalone)
         BFLAG("--strict", strict)
         BFLAG("--trace", trace)
+        BFLAG("--include-report", include_report)
+        BFLAG("--include-root", include_root)
+        BFLAG("--usage-report", usage_report)
+        BFLAG("--replay-warnings", replay_warnings)
+        BFLAG("-k", keep_going)
+        BFLAG("--keep-going", keep_going)
         BFLAG("--local", setup_local)
 #undef BFLAG
 
@@ -138,6 +144,21 @@ int main(int argc, char *argv[]) {
             continue;
         }
 
+        if (!strcmp(arg, "--unity")) {
+            if ((i + 1) >= argc) {
+                ecs_err("missing value for --unity");
+                goto cleanup;
+            }
+            char *end = NULL;
+            long batches = strtol(argv[++i], &end, 10);
+            if (batches < 0 || batches > INT32_MAX || !end || *end) {
+                ecs_err("invalid value for --unity: %s", argv[i]);
+                goto cleanup;
+            }
+            opts.unity = batches ? (int32_t)batches : -1;
+            continue;
+        }
+
 #define VARG(name, field) \
         if (!strcmp(arg, name)) { \
             if (i + 1 >= argc) { \
@@ -150,6 +171,8 @@ int main(int argc, char *argv[]) {
         VARG("--cfg", mode)
         VARG("--cc", cc)
         VARG("--cxx", cxx)
+        VARG("--linker", linker)
+        VARG("--debug-info", debug_info)
         VARG("--target", toolchain)
         VARG("--run-prefix", run_prefix)
 #undef VARG
@@ -184,6 +207,29 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (!opts.linker) {
+        const char *env_linker = getenv("BAKE_LINKER");
+        if (env_linker && env_linker[0]) {
+            opts.linker = env_linker;
+        }
+    }
+
+    if (!opts.debug_info) {
+        const char *env_debug_info = getenv("BAKE_DEBUG_INFO");
+        if (env_debug_info && env_debug_info[0]) {
+            opts.debug_info = env_debug_info;
+        }
+    }
+    if (opts.debug_info) {
+        bake_debug_info_t debug_info;
+        if (bake_debug_info_parse(opts.debug_info, &debug_info) != 0) {
+            ecs_err("invalid debug info strategy '%s' "
+                "(expected full|split|compressed|split-compressed)",
+                opts.debug_info);
+            goto cleanup;
+        }
+    }
+
     if (bake_target_name_is_em(opts.toolchain)) {
         if (!opts.cc) opts.cc = "emcc";
         if (!opts.cxx) opts.cxx = "em++";
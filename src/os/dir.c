@@ -17,6 +17,8 @@ void bake_dir_entries_free(bake_dir_entry_t *entries, int32_t count) {
     ecs_os_free(entries);
 }
 
+#if defined(_WIN32)
+/* POSIX walks iteratively over directory fds, see posix/dir.c. */
 #define BAKE_DIR_WALK_MAX_DEPTH 32
 
 typedef struct bake_walk_ctx_t {
@@ -69,6 +71,7 @@ int bake_dir_walk_recursive(const char *root, bake_dir_walk_cb cb, void *ctx) {
     };
     return bake_dir_walk_recurse(root, &walk, 0);
 }
+#endif
 
 static int bake_os_mkdir_component(const char *full_path, const char *component) {
 #if defined(_WIN32)
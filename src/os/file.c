@@ -67,18 +67,17 @@ char* bake_file_read(const char *path, size_t *len_out) {
     return buf;
 }
 
-static bool bake_file_content_matches(const char *path, const char *content, size_t len) {
+bool bake_file_equals(const char *path, const char *content, size_t len) {
     int64_t existing_size = bake_os_file_size(path);
     if (existing_size < 0 || (size_t)existing_size != len) {
         return false;
     }
-    size_t existing_len = 0;
-    char *existing = bake_file_read(path, &existing_len);
-    if (!existing) {
+    bake_file_map_t existing;
+    if (bake_file_map(path, &existing) != 0) {
         return false;
     }
-    bool matches = (existing_len == len && !memcmp(existing, content, len));
-    ecs_os_free(existing);
+    bool matches = (existing.len == len && !memcmp(existing.data, content, len));
+    bake_file_unmap(&existing);
     return matches;
 }
 
@@ -99,7 +98,7 @@ int bake_file_write(const char *path, const char *content) {
     ecs_os_free(dir);
 
     size_t len = strlen(content);
-    if (bake_file_content_matches(path, content, len)) {
+    if (bake_file_equals(path, content, len)) {
         return 0;
     }
 
@@ -139,9 +138,8 @@ char* bake_file_read_trimmed(const char *path) {
 }
 
 int bake_os_file_copy(const char *src, const char *dst) {
-    size_t len = 0;
-    char *content = bake_file_read(src, &len);
-    if (!content) {
+    bake_file_map_t content;
+    if (bake_file_map(src, &content) != 0) {
         if (!bake_path_exists(src)) {
             ecs_err("failed to copy '%s' to '%s': source file does not exist", src, dst);
         }
@@ -150,37 +148,36 @@ int bake_os_file_copy(const char *src, const char *dst) {
 
     char *dir = bake_path_dirname(dst);
     if (!dir || bake_os_mkdirs(dir) != 0) {
-        ecs_os_free(content);
+        bake_file_unmap(&content);
         ecs_os_free(dir);
         return -1;
     }
     ecs_os_free(dir);
 
-    if (bake_file_content_matches(dst, content, len)) {
-        ecs_os_free(content);
+    if (bake_file_equals(dst, content.data, content.len)) {
+        bake_file_unmap(&content);
         return bake_file_sync_mode(src, dst);
     }
 
     FILE *f = fopen(dst, "wb");
     if (!f) {
         bake_log_errno_last("open file for writing", dst);
-        ecs_os_free(content);
+        bake_file_unmap(&content);
         return -1;
     }
 
-    size_t written = fwrite(content, 1, len, f);
-    if (written != len) {
+    size_t written = fwrite(content.data, 1, content.len, f);
+    if (written != content.len) {
         bake_log_errno_last("write file", dst);
         bake_file_close(f, dst);
-        ecs_os_free(content);
+        bake_file_unmap(&content);
         return -1;
     }
 
+    bake_file_unmap(&content);
     if (bake_file_close(f, dst) != 0) {
-        ecs_os_free(content);
         return -1;
     }
 
-    ecs_os_free(content);
     return bake_file_sync_mode(src, dst);
 }
@@ -4,8 +4,47 @@
 #include <flecs.h>
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
+/* Resolve whether a directory entry is a directory. d_type answers this for
+ * free on most filesystems; only symlinks (which must be followed) and
+ * filesystems that report DT_UNKNOWN need a stat, relative to the open
+ * directory so the kernel does not walk the full path again. */
+static int bake_dir_entry_is_dir(
+    DIR *dir,
+    const struct dirent *de,
+    const char *path,
+    bool *is_dir_out)
+{
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(DT_DIR)
+    if (de->d_type == DT_DIR) {
+        *is_dir_out = true;
+        return 0;
+    }
+    if (de->d_type != DT_UNKNOWN && de->d_type != DT_LNK) {
+        *is_dir_out = false;
+        return 0;
+    }
+#endif
+
+    struct stat st;
+    *is_dir_out = false;
+    if (fstatat(dirfd(dir), de->d_name, &st, 0) != 0) {
+        if (errno == ENOENT || errno == ELOOP || errno == EACCES) {
+            /* Broken/unreadable symlink or missing target; keep entry as a non-directory. */
+            errno = 0;
+            return 0;
+        }
+        bake_log_errno_last("stat directory entry", path);
+        return -1;
+    }
+
+    *is_dir_out = S_ISDIR(st.st_mode);
+    return 0;
+}
+
 int bake_dir_list(const char *path, bake_dir_entry_t **entries_out, int32_t *count_out) {
     DIR *dir = opendir(path);
     if (!dir) {
@@ -28,27 +67,11 @@ int bake_dir_list(const char *path, bake_dir_entry_t **entries_out, int32_t *cou
         bake_dir_entry_t *entry = ecs_vec_append_t(NULL, &vec, bake_dir_entry_t);
         entry->name = ecs_os_strdup(de->d_name);
         entry->path = bake_path_join(path, de->d_name);
-        if (!entry->name || !entry->path) {
+        if (bake_dir_entry_is_dir(dir, de, entry->path, &entry->is_dir) != 0) {
             bake_dir_entries_free(ecs_vec_first_t(&vec, bake_dir_entry_t), ecs_vec_count(&vec));
             closedir(dir);
             return -1;
         }
-
-        struct stat st;
-        entry->is_dir = false;
-        if (stat(entry->path, &st) != 0) {
-            if (errno == ENOENT || errno == ELOOP || errno == EACCES) {
-                /* Broken/unreadable symlink or missing target; keep entry as a non-directory. */
-                errno = 0;
-            } else {
-                bake_log_errno_last("stat directory entry", entry->path);
-                bake_dir_entries_free(ecs_vec_first_t(&vec, bake_dir_entry_t), ecs_vec_count(&vec));
-                closedir(dir);
-                return -1;
-            }
-        } else {
-            entry->is_dir = S_ISDIR(st.st_mode);
-        }
     }
 
     if (errno != 0) {
@@ -69,6 +92,221 @@ int bake_dir_list(const char *path, bake_dir_entry_t **entries_out, int32_t *cou
     return 0;
 }
 
+/* Directory walker. Each level is read completely before callbacks run for
+ * it, so callbacks that create files (rules, bundles) never see their own
+ * output. Entry names of all open levels share one LIFO name arena, paths are
+ * built in one reusable buffer and subdirectories are opened relative to
+ * their parent's fd. */
+
+typedef struct bake_walk_item_t {
+    size_t name;            /* Offset in name arena */
+    bool is_dir;
+} bake_walk_item_t;
+
+typedef struct bake_walk_frame_t {
+    DIR *dir;
+    dev_t dev;
+    ino_t ino;
+    size_t path_len;        /* Length of this directory's path in buffer */
+    size_t arena_mark;
+    int32_t first;          /* First item of this level */
+    int32_t cursor;
+} bake_walk_frame_t;
+
+typedef struct bake_walk_t {
+    ecs_vec_t frames;       /* vec<bake_walk_frame_t> */
+    ecs_vec_t items;        /* vec<bake_walk_item_t> */
+    char *arena;
+    size_t arena_len;
+    size_t arena_cap;
+    char *path;
+    size_t path_cap;
+} bake_walk_t;
+
+static void bake_walk_reserve(char **buf, size_t *cap, size_t size) {
+    if (size <= *cap) {
+        return;
+    }
+    size_t next = *cap ? *cap : 256;
+    while (next < size) {
+        next *= 2;
+    }
+    *buf = ecs_os_realloc_n(*buf, char, (int32_t)next);
+    *cap = next;
+}
+
+/* Sets the path buffer to the directory path plus a child name and returns
+ * the length of the result. */
+static size_t bake_walk_path_set(bake_walk_t *walk, size_t dir_len, const char *name) {
+    size_t name_len = strlen(name);
+    bool has_sep = dir_len && walk->path[dir_len - 1] == '/';
+    size_t len = dir_len + (has_sep ? 0 : 1) + name_len;
+    bake_walk_reserve(&walk->path, &walk->path_cap, len + 1);
+    size_t w = dir_len;
+    if (!has_sep) {
+        walk->path[w++] = '/';
+    }
+    memcpy(walk->path + w, name, name_len + 1);
+    return len;
+}
+
+static int bake_walk_push(bake_walk_t *walk, DIR *dir, size_t path_len) {
+    struct stat st;
+    if (fstat(dirfd(dir), &st) != 0) {
+        walk->path[path_len] = '\0';
+        bake_log_errno_last("stat directory", walk->path);
+        closedir(dir);
+        return -1;
+    }
+
+    /* Symlinked directories are followed, so guard against links that point
+     * back to a directory that is already being walked. */
+    int32_t depth = ecs_vec_count(&walk->frames);
+    bake_walk_frame_t *frames = ecs_vec_first_t(&walk->frames, bake_walk_frame_t);
+    for (int32_t i = 0; i < depth; i++) {
+        if (frames[i].dev == st.st_dev && frames[i].ino == st.st_ino) {
+            closedir(dir);
+            return 1;
+        }
+    }
+
+    bake_walk_frame_t *frame = ecs_vec_append_t(NULL, &walk->frames, bake_walk_frame_t);
+    frame->dir = dir;
+    frame->dev = st.st_dev;
+    frame->ino = st.st_ino;
+    frame->path_len = path_len;
+    frame->arena_mark = walk->arena_len;
+    frame->first = ecs_vec_count(&walk->items);
+    frame->cursor = frame->first;
+
+    for (;;) {
+        errno = 0;
+        struct dirent *de = readdir(dir);
+        if (!de) {
+            break;
+        }
+        if (bake_is_dot_dir(de->d_name)) {
+            continue;
+        }
+
+        size_t name_len = strlen(de->d_name);
+        bake_walk_reserve(&walk->arena, &walk->arena_cap, walk->arena_len + name_len + 1);
+        bake_walk_item_t *item = ecs_vec_append_t(NULL, &walk->items, bake_walk_item_t);
+        item->name = walk->arena_len;
+        memcpy(walk->arena + walk->arena_len, de->d_name, name_len + 1);
+        walk->arena_len += name_len + 1;
+
+        bake_walk_path_set(walk, path_len, de->d_name);
+        if (bake_dir_entry_is_dir(dir, de, walk->path, &item->is_dir) != 0) {
+            return -1;
+        }
+    }
+
+    if (errno != 0) {
+        walk->path[path_len] = '\0';
+        bake_log_errno_last("read directory", walk->path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void bake_walk_pop(bake_walk_t *walk) {
+    bake_walk_frame_t *frame = ecs_vec_last_t(&walk->frames, bake_walk_frame_t);
+    closedir(frame->dir);
+    walk->arena_len = frame->arena_mark;
+    ecs_vec_set_count_t(NULL, &walk->items, bake_walk_item_t, frame->first);
+    ecs_vec_remove_last(&walk->frames);
+}
+
+static int bake_walk_open_child(bake_walk_t *walk, DIR *parent, const char *name, DIR **out) {
+    int fd = openat(dirfd(parent), name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        bake_log_errno_last("open directory", walk->path);
+        return -1;
+    }
+
+    *out = fdopendir(fd);
+    if (!*out) {
+        bake_log_errno_last("open directory", walk->path);
+        close(fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+int bake_dir_walk_recursive(const char *root, bake_dir_walk_cb cb, void *ctx) {
+    DIR *root_dir = opendir(root);
+    if (!root_dir) {
+        bake_log_errno_last("open directory", root);
+        return -1;
+    }
+
+    bake_walk_t walk = {0};
+    ecs_vec_init_t(NULL, &walk.frames, bake_walk_frame_t, 0);
+    ecs_vec_init_t(NULL, &walk.items, bake_walk_item_t, 0);
+
+    size_t root_len = strlen(root);
+    bake_walk_reserve(&walk.path, &walk.path_cap, root_len + 1);
+    memcpy(walk.path, root, root_len + 1);
+
+    int rc = bake_walk_push(&walk, root_dir, root_len);
+    if (rc > 0) {
+        rc = 0;
+    }
+
+    while (rc == 0 && ecs_vec_count(&walk.frames)) {
+        bake_walk_frame_t *frame = ecs_vec_last_t(&walk.frames, bake_walk_frame_t);
+        if (frame->cursor == ecs_vec_count(&walk.items)) {
+            bake_walk_pop(&walk);
+            continue;
+        }
+
+        bake_walk_item_t item =
+            *ecs_vec_get_t(&walk.items, bake_walk_item_t, frame->cursor++);
+        const char *name = walk.arena + item.name;
+        size_t path_len = bake_walk_path_set(&walk, frame->path_len, name);
+
+        bake_dir_entry_t entry = {
+            .name = (char*)name,
+            .path = walk.path,
+            .is_dir = item.is_dir
+        };
+
+        int cb_rc = cb(&entry, ctx);
+        if (cb_rc < 0) {
+            rc = -1;
+            break;
+        }
+
+        if (!item.is_dir || cb_rc != 0) {
+            continue;
+        }
+
+        DIR *child = NULL;
+        if (bake_walk_open_child(&walk, frame->dir, name, &child) != 0) {
+            rc = -1;
+            break;
+        }
+
+        int push_rc = bake_walk_push(&walk, child, path_len);
+        if (push_rc < 0) {
+            rc = -1;
+        }
+    }
+
+    while (ecs_vec_count(&walk.frames)) {
+        bake_walk_pop(&walk);
+    }
+
+    ecs_vec_fini_t(NULL, &walk.frames, bake_walk_frame_t);
+    ecs_vec_fini_t(NULL, &walk.items, bake_walk_item_t);
+    ecs_os_free(walk.arena);
+    ecs_os_free(walk.path);
+    return rc;
+}
+
 #endif
 
 #if defined(_WIN32)
@@ -0,0 +1,101 @@
+#if !defined(_WIN32)
+
+#include "bake/os.h"
+#include <flecs.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Below this size a plain read is cheaper than setting up a mapping. */
+#define BAKE_FILE_MAP_MIN_SIZE (16 * 1024)
+
+static int bake_file_map_read(int fd, const char *path, char *buf, size_t len) {
+    size_t offset = 0;
+    while (offset < len) {
+        ssize_t n = read(fd, buf + offset, len - offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            bake_log_errno_last("read file", path);
+            return -1;
+        }
+        if (n == 0) {
+            ecs_err("failed to read file '%s': unexpected end of file", path);
+            return -1;
+        }
+        offset += (size_t)n;
+    }
+    return 0;
+}
+
+int bake_file_map(const char *path, bake_file_map_t *map_out) {
+    memset(map_out, 0, sizeof(*map_out));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            bake_log_errno_last("open file for reading", path);
+        }
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        bake_log_errno_last("stat file", path);
+        close(fd);
+        return -1;
+    }
+
+    size_t len = (size_t)st.st_size;
+    if (!len) {
+        map_out->data = "";
+        close(fd);
+        return 0;
+    }
+
+    if (len < BAKE_FILE_MAP_MIN_SIZE) {
+        char *buf = ecs_os_malloc((ecs_size_t)len);
+        if (bake_file_map_read(fd, path, buf, len) != 0) {
+            ecs_os_free(buf);
+            close(fd);
+            return -1;
+        }
+        close(fd);
+        map_out->data = buf;
+        map_out->len = len;
+        return 0;
+    }
+
+    void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        bake_log_errno_last("map file", path);
+        return -1;
+    }
+
+    /* Every caller scans front to back; let the kernel read ahead. */
+    posix_madvise(data, len, POSIX_MADV_SEQUENTIAL);
+
+    map_out->data = data;
+    map_out->len = len;
+    map_out->mapped = true;
+    return 0;
+}
+
+void bake_file_unmap(bake_file_map_t *map) {
+    if (map->mapped) {
+        munmap((void*)map->data, map->len);
+    } else if (map->len) {
+        ecs_os_free((char*)map->data);
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+#endif
+
+#if defined(_WIN32)
+typedef int bake_file_map_posix_dummy_t;
+#endif
@@ -73,6 +73,44 @@ int bake_file_sync_mode(const char *src, const char *dst) {
     return 0;
 }
 
+/* Links dst to src. An existing dst that is shared with other links is
+ * unlinked rather than overwritten, so writes never reach another copy.
+ * Falls back to a content-checked copy across filesystems. */
+int bake_os_file_link(const char *src, const char *dst) {
+    struct stat src_st, dst_st;
+    if (stat(src, &src_st) != 0) {
+        bake_log_errno_last("stat file", src);
+        return -1;
+    }
+
+    if (stat(dst, &dst_st) == 0) {
+        if (dst_st.st_dev == src_st.st_dev && dst_st.st_ino == src_st.st_ino) {
+            return 0;
+        }
+        if (dst_st.st_dev != src_st.st_dev && dst_st.st_nlink == 1) {
+            return bake_os_file_copy(src, dst);
+        }
+        if (unlink(dst) != 0) {
+            bake_log_errno_last("remove file", dst);
+            return -1;
+        }
+    }
+
+    if (link(src, dst) == 0) {
+        return 0;
+    }
+
+    return bake_os_file_copy(src, dst);
+}
+
+int bake_os_symlink(const char *target, const char *path) {
+    if (symlink(target, path) != 0) {
+        bake_log_errno_last("create symlink", path);
+        return -1;
+    }
+    return 0;
+}
+
 int bake_path_is_dir(const char *path) {
     if (!path || !path[0]) {
         return 0;
@@ -57,6 +57,10 @@ int32_t bake_os_cpu_count(void) {
     return (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
 }
 
+bool bake_os_stderr_is_tty(void) {
+    return isatty(STDERR_FILENO) != 0;
+}
+
 #endif
 
 #if defined(_WIN32)
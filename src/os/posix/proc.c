@@ -1,24 +1,45 @@
 #if !defined(_WIN32)
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* pipe2 */
+#endif
+
 #include "bake/os.h"
 #include <flecs.h>
 
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
 #include <spawn.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#endif
 
 extern char **environ;
 
-/* posix_spawn instead of fork/exec: bake spawns compilers from worker
- * threads, and code between fork and exec in a multithreaded process is
- * limited to async-signal-safe calls. */
-int bake_proc_run(
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+#define BAKE_HAVE_PIPE2
+#endif
+
+/* Exits of processes without a pidfd can't be waited for with the output of
+ * other jobs, so they are checked for at this interval. */
+#define BAKE_PROCS_POLL_MS (10)
+
+/* posix_spawn instead of fork/exec: bake may spawn processes while worker
+ * threads run, and code between fork and exec in a multithreaded process is
+ * limited to async-signal-safe calls. When capture_fd is valid, stdout and
+ * stderr of the process are redirected to it. */
+static int bake_proc_spawn(
     const char *const *argv,
     const bake_process_stdio_t *stdio_cfg,
-    bake_process_result_t *result)
+    int capture_fd,
+    pid_t *pid_out)
 {
     if (!argv || !argv[0]) {
         return -1;
@@ -41,26 +62,37 @@ int bake_proc_run(
                 &fa, STDIN_FILENO, stdio_cfg->stdin_path, O_RDONLY, 0);
         }
 
-        if (!err && stdio_cfg->stdout_path && stdio_cfg->stdout_path[0]) {
+        if (!err && capture_fd < 0 &&
+            stdio_cfg->stdout_path && stdio_cfg->stdout_path[0])
+        {
             int flags = O_WRONLY | O_CREAT |
                 (stdio_cfg->stdout_append ? O_APPEND : O_TRUNC);
             err = posix_spawn_file_actions_addopen(
                 &fa, STDOUT_FILENO, stdio_cfg->stdout_path, flags, 0644);
         }
 
-        if (!err && stdio_cfg->stderr_path && stdio_cfg->stderr_path[0]) {
+        if (!err && capture_fd < 0 &&
+            stdio_cfg->stderr_path && stdio_cfg->stderr_path[0])
+        {
             int flags = O_WRONLY | O_CREAT |
                 (stdio_cfg->stderr_append ? O_APPEND : O_TRUNC);
             err = posix_spawn_file_actions_addopen(
                 &fa, STDERR_FILENO, stdio_cfg->stderr_path, flags, 0644);
         }
 
-        if (!err && stdio_cfg->stderr_to_stdout) {
+        if (!err && capture_fd < 0 && stdio_cfg->stderr_to_stdout) {
             err = posix_spawn_file_actions_adddup2(
                 &fa, STDOUT_FILENO, STDERR_FILENO);
         }
     }
 
+    if (!err && capture_fd >= 0) {
+        err = posix_spawn_file_actions_adddup2(&fa, capture_fd, STDOUT_FILENO);
+        if (!err) {
+            err = posix_spawn_file_actions_adddup2(&fa, capture_fd, STDERR_FILENO);
+        }
+    }
+
     sigset_t sig_default;
     sigemptyset(&sig_default);
     sigaddset(&sig_default, SIGINT);
@@ -71,9 +103,8 @@ int bake_proc_run(
         err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
     }
 
-    pid_t pid = 0;
     if (!err) {
-        err = posix_spawnp(&pid, argv[0], &fa, &attr, (char *const*)argv, environ);
+        err = posix_spawnp(pid_out, argv[0], &fa, &attr, (char *const*)argv, environ);
     }
 
     posix_spawn_file_actions_destroy(&fa);
@@ -84,9 +115,59 @@ int bake_proc_run(
         return -1;
     }
 
+    return 0;
+}
+
+static void bake_proc_set_result(
+    int status,
+    const struct rusage *rusage,
+    bake_process_result_t *result)
+{
+    bake_process_usage_t *usage = &result->usage;
+    usage->user_us = (int64_t)rusage->ru_utime.tv_sec * 1000000 +
+        rusage->ru_utime.tv_usec;
+    usage->sys_us = (int64_t)rusage->ru_stime.tv_sec * 1000000 +
+        rusage->ru_stime.tv_usec;
+#if defined(__APPLE__)
+    usage->max_rss_kb = rusage->ru_maxrss / 1024; /* bytes on macOS */
+#else
+    usage->max_rss_kb = rusage->ru_maxrss;
+#endif
+    usage->in_blocks = rusage->ru_inblock;
+    usage->out_blocks = rusage->ru_oublock;
+    usage->vol_switches = rusage->ru_nvcsw;
+    usage->invol_switches = rusage->ru_nivcsw;
+
+    result->exit_code = 0;
+    result->term_signal = 0;
+    result->interrupted = false;
+
+    if (WIFEXITED(status)) {
+        result->exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result->term_signal = WTERMSIG(status);
+        result->exit_code = 128 + result->term_signal;
+    }
+
+    if (result->term_signal == SIGINT) {
+        result->interrupted = true;
+    }
+}
+
+int bake_proc_run(
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    bake_process_result_t *result)
+{
+    pid_t pid = 0;
+    if (bake_proc_spawn(argv, stdio_cfg, -1, &pid) != 0) {
+        return -1;
+    }
+
     int status = 0;
+    struct rusage rusage;
     for (;;) {
-        pid_t rc = waitpid(pid, &status, 0);
+        pid_t rc = wait4(pid, &status, 0, &rusage);
         if (rc == pid) {
             break;
         }
@@ -100,27 +181,360 @@ int bake_proc_run(
     }
 
     if (result) {
-        result->exit_code = 0;
-        result->term_signal = 0;
-        result->interrupted = false;
+        bake_proc_set_result(status, &rusage, result);
+    }
+
+    return 0;
+}
+
+int bake_proc_run_argv(const char *const *argv, bake_process_result_t *result) {
+    return bake_proc_run(argv, NULL, result);
+}
 
-        if (WIFEXITED(status)) {
-            result->exit_code = WEXITSTATUS(status);
-        } else if (WIFSIGNALED(status)) {
-            result->term_signal = WTERMSIG(status);
-            result->exit_code = 128 + result->term_signal;
+typedef struct bake_proc_buffer_t {
+    char *data;
+    size_t cap;
+} bake_proc_buffer_t;
+
+typedef struct bake_proc_job_t {
+    void *job;
+    pid_t pid;
+    int pidfd;          /* -1 when the kernel has no pidfds */
+    int out_fd;         /* read end of the capture pipe, -1 at EOF */
+    char *output;
+    size_t output_len;
+    size_t output_cap;
+    bake_process_result_t result;
+    bool exited;
+    bool cancelled;
+} bake_proc_job_t;
+
+struct bake_procs_t {
+    bake_proc_job_t **jobs;
+    int32_t count;
+    int32_t capacity;
+    int epoll_fd;       /* -1 without epoll */
+    bake_proc_buffer_t *pool; /* output buffers of released jobs */
+    int32_t pool_count;
+    int32_t pool_capacity;
+};
+
+static void bake_procs_pool_put(bake_procs_t *procs, char *data, size_t cap) {
+    if (!data) {
+        return;
+    }
+    if (procs->pool_count == procs->pool_capacity) {
+        procs->pool_capacity = procs->pool_capacity ? procs->pool_capacity * 2 : 8;
+        procs->pool = ecs_os_realloc_n(
+            procs->pool, bake_proc_buffer_t, procs->pool_capacity);
+    }
+    procs->pool[procs->pool_count].data = data;
+    procs->pool[procs->pool_count].cap = cap;
+    procs->pool_count++;
+}
+
+void bake_procs_release(bake_procs_t *procs, bake_proc_done_t *done) {
+    bake_procs_pool_put(procs, done->output, done->output_cap);
+    done->output = NULL;
+    done->output_len = 0;
+    done->output_cap = 0;
+}
+
+static int bake_proc_pidfd_open(pid_t pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+static int bake_procs_watch(bake_procs_t *procs, int fd, bake_proc_job_t *job) {
+#if defined(__linux__)
+    if (procs->epoll_fd >= 0) {
+        struct epoll_event ev = { .events = EPOLLIN };
+        ev.data.ptr = job;
+        return epoll_ctl(procs->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+#else
+    (void)procs; (void)fd; (void)job;
+#endif
+    return 0;
+}
+
+bake_procs_t* bake_procs_new(void) {
+    bake_procs_t *procs = ecs_os_calloc_t(bake_procs_t);
+    procs->epoll_fd = -1;
+#if defined(__linux__)
+    procs->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+    return procs;
+}
+
+int32_t bake_procs_count(const bake_procs_t *procs) {
+    return procs->count;
+}
+
+/* Creates a capture pipe that is closed on exec. Setting FD_CLOEXEC after
+ * pipe() leaves a window in which a process spawned by another thread
+ * inherits the write end, and keeps the output of the job open. */
+static int bake_procs_pipe(int fds[2]) {
+#if defined(BAKE_HAVE_PIPE2)
+    return pipe2(fds, O_CLOEXEC);
+#else
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+
+int bake_procs_spawn(
+    bake_procs_t *procs,
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    bool capture,
+    void *job)
+{
+    int pipe_fds[2] = { -1, -1 };
+    if (capture) {
+        if (bake_procs_pipe(pipe_fds) != 0) {
+            bake_log_errno_last("create pipe for", argv[0]);
+            return -1;
         }
+        fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+    }
 
-        if (result->term_signal == SIGINT) {
-            result->interrupted = true;
+    pid_t pid = 0;
+    int rc = bake_proc_spawn(argv, stdio_cfg, pipe_fds[1], &pid);
+    if (pipe_fds[1] >= 0) {
+        close(pipe_fds[1]);
+    }
+    if (rc != 0) {
+        if (pipe_fds[0] >= 0) {
+            close(pipe_fds[0]);
         }
+        return -1;
+    }
+
+    bake_proc_job_t *proc = ecs_os_calloc_t(bake_proc_job_t);
+    proc->job = job;
+    if (capture && procs->pool_count) {
+        bake_proc_buffer_t *buf = &procs->pool[--procs->pool_count];
+        proc->output = buf->data;
+        proc->output_cap = buf->cap;
     }
+    proc->pid = pid;
+    proc->out_fd = pipe_fds[0];
+    proc->pidfd = bake_proc_pidfd_open(pid);
 
+    if (proc->pidfd >= 0 && bake_procs_watch(procs, proc->pidfd, proc) != 0) {
+        close(proc->pidfd);
+        proc->pidfd = -1;
+    }
+    if (proc->out_fd >= 0) {
+        bake_procs_watch(procs, proc->out_fd, proc);
+    }
+
+    if (procs->count == procs->capacity) {
+        procs->capacity = procs->capacity ? procs->capacity * 2 : 8;
+        procs->jobs = ecs_os_realloc_n(
+            procs->jobs, bake_proc_job_t*, procs->capacity);
+    }
+    procs->jobs[procs->count++] = proc;
     return 0;
 }
 
-int bake_proc_run_argv(const char *const *argv, bake_process_result_t *result) {
-    return bake_proc_run(argv, NULL, result);
+static void bake_proc_job_read(bake_proc_job_t *proc) {
+    while (proc->out_fd >= 0) {
+        if (proc->output_cap - proc->output_len < 4096) {
+            proc->output_cap = proc->output_cap ? proc->output_cap * 2 : 8192;
+            proc->output = ecs_os_realloc_n(proc->output, char, proc->output_cap);
+        }
+
+        ssize_t n = read(proc->out_fd, proc->output + proc->output_len,
+            proc->output_cap - proc->output_len - 1);
+        if (n > 0) {
+            proc->output_len += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+
+        /* Closing the descriptor also removes it from the epoll set. */
+        close(proc->out_fd);
+        proc->out_fd = -1;
+    }
+}
+
+static void bake_proc_job_reap(bake_proc_job_t *proc, bool block) {
+    while (!proc->exited) {
+        int status = 0;
+        struct rusage rusage;
+        pid_t rc = wait4(proc->pid, &status, block ? 0 : WNOHANG, &rusage);
+        if (rc == 0) {
+            return;
+        }
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (rc == proc->pid) {
+            bake_proc_set_result(status, &rusage, &proc->result);
+        } else {
+            bake_log_errno_last("wait for command", NULL);
+            proc->result.exit_code = -1;
+        }
+        proc->exited = true;
+        if (proc->pidfd >= 0) {
+            close(proc->pidfd);
+            proc->pidfd = -1;
+        }
+    }
+}
+
+static void bake_proc_job_update(bake_proc_job_t *proc) {
+    bake_proc_job_read(proc);
+    bake_proc_job_reap(proc, false);
+}
+
+/* Waits until a job produced output or exited. With pidfds all of that is a
+ * single epoll_wait, otherwise exits are checked for periodically. */
+static void bake_procs_poll(bake_procs_t *procs) {
+    int timeout = -1;
+    int32_t out_count = 0;
+    for (int32_t i = 0; i < procs->count; i++) {
+        const bake_proc_job_t *proc = procs->jobs[i];
+        if (!proc->exited && proc->pidfd < 0) {
+            timeout = BAKE_PROCS_POLL_MS;
+        }
+        if (proc->out_fd >= 0) {
+            out_count++;
+        }
+    }
+
+#if defined(__linux__)
+    if (procs->epoll_fd >= 0) {
+        struct epoll_event events[64];
+        int n = epoll_wait(procs->epoll_fd, events, 64, timeout);
+        for (int i = 0; i < n; i++) {
+            bake_proc_job_update(events[i].data.ptr);
+        }
+        if (timeout < 0) {
+            return;
+        }
+        for (int32_t i = 0; i < procs->count; i++) {
+            if (procs->jobs[i]->pidfd < 0) {
+                bake_proc_job_update(procs->jobs[i]);
+            }
+        }
+        return;
+    }
+#endif
+
+    struct pollfd *fds = ecs_os_malloc_n(struct pollfd, out_count + 1);
+    int32_t nfds = 0;
+    for (int32_t i = 0; i < procs->count; i++) {
+        if (procs->jobs[i]->out_fd >= 0) {
+            fds[nfds].fd = procs->jobs[i]->out_fd;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            nfds++;
+        }
+    }
+    poll(fds, (nfds_t)nfds, timeout);
+    ecs_os_free(fds);
+
+    for (int32_t i = 0; i < procs->count; i++) {
+        bake_proc_job_update(procs->jobs[i]);
+    }
+}
+
+int bake_procs_wait(bake_procs_t *procs, bake_proc_done_t *done_out) {
+    if (!procs->count) {
+        return -1;
+    }
+
+    for (;;) {
+        for (int32_t i = 0; i < procs->count; i++) {
+            bake_proc_job_t *proc = procs->jobs[i];
+
+            /* Children of a terminated command can keep the pipe open, so
+             * the output of cancelled jobs is not read until EOF. */
+            if (proc->exited && proc->cancelled && proc->out_fd >= 0) {
+                close(proc->out_fd);
+                proc->out_fd = -1;
+            }
+            if (!proc->exited || proc->out_fd >= 0) {
+                continue;
+            }
+
+            done_out->job = proc->job;
+            done_out->result = proc->result;
+            done_out->cancelled = proc->cancelled;
+            done_out->output = proc->output;
+            done_out->output_len = proc->output_len;
+            done_out->output_cap = proc->output_cap;
+            if (!proc->output_len) {
+                bake_procs_release(procs, done_out);
+            } else {
+                proc->output[proc->output_len] = '\0';
+            }
+
+            procs->jobs[i] = procs->jobs[--procs->count];
+            ecs_os_free(proc);
+            return 0;
+        }
+
+        bake_procs_poll(procs);
+    }
+}
+
+void bake_procs_cancel(bake_procs_t *procs) {
+    for (int32_t i = 0; i < procs->count; i++) {
+        bake_proc_job_t *proc = procs->jobs[i];
+        if (!proc->exited && !proc->cancelled) {
+            kill(proc->pid, SIGTERM);
+            proc->cancelled = true;
+        }
+    }
+}
+
+void bake_procs_free(bake_procs_t *procs) {
+    if (!procs) {
+        return;
+    }
+
+    bake_procs_cancel(procs);
+    for (int32_t i = 0; i < procs->count; i++) {
+        bake_proc_job_t *proc = procs->jobs[i];
+        bake_proc_job_reap(proc, true);
+        if (proc->out_fd >= 0) {
+            close(proc->out_fd);
+        }
+        ecs_os_free(proc->output);
+        ecs_os_free(proc);
+    }
+
+    if (procs->epoll_fd >= 0) {
+        close(procs->epoll_fd);
+    }
+    for (int32_t i = 0; i < procs->pool_count; i++) {
+        ecs_os_free(procs->pool[i].data);
+    }
+    ecs_os_free(procs->pool);
+    ecs_os_free(procs->jobs);
+    ecs_os_free(procs);
 }
 
 #endif
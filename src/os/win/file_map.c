@@ -0,0 +1,39 @@
+#if defined(_WIN32)
+
+#include "bake/os.h"
+#include <flecs.h>
+
+/* Windows reads the file into a buffer; callers only rely on the view being
+ * read-only and not NUL-terminated. */
+int bake_file_map(const char *path, bake_file_map_t *map_out) {
+    memset(map_out, 0, sizeof(*map_out));
+
+    size_t len = 0;
+    char *data = bake_file_read(path, &len);
+    if (!data) {
+        return -1;
+    }
+
+    if (!len) {
+        ecs_os_free(data);
+        map_out->data = "";
+        return 0;
+    }
+
+    map_out->data = data;
+    map_out->len = len;
+    return 0;
+}
+
+void bake_file_unmap(bake_file_map_t *map) {
+    if (map->len) {
+        ecs_os_free((char*)map->data);
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+#endif
+
+#if !defined(_WIN32)
+typedef int bake_file_map_win_dummy_t;
+#endif
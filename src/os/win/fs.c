@@ -113,6 +113,24 @@ int bake_file_sync_mode(const char *src, const char *dst) {
     return 0;
 }
 
+/* Windows always copies: without cheap file identity checks an existing
+ * link could not be told apart from a private copy. */
+int bake_os_file_link(const char *src, const char *dst) {
+    return bake_os_file_copy(src, dst);
+}
+
+int bake_os_symlink(const char *target, const char *path) {
+    DWORD flags = SYMBOLIC_LINK_FLAG_ALLOW_UNPRIVILEGED_CREATE;
+    if (bake_path_is_dir(target)) {
+        flags |= SYMBOLIC_LINK_FLAG_DIRECTORY;
+    }
+    if (!CreateSymbolicLinkA(path, target, flags)) {
+        bake_log_win_error_last("create symlink", path);
+        return -1;
+    }
+    return 0;
+}
+
 int bake_path_is_dir(const char *path) {
     struct _stat st;
     if (_stat(path, &st) != 0) {
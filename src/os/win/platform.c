@@ -4,6 +4,8 @@
 #include <flecs.h>
 
 #include <windows.h>
+#include <io.h>
+#include <stdio.h>
 
 int bake_os_setenv(const char *name, const char *value) {
     if (!name || !name[0] || !value) {
@@ -42,6 +44,10 @@ int32_t bake_os_cpu_count(void) {
     return (int32_t)si.dwNumberOfProcessors;
 }
 
+bool bake_os_stderr_is_tty(void) {
+    return _isatty(_fileno(stderr)) != 0;
+}
+
 #endif
 
 #if !defined(_WIN32)
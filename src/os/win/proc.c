@@ -4,6 +4,7 @@
 #include <flecs.h>
 
 #include <windows.h>
+#include <psapi.h>
 
 static char* bake_proc_quote_arg(const char *arg) {
     if (!arg || !arg[0]) {
@@ -142,10 +143,13 @@ static HANDLE bake_proc_open_redirect(
     return h;
 }
 
-int bake_proc_run(
+/* Starts a process. When capture is set, stdout and stderr of the process are
+ * redirected to it. */
+static int bake_proc_start(
     const char *const *argv,
     const bake_process_stdio_t *stdio_cfg,
-    bake_process_result_t *result)
+    HANDLE capture,
+    PROCESS_INFORMATION *pi)
 {
     if (!argv || !argv[0]) {
         return -1;
@@ -157,9 +161,8 @@ int bake_proc_run(
     }
 
     STARTUPINFOA si;
-    PROCESS_INFORMATION pi;
     memset(&si, 0, sizeof(si));
-    memset(&pi, 0, sizeof(pi));
+    memset(pi, 0, sizeof(*pi));
     si.cb = sizeof(si);
 
     HANDLE std_in = NULL;
@@ -167,8 +170,8 @@ int bake_proc_run(
     HANDLE std_err = NULL;
     BOOL inherit_handles = FALSE;
 
-    if (stdio_cfg) {
-        if (stdio_cfg->stdin_path && stdio_cfg->stdin_path[0]) {
+    if (stdio_cfg || capture) {
+        if (stdio_cfg && stdio_cfg->stdin_path && stdio_cfg->stdin_path[0]) {
             std_in = bake_proc_open_redirect(stdio_cfg->stdin_path, false, false);
             if (!std_in) {
                 ecs_os_free(cmd_line);
@@ -178,21 +181,25 @@ int bake_proc_run(
             std_in = bake_proc_dup_inheritable(GetStdHandle(STD_INPUT_HANDLE));
         }
 
-        if (stdio_cfg->stdout_path && stdio_cfg->stdout_path[0]) {
+        if (capture) {
+            std_out = bake_proc_dup_inheritable(capture);
+        } else if (stdio_cfg->stdout_path && stdio_cfg->stdout_path[0]) {
             std_out = bake_proc_open_redirect(
                 stdio_cfg->stdout_path,
                 true,
                 stdio_cfg->stdout_append);
-            if (!std_out) {
-                ecs_os_free(cmd_line);
-                if (std_in) CloseHandle(std_in);
-                return -1;
-            }
         } else {
             std_out = bake_proc_dup_inheritable(GetStdHandle(STD_OUTPUT_HANDLE));
         }
+        if (!std_out && (capture ||
+            (stdio_cfg->stdout_path && stdio_cfg->stdout_path[0])))
+        {
+            ecs_os_free(cmd_line);
+            if (std_in) CloseHandle(std_in);
+            return -1;
+        }
 
-        if (stdio_cfg->stderr_to_stdout) {
+        if (capture || stdio_cfg->stderr_to_stdout) {
             std_err = bake_proc_dup_inheritable(std_out);
             if (!std_err) {
                 ecs_os_free(cmd_line);
@@ -234,7 +241,7 @@ int bake_proc_run(
         NULL,
         NULL,
         &si,
-        &pi);
+        pi);
     ecs_os_free(cmd_line);
 
     if (std_in) CloseHandle(std_in);
@@ -246,16 +253,40 @@ int bake_proc_run(
         return -1;
     }
 
-    if (WaitForSingleObject(pi.hProcess, INFINITE) != WAIT_OBJECT_0) {
-        CloseHandle(pi.hThread);
-        CloseHandle(pi.hProcess);
-        return -1;
+    return 0;
+}
+
+static int64_t bake_filetime_us(const FILETIME *ft) {
+    ULARGE_INTEGER value;
+    value.LowPart = ft->dwLowDateTime;
+    value.HighPart = ft->dwHighDateTime;
+    return (int64_t)(value.QuadPart / 10);
+}
+
+static void bake_proc_get_usage(HANDLE process, bake_process_usage_t *usage) {
+    memset(usage, 0, sizeof(*usage));
+
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(process, &created, &exited, &kernel, &user)) {
+        usage->user_us = bake_filetime_us(&user);
+        usage->sys_us = bake_filetime_us(&kernel);
+    }
+
+    PROCESS_MEMORY_COUNTERS memory;
+    if (K32GetProcessMemoryInfo(process, &memory, sizeof(memory))) {
+        usage->max_rss_kb = (int64_t)(memory.PeakWorkingSetSize / 1024);
     }
 
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(process, &io)) {
+        usage->in_blocks = (int64_t)io.ReadOperationCount;
+        usage->out_blocks = (int64_t)io.WriteOperationCount;
+    }
+}
+
+static int bake_proc_get_result(HANDLE process, bake_process_result_t *result) {
     DWORD exit_code = 0;
-    if (!GetExitCodeProcess(pi.hProcess, &exit_code)) {
-        CloseHandle(pi.hThread);
-        CloseHandle(pi.hProcess);
+    if (!GetExitCodeProcess(process, &exit_code)) {
         return -1;
     }
 
@@ -263,17 +294,268 @@ int bake_proc_run(
         result->exit_code = (int)exit_code;
         result->term_signal = 0;
         result->interrupted = exit_code == STATUS_CONTROL_C_EXIT;
+        bake_proc_get_usage(process, &result->usage);
+    }
+    return 0;
+}
+
+int bake_proc_run(
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    bake_process_result_t *result)
+{
+    PROCESS_INFORMATION pi;
+    if (bake_proc_start(argv, stdio_cfg, NULL, &pi) != 0) {
+        return -1;
+    }
+
+    int rc = -1;
+    if (WaitForSingleObject(pi.hProcess, INFINITE) == WAIT_OBJECT_0) {
+        rc = bake_proc_get_result(pi.hProcess, result);
     }
 
     CloseHandle(pi.hThread);
     CloseHandle(pi.hProcess);
-    return 0;
+    return rc;
 }
 
 int bake_proc_run_argv(const char *const *argv, bake_process_result_t *result) {
     return bake_proc_run(argv, NULL, result);
 }
 
+/* Anonymous pipes can't be waited on together with processes, so captured
+ * output is drained at this interval while jobs run. */
+#define BAKE_PROCS_POLL_MS (10)
+
+typedef struct bake_proc_buffer_t {
+    char *data;
+    size_t cap;
+} bake_proc_buffer_t;
+
+typedef struct bake_proc_job_t {
+    void *job;
+    HANDLE process;
+    HANDLE out_read;    /* read end of the capture pipe, NULL when not capturing */
+    char *output;
+    size_t output_len;
+    size_t output_cap;
+    bool cancelled;
+} bake_proc_job_t;
+
+struct bake_procs_t {
+    bake_proc_job_t **jobs;
+    int32_t count;
+    int32_t capacity;
+    bake_proc_buffer_t *pool; /* output buffers of released jobs */
+    int32_t pool_count;
+    int32_t pool_capacity;
+};
+
+static void bake_procs_pool_put(bake_procs_t *procs, char *data, size_t cap) {
+    if (!data) {
+        return;
+    }
+    if (procs->pool_count == procs->pool_capacity) {
+        procs->pool_capacity = procs->pool_capacity ? procs->pool_capacity * 2 : 8;
+        procs->pool = ecs_os_realloc_n(
+            procs->pool, bake_proc_buffer_t, procs->pool_capacity);
+    }
+    procs->pool[procs->pool_count].data = data;
+    procs->pool[procs->pool_count].cap = cap;
+    procs->pool_count++;
+}
+
+void bake_procs_release(bake_procs_t *procs, bake_proc_done_t *done) {
+    bake_procs_pool_put(procs, done->output, done->output_cap);
+    done->output = NULL;
+    done->output_len = 0;
+    done->output_cap = 0;
+}
+
+bake_procs_t* bake_procs_new(void) {
+    return ecs_os_calloc_t(bake_procs_t);
+}
+
+int32_t bake_procs_count(const bake_procs_t *procs) {
+    return procs->count;
+}
+
+int bake_procs_spawn(
+    bake_procs_t *procs,
+    const char *const *argv,
+    const bake_process_stdio_t *stdio_cfg,
+    bool capture,
+    void *job)
+{
+    HANDLE out_read = NULL;
+    HANDLE out_write = NULL;
+    if (capture && !CreatePipe(&out_read, &out_write, NULL, 0)) {
+        bake_log_win_error_last("create pipe for", argv[0]);
+        return -1;
+    }
+
+    PROCESS_INFORMATION pi;
+    int rc = bake_proc_start(argv, stdio_cfg, out_write, &pi);
+    if (out_write) {
+        CloseHandle(out_write);
+    }
+    if (rc != 0) {
+        if (out_read) {
+            CloseHandle(out_read);
+        }
+        return -1;
+    }
+    CloseHandle(pi.hThread);
+
+    bake_proc_job_t *proc = ecs_os_calloc_t(bake_proc_job_t);
+    proc->job = job;
+    if (capture && procs->pool_count) {
+        bake_proc_buffer_t *buf = &procs->pool[--procs->pool_count];
+        proc->output = buf->data;
+        proc->output_cap = buf->cap;
+    }
+    proc->process = pi.hProcess;
+    proc->out_read = out_read;
+
+    if (procs->count == procs->capacity) {
+        procs->capacity = procs->capacity ? procs->capacity * 2 : 8;
+        procs->jobs = ecs_os_realloc_n(
+            procs->jobs, bake_proc_job_t*, procs->capacity);
+    }
+    procs->jobs[procs->count++] = proc;
+    return 0;
+}
+
+/* Reads what's in the pipe without blocking, or until EOF when drain is set. */
+static void bake_proc_job_read(bake_proc_job_t *proc, bool drain) {
+    while (proc->out_read) {
+        DWORD available = 0;
+        if (!drain && (!PeekNamedPipe(
+            proc->out_read, NULL, 0, NULL, &available, NULL) || !available))
+        {
+            return;
+        }
+
+        if (proc->output_cap - proc->output_len < 4096) {
+            proc->output_cap = proc->output_cap ? proc->output_cap * 2 : 8192;
+            proc->output = ecs_os_realloc_n(proc->output, char, proc->output_cap);
+        }
+
+        DWORD n = 0;
+        if (!ReadFile(proc->out_read, proc->output + proc->output_len,
+            (DWORD)(proc->output_cap - proc->output_len - 1), &n, NULL) || !n)
+        {
+            CloseHandle(proc->out_read);
+            proc->out_read = NULL;
+            return;
+        }
+        proc->output_len += n;
+    }
+}
+
+int bake_procs_wait(bake_procs_t *procs, bake_proc_done_t *done_out) {
+    if (!procs->count) {
+        return -1;
+    }
+
+    for (;;) {
+        HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+        DWORD count = 0;
+        bool capturing = false;
+        for (int32_t i = 0; i < procs->count; i++) {
+            bake_proc_job_read(procs->jobs[i], false);
+            capturing |= procs->jobs[i]->out_read != NULL;
+            if (count < MAXIMUM_WAIT_OBJECTS) {
+                handles[count++] = procs->jobs[i]->process;
+            }
+        }
+
+        DWORD timeout = capturing || procs->count > MAXIMUM_WAIT_OBJECTS
+            ? BAKE_PROCS_POLL_MS : INFINITE;
+        DWORD rc = WaitForMultipleObjects(count, handles, FALSE, timeout);
+        if (rc == WAIT_FAILED) {
+            bake_log_win_error_last("wait for command", NULL);
+            return -1;
+        }
+
+        int32_t index = -1;
+        if (rc != WAIT_TIMEOUT) {
+            index = (int32_t)(rc - WAIT_OBJECT_0);
+        }
+        for (int32_t i = (int32_t)count; index < 0 && i < procs->count; i++) {
+            if (WaitForSingleObject(procs->jobs[i]->process, 0) == WAIT_OBJECT_0) {
+                index = i;
+            }
+        }
+        if (index < 0) {
+            continue;
+        }
+
+        /* Children of a terminated command can keep the pipe open, so the
+         * output of cancelled jobs is not drained. */
+        bake_proc_job_t *proc = procs->jobs[index];
+        if (!proc->cancelled) {
+            bake_proc_job_read(proc, true);
+        } else if (proc->out_read) {
+            CloseHandle(proc->out_read);
+            proc->out_read = NULL;
+        }
+
+        done_out->job = proc->job;
+        done_out->cancelled = proc->cancelled;
+        done_out->output = proc->output;
+        done_out->output_len = proc->output_len;
+        done_out->output_cap = proc->output_cap;
+        if (!proc->output_len) {
+            bake_procs_release(procs, done_out);
+        } else {
+            proc->output[proc->output_len] = '\0';
+        }
+        if (bake_proc_get_result(proc->process, &done_out->result) != 0) {
+            done_out->result.exit_code = -1;
+        }
+
+        CloseHandle(proc->process);
+        procs->jobs[index] = procs->jobs[--procs->count];
+        ecs_os_free(proc);
+        return 0;
+    }
+}
+
+void bake_procs_cancel(bake_procs_t *procs) {
+    for (int32_t i = 0; i < procs->count; i++) {
+        bake_proc_job_t *proc = procs->jobs[i];
+        if (!proc->cancelled) {
+            TerminateProcess(proc->process, 1);
+            proc->cancelled = true;
+        }
+    }
+}
+
+void bake_procs_free(bake_procs_t *procs) {
+    if (!procs) {
+        return;
+    }
+
+    bake_procs_cancel(procs);
+    for (int32_t i = 0; i < procs->count; i++) {
+        bake_proc_job_t *proc = procs->jobs[i];
+        WaitForSingleObject(proc->process, INFINITE);
+        CloseHandle(proc->process);
+        if (proc->out_read) {
+            CloseHandle(proc->out_read);
+        }
+        ecs_os_free(proc->output);
+        ecs_os_free(proc);
+    }
+    for (int32_t i = 0; i < procs->pool_count; i++) {
+        ecs_os_free(procs->pool[i].data);
+    }
+    ecs_os_free(procs->pool);
+    ecs_os_free(procs->jobs);
+    ecs_os_free(procs);
+}
+
 #endif
 
 #if !defined(_WIN32)
@@ -0,0 +1,81 @@
+/* Microbenchmark for bake_file_read vs bake_file_map.
+ *
+ * Usage: build/bench_file_read [file] [iterations]
+ * Defaults to deps/flecs.c. Each iteration reads the file and scans every
+ * line (counting newlines), which is what depfile parsing, content compares
+ * and amalgamation do with the result. */
+
+#include "bake/os.h"
+#include <flecs.h>
+
+#include <time.h>
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static size_t bench_count_lines(const char *data, size_t len) {
+    size_t lines = 0;
+    const char *end = data + len;
+    for (const char *p = data; (p = memchr(p, '\n', (size_t)(end - p))); p++) {
+        lines++;
+    }
+    return lines;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "deps/flecs.c";
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+    if (iterations <= 0) {
+        iterations = 200;
+    }
+
+    ecs_os_set_api_defaults();
+
+    size_t lines = 0;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        size_t len = 0;
+        char *content = bake_file_read(path, &len);
+        if (!content) {
+            fprintf(stderr, "cannot read '%s'\n", path);
+            return 1;
+        }
+        lines = bench_count_lines(content, len);
+        ecs_os_free(content);
+    }
+    double read_time = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        bake_file_map_t map;
+        if (bake_file_map(path, &map) != 0) {
+            fprintf(stderr, "cannot map '%s'\n", path);
+            return 1;
+        }
+        lines = bench_count_lines(map.data, map.len);
+        bake_file_unmap(&map);
+    }
+    double map_time = bench_now() - start;
+
+    int64_t size = bake_os_file_size(path);
+    char *content = bake_file_read(path, NULL);
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        if (!bake_file_equals(path, content, (size_t)size)) {
+            fprintf(stderr, "compare of '%s' failed\n", path);
+            return 1;
+        }
+    }
+    double equals_time = bench_now() - start;
+    ecs_os_free(content);
+
+    printf("%s: %lld bytes, %zu lines, %d iterations\n",
+        path, (long long)size, lines, iterations);
+    printf("  bake_file_read:   %8.3f ms/iter\n", read_time * 1e3 / iterations);
+    printf("  bake_file_map:    %8.3f ms/iter\n", map_time * 1e3 / iterations);
+    printf("  bake_file_equals: %8.3f ms/iter\n", equals_time * 1e3 / iterations);
+    return 0;
+}
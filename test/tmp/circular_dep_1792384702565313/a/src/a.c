@@ -0,0 +1 @@
+int a_value(void){return 1;}
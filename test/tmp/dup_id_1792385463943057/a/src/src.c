@@ -0,0 +1 @@
+int v(void){return 0;}
@@ -0,0 +1,6 @@
+void Util_teardown(void) {
+}
+
+void Util_case_1(void) {
+}
+
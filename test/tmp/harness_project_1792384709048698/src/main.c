@@ -0,0 +1,63 @@
+
+/* A friendly warning from bake.test
+ * ----------------------------------------------------------------------------
+ * This file is generated. To add/remove testcases modify the 'project.json' of
+ * the test project. ANY CHANGE TO THIS FILE IS LOST AFTER (RE)BUILDING!
+ * ----------------------------------------------------------------------------
+ */
+
+#include <bake_test.h>
+
+// Testsuite 'Math'
+void Math_add(void);
+void Math_sub(void);
+
+// Testsuite 'Util'
+void Util_teardown(void);
+void Util_case_1(void);
+
+bake_test_case Math_testcases[] = {
+    {
+        "add",
+        Math_add
+    },
+    {
+        "sub",
+        Math_sub
+    }
+};
+
+bake_test_case Util_testcases[] = {
+    {
+        "case_1",
+        Util_case_1
+    }
+};
+
+const char* Util_mode_param[] = {"fast", "slow"};
+bake_test_param Util_params[] = {
+    {"mode", (char**)Util_mode_param, 2}
+};
+
+static bake_test_suite suites[] = {
+    {
+        "Math",
+        NULL,
+        NULL,
+        2,
+        Math_testcases
+    },
+    {
+        "Util",
+        NULL,
+        Util_teardown,
+        1,
+        Util_testcases,
+        1,
+        Util_params
+    }
+};
+
+int main(int argc, char *argv[]) {
+    return bake_test_run("tmp.tests.harness.1792384709048698", argc, argv, suites, 2);
+}
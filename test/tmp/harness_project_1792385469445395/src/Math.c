@@ -0,0 +1,9 @@
+int helper_value  (void) {
+    return 42;
+}
+
+void Math_add(void){ }
+
+void Math_sub(void) {
+}
+
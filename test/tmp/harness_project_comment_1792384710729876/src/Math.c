@@ -0,0 +1,8 @@
+// void Math_add(void) { /* commented out */ }
+/* void Math_add(void) {
+    return;
+} */
+
+void Math_add(void) {
+}
+
@@ -0,0 +1,33 @@
+
+/* A friendly warning from bake.test
+ * ----------------------------------------------------------------------------
+ * This file is generated. To add/remove testcases modify the 'project.json' of
+ * the test project. ANY CHANGE TO THIS FILE IS LOST AFTER (RE)BUILDING!
+ * ----------------------------------------------------------------------------
+ */
+
+#include <bake_test.h>
+
+// Testsuite 'Math'
+void Math_add(void);
+
+bake_test_case Math_testcases[] = {
+    {
+        "add",
+        Math_add
+    }
+};
+
+static bake_test_suite suites[] = {
+    {
+        "Math",
+        NULL,
+        NULL,
+        1,
+        Math_testcases
+    }
+};
+
+int main(int argc, char *argv[]) {
+    return bake_test_run("tmp.tests.harness.empty.1792384711409211", argc, argv, suites, 1);
+}
@@ -0,0 +1,3 @@
+void Math_add(void) {
+}
+
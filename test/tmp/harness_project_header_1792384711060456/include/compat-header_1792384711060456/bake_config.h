@@ -0,0 +1,25 @@
+/*
+                                   )
+                                  (.)
+                                  .|.
+                                  | |
+                              _.--| |--._
+                           .-';  ;`-'& ; `&.
+                          \   &  ;    &   &_/
+                           |"""---...---"""|
+                           \ | | | | | | | /
+                            `---.|.|.|.---'
+
+ * This file is generated by bake.lang.c for your convenience. Headers of
+ * dependencies will automatically show up in this file. Include bake_config.h
+ * in your main project file. Do not edit! */
+
+#ifndef COMPAT_HEADER_1792384711060456_BAKE_CONFIG_H
+#define COMPAT_HEADER_1792384711060456_BAKE_CONFIG_H
+
+/* Headers of public dependencies */
+/* No dependencies */
+#include <bake_test.h>
+
+#endif
+
@@ -0,0 +1,6 @@
+#ifndef HEADER_1792384711060456_H
+#define HEADER_1792384711060456_H
+
+#include <compat-header_1792384711060456/bake_config.h>
+
+#endif
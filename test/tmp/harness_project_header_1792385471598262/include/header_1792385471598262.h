@@ -0,0 +1,6 @@
+#ifndef HEADER_1792385471598262_H
+#define HEADER_1792385471598262_H
+
+#include <compat-header_1792385471598262/bake_config.h>
+
+#endif
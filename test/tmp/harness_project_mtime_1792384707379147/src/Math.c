@@ -0,0 +1,6 @@
+void Math_add(void) {
+}
+
+void Math_sub(void) {
+}
+
@@ -0,0 +1,4 @@
+#ifndef MYHEADER_H
+#define MYHEADER_H
+static int header_value(void) { return 1; }
+#endif
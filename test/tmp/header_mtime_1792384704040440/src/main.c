@@ -0,0 +1,4 @@
+#include "myheader.h"
+int main(void) {
+    return header_value() - 1;
+}
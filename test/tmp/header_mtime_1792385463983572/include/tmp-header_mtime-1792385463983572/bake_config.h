@@ -0,0 +1,24 @@
+/*
+                                   )
+                                  (.)
+                                  .|.
+                                  | |
+                              _.--| |--._
+                           .-';  ;`-'& ; `&.
+                          \   &  ;    &   &_/
+                           |"""---...---"""|
+                           \ | | | | | | | /
+                            `---.|.|.|.---'
+
+ * This file is generated by bake.lang.c for your convenience. Headers of
+ * dependencies will automatically show up in this file. Include bake_config.h
+ * in your main project file. Do not edit! */
+
+#ifndef TMP_HEADER_MTIME_1792385463983572_BAKE_CONFIG_H
+#define TMP_HEADER_MTIME_1792385463983572_BAKE_CONFIG_H
+
+/* Headers of public dependencies */
+/* No dependencies */
+
+#endif
+
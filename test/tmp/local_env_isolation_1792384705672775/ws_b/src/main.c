@@ -0,0 +1,5 @@
+#include <app_isolated_consumer.h>
+
+int main(void) {
+    return dep_isolated_lib_value() == 42 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+/*
+                                   )
+                                  (.)
+                                  .|.
+                                  | |
+                              _.--| |--._
+                           .-';  ;`-'& ; `&.
+                          \   &  ;    &   &_/
+                           |"""---...---"""|
+                           \ | | | | | | | /
+                            `---.|.|.|.---'
+
+ * This file is generated by bake.lang.c for your convenience. Headers of
+ * dependencies will automatically show up in this file. Include bake_config.h
+ * in your main project file. Do not edit! */
+
+#ifndef DEP_ISOLATED_LIB_BAKE_CONFIG_H
+#define DEP_ISOLATED_LIB_BAKE_CONFIG_H
+
+/* Headers of public dependencies */
+/* No dependencies */
+
+/* Convenience macro for exporting symbols */
+#ifndef dep_isolated_lib_STATIC
+#if defined(dep_isolated_lib_EXPORTS) && (defined(_MSC_VER) || defined(__MINGW32__))
+  #define DEP_ISOLATED_LIB_API __declspec(dllexport)
+#elif defined(dep_isolated_lib_EXPORTS)
+  #define DEP_ISOLATED_LIB_API __attribute__((__visibility__("default")))
+#elif defined(_MSC_VER)
+  #define DEP_ISOLATED_LIB_API __declspec(dllimport)
+#else
+  #define DEP_ISOLATED_LIB_API
+#endif
+#else
+  #define DEP_ISOLATED_LIB_API
+#endif
+
+#endif
+
@@ -0,0 +1,9 @@
+#ifndef DEP_ISOLATED_LIB_H
+#define DEP_ISOLATED_LIB_H
+
+#include "dep-isolated-lib/bake_config.h"
+
+DEP_ISOLATED_LIB_API
+int dep_isolated_lib_value(void);
+
+#endif
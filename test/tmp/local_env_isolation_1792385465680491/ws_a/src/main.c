@@ -0,0 +1,5 @@
+#include <dep_isolated_lib.h>
+
+int dep_isolated_lib_value(void) {
+    return 42;
+}
@@ -0,0 +1,6 @@
+#ifndef APP_ISOLATED_CONSUMER_H
+#define APP_ISOLATED_CONSUMER_H
+
+#include "app-isolated-consumer/bake_config.h"
+
+#endif
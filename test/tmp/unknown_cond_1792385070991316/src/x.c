@@ -0,0 +1 @@
+int x_value(void){return 0;}